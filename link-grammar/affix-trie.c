@@ -0,0 +1,156 @@
+/*************************************************************************/
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+/**
+ * Tries of the affix classes that the tokenizer strips off words.
+ *
+ * suffix_split() and mprefix_split() used to compare every affix of a
+ * class with the end (or the start) of the word; for the thousands of
+ * suffixes of Russian that is thousands of comparisons per word.  The
+ * PRE, SUF and MPRE classes are now put in byte tries when the affix
+ * file is read - the suffixes reversed - so that walking the word once
+ * from its end (or its start) finds just the affixes that occur there.
+ *
+ * The matches are returned as indices into the class, in ascending
+ * order, so that the alternatives are tried, and issued, in the order
+ * of the affix file as before.
+ */
+
+#include <string.h>
+
+#include "affix-trie.h"
+#include "api-structures.h"
+#include "utilities.h"
+
+typedef struct
+{
+	int child;             /* First child, or -1 */
+	int sibling;           /* Next child of the same parent, or -1 */
+	int affix;             /* Index of an affix that ends here, or -1 */
+	unsigned char c;       /* The byte that leads here from the parent */
+} trie_node_t;
+
+struct afdict_trie_s
+{
+	trie_node_t * node;    /* node[0] is the root (the empty affix) */
+	size_t num_nodes;
+	size_t size;
+	int * next_affix;      /* Next affix with the same string, or -1 */
+	size_t num_affixes;
+	bool reversed;         /* Suffixes: the strings are walked backwards */
+};
+
+static int trie_node_new(afdict_trie_t * t, unsigned char c)
+{
+	trie_node_t * n;
+
+	if (t->num_nodes == t->size)
+	{
+		size_t oldsz = t->size;
+		t->size = 2 * oldsz + 16;
+		t->node = xrealloc(t->node, oldsz * sizeof(trie_node_t),
+		                   t->size * sizeof(trie_node_t));
+	}
+	n = &t->node[t->num_nodes];
+	n->child = n->sibling = n->affix = -1;
+	n->c = c;
+	return t->num_nodes++;
+}
+
+static int trie_child(const afdict_trie_t * t, int n, unsigned char c)
+{
+	int ch;
+	for (ch = t->node[n].child; ch >= 0; ch = t->node[ch].sibling)
+		if (t->node[ch].c == c) return ch;
+	return -1;
+}
+
+afdict_trie_t * afdict_trie_create(const Afdict_class * ac, bool reversed)
+{
+	afdict_trie_t * t;
+	size_t i;
+
+	t = (afdict_trie_t *) xalloc(sizeof(afdict_trie_t));
+	t->node = NULL;
+	t->num_nodes = t->size = 0;
+	t->reversed = reversed;
+	t->num_affixes = ac->length;
+	t->next_affix = (int *) xalloc(ac->length * sizeof(int) + 1);
+	trie_node_new(t, '\0');
+
+	/* Insert in reverse, so that the list of the affixes that end at a
+	 * node comes out in ascending order. */
+	for (i = ac->length; i > 0; i--)
+	{
+		const char * s = ac->string[i-1];
+		size_t len = strlen(s);
+		size_t k;
+		int n = 0;
+
+		for (k = 0; k < len; k++)
+		{
+			unsigned char c = s[reversed ? len-1-k : k];
+			int ch = trie_child(t, n, c);
+			if (ch < 0)
+			{
+				ch = trie_node_new(t, c);
+				t->node[ch].sibling = t->node[n].child;
+				t->node[n].child = ch;
+			}
+			n = ch;
+		}
+		t->next_affix[i-1] = t->node[n].affix;
+		t->node[n].affix = i-1;
+	}
+
+	return t;
+}
+
+void afdict_trie_delete(afdict_trie_t * t)
+{
+	if (NULL == t) return;
+	xfree(t->node, t->size * sizeof(trie_node_t));
+	xfree(t->next_affix, t->num_affixes * sizeof(int) + 1);
+	xfree(t, sizeof(afdict_trie_t));
+}
+
+/**
+ * Put in match[] the indices of the affixes that w[0..len) starts with
+ * (ends with, if the trie is reversed), the empty ones included, in
+ * ascending order.  match[] must have room for all the affixes of the
+ * class.  Returns the number of matches.
+ */
+size_t afdict_trie_match(const afdict_trie_t * t, const char * w, size_t len,
+                         int * match)
+{
+	size_t nmatch = 0;
+	size_t k = 0;
+	int n = 0;
+
+	for (;;)
+	{
+		int a;
+		for (a = t->node[n].affix; a >= 0; a = t->next_affix[a])
+		{
+			/* Insertion into the sorted matches; they are few. */
+			size_t j = nmatch++;
+			for (; (j > 0) && (match[j-1] > a); j--)
+				match[j] = match[j-1];
+			match[j] = a;
+		}
+
+		if (k == len) break;
+		n = trie_child(t, n, (unsigned char) w[t->reversed ? len-1-k : k]);
+		if (n < 0) break;
+		k++;
+	}
+
+	return nmatch;
+}
@@ -0,0 +1,22 @@
+/*************************************************************************/
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+#ifndef _AFFIX_TRIE_H_
+#define _AFFIX_TRIE_H_
+
+#include "api-types.h"
+#include "link-includes.h"
+
+afdict_trie_t * afdict_trie_create(const Afdict_class *, bool reversed);
+void afdict_trie_delete(afdict_trie_t *);
+size_t afdict_trie_match(const afdict_trie_t *, const char * w, size_t len,
+                         int * match);
+
+#endif /* _AFFIX_TRIE_H_ */
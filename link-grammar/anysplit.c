@@ -311,6 +311,7 @@ static Regex_node * regbuild(const char **regstring, int n, int classnum)
 		new_re->name    = strdup(afdict_classname[classnum]);
 		new_re->pattern = s;
 		new_re->re      = NULL;
+		new_re->matcher = NULL;
 		new_re->next    = NULL;
 		*tail = new_re;
 		tail	= &new_re->next;
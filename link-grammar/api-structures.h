@@ -56,14 +56,16 @@ struct Resources_s
 	double cumulative_time;
 	bool   memory_exhausted;
 	bool   timer_expired;
+	Timer_clock_type clock; /* What max_parse_time is measured in */
+	const volatile int * cancelled; /* Of the sentence being parsed */
 };
 
 struct Parse_Options_s
 {
 	/* General options */
 	int verbosity;         /* Level of detail to give about the computation 0 */
-	char * debug;          /* comma-sparated function names to debug "" */
-	char * test;           /* comma-sparated features to test "" */
+	char debug[256];       /* comma-sparated function names to debug "" */
+	char test[256];        /* comma-sparated features to test "" */
 	Resources resources;   /* For deciding when to abort the parsing */
 
 	/* Options governing the tokenizer (sentence-splitter) */
@@ -85,6 +87,8 @@ struct Parse_Options_s
 	                        * no longer than this.  Default = 6 */
 	bool all_short;        /* If true, there can be no connectors that are exempt */
 	bool repeatable_rand;  /* Reset rand number gen after every parse. */
+	int count_threads;     /* Threads for counting the parses of long
+	                        * sentences; 0 = one per processor. Default 1 */
 
 	/* Options governing post-processing */
 	size_t twopass_length; /* min sent length for two-pass post processing */
@@ -92,7 +96,23 @@ struct Parse_Options_s
 
 	/* Options governing the generation of linkages. */
 	size_t linkage_limit;  /* The maximum number of linkages processed 100 */
+	bool best_first;       /* Beyond linkage_limit, process the cheapest
+	                          linkages, not a random subset (default=FALSE) */
 	bool display_morphology;/* if true, print morpho analysis of words */
+
+	/* Scratch state kept from one sentence to the next */
+	Parse_Workspace workspace; /* NULL: allocate and free per sentence */
+};
+
+/* Default upper bound on the memory kept by a Parse_Workspace. */
+#define PARSE_WORKSPACE_DEFAULT_MAX_MEMORY (64 * 1024 * 1024)
+
+struct Parse_Workspace_s
+{
+	fast_matcher_t * fast_matcher;
+	count_context_t * count_context;
+	Parse_info parse_info;
+	size_t max_memory;     /* Above this, free it all after a sentence */
 };
 
 struct Connector_set_s
@@ -106,8 +126,11 @@ struct Afdict_class_struct
 	size_t mem_elems;     /* number of memory elements allocated */
 	size_t length;        /* number of strings */
 	char const ** string;
+	afdict_trie_t * trie;  /* PRE, SUF (reversed) and MPRE only */
 };
 
+#define IDIOM_LINK_SZ 9
+
 struct Dictionary_s
 {
 	Dict_node *     root;
@@ -147,9 +170,15 @@ struct Dictionary_s
 	pp_knowledge  * base_knowledge;    /* Core post-processing rules */
 	pp_knowledge  * hpsg_knowledge;    /* Head-Phrase Structure rules */
 	Connector_set * unlimited_connector_set; /* NULL=everthing is unlimited */
+	condesc_table_t * condesc_table;   /* NULL=match connectors by name */
+	disjunct_cache_t * disjunct_cache; /* NULL=disjuncts are not cached */
+	parse_cache_t * parse_cache;       /* NULL=parses are not cached */
 	String_set *    string_set;   /* Set of link names in the dictionary */
 	int             num_entries;
 	Word_file *     word_file_header;
+	Word_file *     include_file_header; /* The #include'd files */
+	dict_binary_t * binary;       /* NULL=read from the text files */
+	dict_index_t *  index;        /* NULL=look words up in the tree */
 
 	/* exp_list links together all the Exp structs that are allocated
 	 * in reading this dictionary.  Needed for freeing the dictionary
@@ -166,6 +195,7 @@ struct Dictionary_s
 	bool            is_special;
 	char            already_got_it;
 	int             line_number;
+	char            current_idiom[IDIOM_LINK_SZ];
 };
 
 struct Label_node_s
@@ -198,8 +228,17 @@ struct Parse_info_struct
 	Parse_set *    parse_set;
 	int            N_words;
 
+	/* The table entries, sets and choices, and the k-best lists */
+	Pool_desc *    X_table_connector_pool;
+	Pool_desc *    Parse_set_pool;
+	Pool_desc *    Parse_choice_pool;
+	Parse_kbest *  kbest_list;
+
 	/* thread-safe random number state */
 	unsigned int rand_state;
+
+	/* If true, the index of a linkage is its rank in cost order. */
+	bool best_first;
 };
 
 
@@ -225,6 +264,10 @@ struct Sentence_s
 	size_t num_valid_linkages;  /* Number with no pp violations */
 	size_t null_count;          /* Number of null links in linkages */
 	Parse_info     parse_info;  /* Set of parses for the sentence */
+	void * disjunct_block;      /* The packed disjuncts and connectors */
+	size_t disjunct_block_size;
+	Pool_desc * Disjunct_pool;  /* The disjuncts and connectors being */
+	Pool_desc * Connector_pool; /* built and pruned, before packing */
 	Linkage        lnkages;     /* Sorted array of valid & invalid linkages */
 	Postprocessor * postprocessor;
 	Postprocessor * constituent_pp;
@@ -237,6 +280,8 @@ struct Sentence_s
 	/* thread-safe random number state */
 	unsigned int rand_state;
 
+	volatile int cancelled;     /* Set by sentence_cancel() */
+
 #ifdef USE_SAT_SOLVER
 	/* Hook for the SAT solver */
 	void *hook;
@@ -44,14 +44,23 @@ typedef struct Regex_node_s Regex_node;
 typedef struct Resources_s * Resources;
 
 /* Some of the more obscure typedefs */
+typedef struct afdict_trie_s afdict_trie_t;
+typedef struct condesc_struct condesc_t;
+typedef struct condesc_table_s condesc_table_t;
 typedef struct count_context_s count_context_t;
+typedef struct dict_binary_s dict_binary_t;
+typedef struct dict_index_s dict_index_t;
+typedef struct disjunct_cache_s disjunct_cache_t;
 typedef struct fast_matcher_s fast_matcher_t;
+typedef struct parse_cache_s parse_cache_t;
 
 typedef struct Connector_set_s Connector_set;
 typedef struct Disjunct_struct Disjunct;
 typedef struct Link_s Link;
 typedef struct List_o_links_struct List_o_links;
+typedef struct Parse_kbest_struct Parse_kbest;
 typedef struct Parse_set_struct Parse_set;
+typedef struct Pool_desc_s Pool_desc;
 typedef struct String_set_s String_set;
 typedef struct Afdict_class_struct Afdict_class;
 typedef struct Word_struct Word;
@@ -26,6 +26,8 @@
 #include "extract-links.h"
 #include "fast-match.h"
 #include "linkage.h"
+#include "memory-pool.h"
+#include "parse-cache.h"
 #include "post-process.h"
 #include "preparation.h"
 #include "print.h"
@@ -102,8 +104,8 @@ Parse_Options parse_options_create(void)
 
 	/* Here's where the values are initialized */
 	po->verbosity = 1;
-	po->debug = (char *)"";
-	po->test = (char *)"";
+	po->debug[0] = '\0';
+	po->test[0] = '\0';
 	po->linkage_limit = 100;
 
 	/* A cost of 2.7 allows the usual cost-2 connectors, plus the
@@ -133,15 +135,21 @@ Parse_Options parse_options_create(void)
 	po->all_short = false;
 	po->twopass_length = 30;
 	po->repeatable_rand = true;
+	po->count_threads = 1;
+	po->best_first = false;
 	po->resources = resources_create();
 	po->use_cluster_disjuncts = false;
 	po->display_morphology = false;
+	po->workspace = NULL;
 
 	return po;
 }
 
 int parse_options_delete(Parse_Options  opts)
 {
+	/* Don't leave the globals pointing into the deleted options */
+	if (debug == opts->debug) debug = (char *)"";
+	if (test == opts->test) test = (char *)"";
 	resources_delete(opts->resources);
 	xfree(opts, sizeof(struct Parse_Options_s));
 	return 0;
@@ -176,7 +184,6 @@ void parse_options_set_verbosity(Parse_Options opts, int dummy)
 {
 	opts->verbosity = dummy;
 	verbosity = opts->verbosity;
-	/* this is one of the only global variables. */
 }
 
 int parse_options_get_verbosity(Parse_Options opts) {
@@ -185,10 +192,10 @@ int parse_options_get_verbosity(Parse_Options opts) {
 
 void parse_options_set_debug(Parse_Options opts, const char * dummy)
 {
-	/* The comma-separated list of functions is limited to this size.
-	 * Can be easily dynamically allocated. In any case it is not reentrant
-	 * because the "debug" variable is static. */
-	static char buff[256];
+	/* The comma-separated list of functions is limited to the size of
+	 * opts->debug. */
+	char * buff = opts->debug;
+	const size_t buffsz = sizeof(opts->debug);
 	size_t len = strlen(dummy);
 
 	if (0 == strcmp(dummy, opts->debug)) return;
@@ -200,20 +207,18 @@ void parse_options_set_debug(Parse_Options opts, const char * dummy)
 	else
 	{
 		buff[0] = ',';
-		strncpy(buff+1, dummy, sizeof(buff)-2);
-		if (len < sizeof(buff)-2)
+		strncpy(buff+1, dummy, buffsz-2);
+		if (len < buffsz-2)
 		{
 			buff[len+1] = ',';
 			buff[len+2] = '\0';
 		}
 		else
 		{
-			buff[sizeof(buff)-1] = '\0';
+			buff[buffsz-1] = '\0';
 		}
 	}
-	opts->debug = buff;
 	debug = opts->debug;
-	/* this is one of the only global variables. */
 }
 
 char * parse_options_get_debug(Parse_Options opts) {
@@ -222,10 +227,10 @@ char * parse_options_get_debug(Parse_Options opts) {
 
 void parse_options_set_test(Parse_Options opts, const char * dummy)
 {
-	/* The comma-separated test features is limited to this size.
-	 * Can be easily dynamically allocated. In any case it is not reentrant
-	 * because the "test" variable is static. */
-	static char buff[256];
+	/* The comma-separated test features is limited to the size of
+	 * opts->test. */
+	char * buff = opts->test;
+	const size_t buffsz = sizeof(opts->test);
 	size_t len = strlen(dummy);
 
 	if (0 == strcmp(dummy, opts->test)) return;
@@ -237,20 +242,18 @@ void parse_options_set_test(Parse_Options opts, const char * dummy)
 	else
 	{
 		buff[0] = ',';
-		strncpy(buff+1, dummy, sizeof(buff)-2);
-		if (len < sizeof(buff)-2)
+		strncpy(buff+1, dummy, buffsz-2);
+		if (len < buffsz-2)
 		{
 			buff[len+1] = ',';
 			buff[len+2] = '\0';
 		}
 		else
 		{
-			buff[sizeof(buff)-1] = '\0';
+			buff[buffsz-1] = '\0';
 		}
 	}
-	opts->test = buff;
 	test = opts->test;
-	/* this is one of the only global variables. */
 }
 
 char * parse_options_get_test(Parse_Options opts) {
@@ -350,6 +353,32 @@ bool parse_options_get_repeatable_rand(Parse_Options opts) {
 	return opts->repeatable_rand;
 }
 
+/**
+ * When a sentence has more linkages than the linkage limit, process
+ * the linkage_limit cheapest of them, in the order of the disjunct
+ * and link costs, instead of a random subset.
+ */
+void parse_options_set_best_first(Parse_Options opts, bool val) {
+	opts->best_first = val;
+}
+
+bool parse_options_get_best_first(Parse_Options opts) {
+	return opts->best_first;
+}
+
+/**
+ * Count the parses of long sentences on this many threads (one per
+ * processor if 0 or less).  The counts are the same as with one
+ * thread.  Has effect only if the library was built with pthreads.
+ */
+void parse_options_set_count_threads(Parse_Options opts, int val) {
+	opts->count_threads = val;
+}
+
+int parse_options_get_count_threads(Parse_Options opts) {
+	return opts->count_threads;
+}
+
 void parse_options_set_max_parse_time(Parse_Options opts, int dummy) {
 	opts->resources->max_parse_time = dummy;
 }
@@ -358,6 +387,14 @@ int parse_options_get_max_parse_time(Parse_Options opts) {
 	return opts->resources->max_parse_time;
 }
 
+void parse_options_set_timer_clock(Parse_Options opts, Timer_clock_type clock) {
+	resources_set_clock(opts->resources, clock);
+}
+
+Timer_clock_type parse_options_get_timer_clock(Parse_Options opts) {
+	return opts->resources->clock;
+}
+
 void parse_options_set_max_memory(Parse_Options opts, int dummy) {
 	opts->resources->max_memory = dummy;
 }
@@ -391,13 +428,80 @@ bool parse_options_memory_exhausted(Parse_Options opts) {
 }
 
 bool parse_options_resources_exhausted(Parse_Options opts) {
-	return (resources_timer_expired(opts->resources) || resources_memory_exhausted(opts->resources));
+	return (resources_timer_expired(opts->resources) ||
+	        resources_memory_exhausted(opts->resources) ||
+	        resources_cancelled(opts->resources));
 }
 
 void parse_options_reset_resources(Parse_Options opts) {
 	resources_reset(opts->resources);
 }
 
+void parse_options_set_workspace(Parse_Options opts, Parse_Workspace ws) {
+	opts->workspace = ws;
+}
+
+Parse_Workspace parse_options_get_workspace(Parse_Options opts) {
+	return opts->workspace;
+}
+
+/***************************************************************
+*
+* Routines for parse workspaces
+*
+****************************************************************/
+
+Parse_Workspace parse_workspace_create(void)
+{
+	Parse_Workspace ws;
+
+	ws = (Parse_Workspace) xalloc(sizeof(struct Parse_Workspace_s));
+	ws->fast_matcher = NULL;
+	ws->count_context = NULL;
+	ws->parse_info = NULL;
+	ws->max_memory = PARSE_WORKSPACE_DEFAULT_MAX_MEMORY;
+	return ws;
+}
+
+/** Free the buffers; they are allocated again by the next parse */
+static void parse_workspace_trim(Parse_Workspace ws)
+{
+	if (ws->fast_matcher) free_fast_matcher(ws->fast_matcher);
+	if (ws->count_context) free_count_context(ws->count_context);
+	free_parse_info(ws->parse_info);
+	ws->fast_matcher = NULL;
+	ws->count_context = NULL;
+	ws->parse_info = NULL;
+}
+
+void parse_workspace_delete(Parse_Workspace ws)
+{
+	if (NULL == ws) return;
+	parse_workspace_trim(ws);
+	xfree(ws, sizeof(struct Parse_Workspace_s));
+}
+
+void parse_workspace_set_max_memory(Parse_Workspace ws, size_t max_memory)
+{
+	ws->max_memory = max_memory;
+}
+
+size_t parse_workspace_get_max_memory(Parse_Workspace ws)
+{
+	return ws->max_memory;
+}
+
+static size_t parse_workspace_memory(Parse_Workspace ws)
+{
+	size_t bytes = 0;
+
+	if (ws->fast_matcher) bytes += fast_matcher_memory(ws->fast_matcher);
+	if (ws->count_context) bytes += count_context_memory(ws->count_context);
+	if (ws->parse_info)
+		bytes += ws->parse_info->x_table_size * sizeof(X_table_connector *);
+	return bytes;
+}
+
 /***************************************************************
 *
 * Routines for postprocessing
@@ -448,16 +552,28 @@ static void select_linkages(Sentence sent, fast_matcher_t* mchxt,
 {
 	size_t in;
 	size_t N_linkages_found, N_linkages_alloced;
+	bool best_first;
+	bool overflowed;
 
-	bool overflowed = build_parse_set(sent, mchxt, ctxt, sent->null_count, opts);
+	/* The linkages of a previous parse, or null count, are replaced. */
+	free_linkages(sent);
+	sent->lnkages = NULL;
+	sent->num_linkages_alloced = 0;
+
+	overflowed = build_parse_set(sent, mchxt, ctxt, sent->null_count, opts);
 	print_time(opts, "Built parse set");
 
+	/* The parse set of a cancelled sentence is incomplete. */
+	if (resources_cancelled(opts->resources))
+		sent->num_linkages_found = 0;
+
 	if (overflowed && (1 < opts->verbosity))
 	{
 		err_ctxt ec;
 		ec.sent = sent;
 		err_msg(&ec, Warn, "Warning: Count overflow.\n"
-		  "Considering a random subset of %zu of an unknown and large number of linkages\n",
+		  "Considering %s %zu of an unknown and large number of linkages\n",
+			opts->best_first ? "the cheapest" : "a random subset of",
 			opts->linkage_limit);
 	}
 	N_linkages_found = sent->num_linkages_found;
@@ -471,15 +587,18 @@ static void select_linkages(Sentence sent, fast_matcher_t* mchxt,
 		return;
 	}
 
+	best_first = false;
 	if (N_linkages_found > opts->linkage_limit)
 	{
 		N_linkages_alloced = opts->linkage_limit;
+		best_first = opts->best_first;
 		if (opts->verbosity > 1)
 		{
 			err_ctxt ec;
 			ec.sent = sent;
 			err_msg(&ec, Warn,
-			    "Warning: Considering a random subset of %zu of %zu linkages\n",
+			    "Warning: Considering %s %zu of %zu linkages\n",
+			    best_first ? "the cheapest" : "a random subset of",
 			    N_linkages_alloced, N_linkages_found);
 		}
 	}
@@ -488,11 +607,23 @@ static void select_linkages(Sentence sent, fast_matcher_t* mchxt,
 		N_linkages_alloced = N_linkages_found;
 	}
 
+	/* Find the cheapest linkages in the parse set, instead of
+	 * sampling it. Their number is exact even if the count overflowed. */
+	if (best_first)
+		N_linkages_alloced =
+			find_best_linkages(sent->parse_info, N_linkages_alloced);
+
 	/* Now actually malloc the array in which we will process linkages. */
 	sent->lnkages = linkage_array_new(N_linkages_alloced);
 
 	/* Generate an array of linkage indices to examine */
-	if (overflowed)
+	if (best_first)
+	{
+		/* The index is the rank in cost order. */
+		for (in=0; in < N_linkages_alloced; in++)
+			sent->lnkages[in].lifo.index = in;
+	}
+	else if (overflowed)
 	{
 		/* The negative index means that a random subset of links
 		 * will be picked later on, in extract_links(). */
@@ -679,8 +810,8 @@ static void sort_linkages(Sentence sent, Parse_Options opts)
 *
 ****************************************************************/
 
-/* Its OK if this is racey across threads.  Any mild shuffling is enough. */
-static unsigned int global_rand_state;
+/* Any mild shuffling is enough; each thread has its own. */
+static TLS unsigned int global_rand_state;
 
 Sentence sentence_create(const char *input_string, Dictionary dict)
 {
@@ -701,6 +832,10 @@ Sentence sentence_create(const char *input_string, Dictionary dict)
 	sent->parse_info = NULL;
 	sent->string_set = string_set_create();
 	sent->rand_state = global_rand_state;
+	sent->Disjunct_pool =
+		pool_new("Disjunct", sizeof(Disjunct), DISJUNCT_POOL_BLOCK);
+	sent->Connector_pool =
+		pool_new("Connector", sizeof(Connector), CONNECTOR_POOL_BLOCK);
 
 	sent->postprocessor = post_process_new(dict->base_knowledge);
 	sent->constituent_pp = post_process_new(dict->hpsg_knowledge);
@@ -718,10 +853,23 @@ Sentence sentence_create(const char *input_string, Dictionary dict)
 	return sent;
 }
 
+/**
+ * Make the options visible to the code that has no access to them,
+ * via the (thread-local) globals.
+ */
+static void set_global_options(Parse_Options opts)
+{
+	verbosity = opts->verbosity;
+	debug = opts->debug;
+	test = opts->test;
+}
+
 int sentence_split(Sentence sent, Parse_Options opts)
 {
 	Dictionary dict = sent->dict;
 
+	set_global_options(opts);
+
 	/* Cleanup stuff previously allocated. This is because some free
 	 * routines depend on sent-length, which might change in different
 	 * parse-opts settings.
@@ -752,10 +900,11 @@ int sentence_split(Sentence sent, Parse_Options opts)
 static void free_sentence_words(Sentence sent)
 {
 	size_t i;
+
+	free_sentence_disjuncts(sent);
 	for (i = 0; i < sent->length; i++)
 	{
 		free_X_nodes(sent->word[i].x);
-		free_disjuncts(sent->word[i].d);
 		free(sent->word[i].alternatives);
 	}
 	free((void *) sent->word);
@@ -768,6 +917,8 @@ void sentence_delete(Sentence sent)
 	if (!sent) return;
 	sat_sentence_delete(sent);
 	free_sentence_words(sent);
+	pool_delete(sent->Disjunct_pool);
+	pool_delete(sent->Connector_pool);
 	string_set_delete(sent->string_set);
 	free_parse_info(sent->parse_info);
 	free_linkages(sent);
@@ -1151,27 +1302,77 @@ static void sane_morphism(Sentence sent, Parse_Options opts)
 	}
 }
 
+/**
+ * Go on from a parse without null links to parses with null links:
+ * restore the disjuncts that were pruned only because null links were
+ * not allowed, and forget what the parse without them has memoized
+ * about the spans that have changed.  The rest of the memo is kept.
+ */
+static void relax_pruning(Sentence sent, Parse_Options opts,
+                          fast_matcher_t *mchxt, count_context_t *ctxt)
+{
+	bool *changed = (bool *) xalloc(sent->length * sizeof(bool));
+
+	if (relax_null_pruning(sent, opts, changed))
+	{
+		reset_fast_matcher(mchxt, sent);
+		update_count_context(ctxt, sent, changed);
+		reset_parse_info(sent->parse_info, sent->length);
+	}
+	xfree(changed, sent->length * sizeof(bool));
+	print_time(opts, "Restored the disjuncts for null links");
+}
+
 /** Misnamed, this has nothing to do with chart parsing */
 static void chart_parse(Sentence sent, Parse_Options opts)
 {
 	int nl;
 	fast_matcher_t * mchxt;
 	count_context_t * ctxt;
+	Parse_Workspace ws = opts->workspace;
+	bool pruned_for_no_nulls = (0 == opts->min_null_count);
 
-	/* Build lists of disjuncts */
+	/* Build lists of disjuncts.  If the parse starts without null
+	 * links, they are pruned for that, which is much harder; if it
+	 * has to go on with null links, the disjuncts that are needed for
+	 * them only are restored then. */
 	prepare_to_parse(sent, opts);
 	if (resources_exhausted(opts->resources)) return;
 
-	mchxt = alloc_fast_matcher(sent);
-	ctxt = alloc_count_context(sent->length);
-	print_time(opts, "Initialized fast matcher");
-	if (resources_exhausted(opts->resources)) return;
-
 	/* A parse set may have been already been built for this sentence,
 	 * if it was previously parsed.  If so we free it up before
 	 * building another.  Huh ?? How could that happen? */
 	free_parse_info(sent->parse_info);
-	sent->parse_info = parse_info_new(sent->length);
+	sent->parse_info = NULL;
+
+	if (NULL == ws)
+	{
+		mchxt = alloc_fast_matcher(sent);
+		ctxt = alloc_count_context(sent);
+		sent->parse_info = parse_info_new(sent->length);
+	}
+	else
+	{
+		/* Take the buffers of the workspace, and clear them. */
+		if (ws->fast_matcher)
+			reset_fast_matcher(ws->fast_matcher, sent);
+		else
+			ws->fast_matcher = alloc_fast_matcher(sent);
+		if (ws->count_context)
+			reset_count_context(ws->count_context, sent);
+		else
+			ws->count_context = alloc_count_context(sent);
+		if (ws->parse_info)
+			reset_parse_info(ws->parse_info, sent->length);
+		else
+			ws->parse_info = parse_info_new(sent->length);
+
+		mchxt = ws->fast_matcher;
+		ctxt = ws->count_context;
+		sent->parse_info = ws->parse_info;
+	}
+	print_time(opts, "Initialized fast matcher");
+	if (resources_exhausted(opts->resources)) goto done;
 
 	for (nl = opts->min_null_count; nl <= opts->max_null_count ; ++nl)
 	{
@@ -1180,6 +1381,13 @@ static void chart_parse(Sentence sent, Parse_Options opts)
 		sent->null_count = nl;
 		total = do_parse(sent, mchxt, ctxt, sent->null_count, opts);
 
+		/* Unlike a timeout, a cancellation ignores the partial counts. */
+		if (resources_cancelled(opts->resources))
+		{
+			sent->num_linkages_found = 0;
+			break;
+		}
+
 		if (verbosity > 1)
 		{
 			prt_error("Info: Total count with %zu null links:   %lld\n",
@@ -1203,30 +1411,35 @@ static void chart_parse(Sentence sent, Parse_Options opts)
 		/* If we are here, then no valid linakges were found.
 		 * If there was a parse overflow, give up now. */
 		if (PARSE_NUM_OVERFLOW < total) break;
-	}
-
-	free_count_context(ctxt);
-	free_fast_matcher(mchxt);
-}
 
-static void free_sentence_disjuncts(Sentence sent)
-{
-	size_t i;
+		if (pruned_for_no_nulls && (nl < opts->max_null_count))
+		{
+			relax_pruning(sent, opts, mchxt, ctxt);
+			pruned_for_no_nulls = false;
+		}
+	}
 
-	for (i = 0; i < sent->length; ++i)
+done:
+	if (NULL == ws)
 	{
-		free_disjuncts(sent->word[i].d);
-		sent->word[i].d = NULL;
+		free_count_context(ctxt);
+		free_fast_matcher(mchxt);
+		return;
 	}
+
+	/* The linkages have all been extracted, so the parse info is not
+	 * needed anymore; give it back to the workspace, emptied. */
+	reset_parse_info(ws->parse_info, sent->length);
+	sent->parse_info = NULL;
+	if (parse_workspace_memory(ws) > ws->max_memory)
+		parse_workspace_trim(ws);
 }
 
 int sentence_parse(Sentence sent, Parse_Options opts)
 {
 	int rc;
 
-	verbosity = opts->verbosity;
-	debug = opts->debug;
-	test = opts->test;
+	set_global_options(opts);
 
 	sent->num_valid_linkages = 0;
 
@@ -1252,8 +1465,29 @@ int sentence_parse(Sentence sent, Parse_Options opts)
 	free_sentence_disjuncts(sent);  /* Is this really needed ??? */
 	resources_reset_space(opts->resources);
 
+	/* The same sentence may have been parsed before, with the same
+	 * options.  Its previous linkages, if any, are replaced. */
+	if ((NULL != sent->dict->parse_cache) &&
+	    (0 < parse_cache_get_size(sent->dict->parse_cache)))
+	{
+		free_linkages(sent);
+		sent->lnkages = NULL;
+		sent->num_linkages_alloced = 0;
+		sent->num_linkages_post_processed = 0;
+		if (parse_cache_get(sent->dict->parse_cache, sent, opts))
+		{
+			print_time(opts, "Found in the parse cache");
+			return sent->num_valid_linkages;
+		}
+	}
+
+	/* Let sentence_cancel() reach the checks made during the parse. */
+	opts->resources->cancelled = &sent->cancelled;
 	if (resources_exhausted(opts->resources))
+	{
+		opts->resources->cancelled = NULL;
 		return 0;
+	}
 
 	/* Expressions were previously set up during the tokenize stage. */
 	expression_prune(sent);
@@ -1267,6 +1501,10 @@ int sentence_parse(Sentence sent, Parse_Options opts)
 		chart_parse(sent, opts);
 	}
 	print_time(opts, "Finished parse");
+	opts->resources->cancelled = NULL;
+
+	if (NULL != sent->dict->parse_cache)
+		parse_cache_put(sent->dict->parse_cache, sent, opts);
 
 	if ((verbosity > 0) &&
 	   (PARSE_NUM_OVERFLOW < sent->num_linkages_found))
@@ -1279,3 +1517,8 @@ int sentence_parse(Sentence sent, Parse_Options opts)
 	return sent->num_valid_linkages;
 }
 
+void sentence_cancel(Sentence sent)
+{
+	flag_set(&sent->cancelled);
+}
+
@@ -0,0 +1,203 @@
+/*************************************************************************/
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+/**
+ * Parsing a batch of sentences on a pool of worker threads.
+ *
+ * The workers share the dictionary, and take the sentences one at a
+ * time, in input order, from a common counter.  Each worker has its
+ * own copy of the parse options, with its own resources and its own
+ * workspace, so that the parser's buffers are not allocated and freed
+ * over and over again.
+ *
+ * The parsed sentences are returned to the caller, which extracts the
+ * linkages and deletes them as usual.  The string sets and the
+ * post-processors belong to the sentences, and so are not reused.
+ */
+
+#include <string.h>
+#include <time.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "api-structures.h"
+#include "externs.h"
+#include "resources.h"
+#include "utilities.h"
+
+typedef struct
+{
+	Dictionary dict;
+	const char * const * input;
+	size_t num_sentences;
+	Parse_Options opts;
+	Sentence * result;
+	time_t deadline;           /* (time_t)-1 if there is none */
+	size_t next;               /* The next sentence to parse */
+	size_t num_parsed;
+#ifdef USE_PTHREADS
+	pthread_mutex_t lock;
+#endif
+} batch_t;
+
+/** Take the index of the next sentence, or num_sentences if none is left */
+static size_t next_sentence(batch_t *b)
+{
+	size_t i;
+
+#ifdef USE_PTHREADS
+	pthread_mutex_lock(&b->lock);
+#endif
+	i = b->next;
+	if (i < b->num_sentences) b->next++;
+#ifdef USE_PTHREADS
+	pthread_mutex_unlock(&b->lock);
+#endif
+	return i;
+}
+
+static void sentence_done(batch_t *b)
+{
+#ifdef USE_PTHREADS
+	pthread_mutex_lock(&b->lock);
+#endif
+	b->num_parsed++;
+#ifdef USE_PTHREADS
+	pthread_mutex_unlock(&b->lock);
+#endif
+}
+
+static void * batch_worker(void *arg)
+{
+	batch_t *b = (batch_t *) arg;
+	struct Parse_Options_s opts = *b->opts;
+	int max_parse_time = b->opts->resources->max_parse_time;
+	size_t i;
+
+	opts.resources = resources_create();
+	opts.resources->max_memory = b->opts->resources->max_memory;
+	resources_set_clock(opts.resources, b->opts->resources->clock);
+	opts.workspace = parse_workspace_create();
+	if (b->opts->workspace)
+		opts.workspace->max_memory = b->opts->workspace->max_memory;
+
+	while ((i = next_sentence(b)) < b->num_sentences)
+	{
+		Sentence sent;
+
+		/* Don't let a single sentence run past the batch deadline. */
+		opts.resources->max_parse_time = max_parse_time;
+		if ((time_t)-1 != b->deadline)
+		{
+			int remaining = (int) difftime(b->deadline, time(NULL));
+			if (remaining <= 0) break;
+			if ((0 > max_parse_time) || (remaining < max_parse_time))
+				opts.resources->max_parse_time = remaining;
+		}
+
+		resources_reset(opts.resources);
+
+		sent = sentence_create(b->input[i], b->dict);
+		if (NULL == sent) continue;
+		if (0 > sentence_parse(sent, &opts))
+		{
+			sentence_delete(sent);
+			continue;
+		}
+		b->result[i] = sent;
+		sentence_done(b);
+	}
+
+	/* Don't leave the globals pointing into the local options */
+	if (debug == opts.debug) debug = (char *)"";
+	if (test == opts.test) test = (char *)"";
+	parse_workspace_delete(opts.workspace);
+	resources_delete(opts.resources);
+	return NULL;
+}
+
+#ifdef USE_PTHREADS
+static int default_num_threads(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	if (0 < n) return (int) n;
+#endif
+	return 1;
+}
+#endif
+
+/**
+ * Parse the num_sentences input strings with the given options, on
+ * num_threads worker threads (the number of processors if 0 or less).
+ * result[i] is set to the parsed Sentence of input[i], or to NULL if
+ * the sentence could not be parsed, or if the batch ran out of time
+ * before getting to it.  The parsed sentences must be deleted with
+ * sentence_delete().  If max_batch_time is positive, no sentence is
+ * started after that many seconds, and the parse time of each sentence
+ * is limited to what remains of it.  Returns the number of sentences
+ * that were parsed.
+ */
+int sentence_parse_batch(Dictionary dict, const char * const * input,
+                         size_t num_sentences, Parse_Options opts,
+                         int num_threads, int max_batch_time,
+                         Sentence * result)
+{
+	batch_t b;
+
+	memset(result, 0, num_sentences * sizeof(Sentence));
+	if (0 == num_sentences) return 0;
+
+	b.dict = dict;
+	b.input = input;
+	b.num_sentences = num_sentences;
+	b.opts = opts;
+	b.result = result;
+	b.deadline = (0 < max_batch_time) ? time(NULL) + max_batch_time : (time_t)-1;
+	b.next = 0;
+	b.num_parsed = 0;
+
+#ifdef USE_PTHREADS
+	if (0 >= num_threads) num_threads = default_num_threads();
+	if ((size_t) num_threads > num_sentences) num_threads = (int) num_sentences;
+
+	pthread_mutex_init(&b.lock, NULL);
+	if (1 < num_threads)
+	{
+		pthread_t * tid = (pthread_t *) xalloc(num_threads * sizeof(pthread_t));
+		int i, started = 0;
+
+		for (i = 0; i < num_threads; i++)
+		{
+			if (0 != pthread_create(&tid[started], NULL, batch_worker, &b))
+			{
+				prt_error("Warning: Could only start %d parse threads\n", started);
+				break;
+			}
+			started++;
+		}
+		/* If no thread could be started, parse in this one. */
+		if (0 == started) batch_worker(&b);
+		for (i = 0; i < started; i++) pthread_join(tid[i], NULL);
+		xfree(tid, num_threads * sizeof(pthread_t));
+	}
+	else
+	{
+		batch_worker(&b);
+	}
+	pthread_mutex_destroy(&b.lock);
+#else
+	batch_worker(&b);
+#endif /* USE_PTHREADS */
+
+	return (int) b.num_parsed;
+}
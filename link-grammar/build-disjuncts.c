@@ -15,10 +15,13 @@
 
 #include <math.h>
 #include "api-structures.h"
+#include "condesc.h"
 #include "build-disjuncts.h"
 #include "dict-api.h"
 #include "dict-common.h"
+#include "disjunct-cache.h"
 #include "disjunct-utils.h"
+#include "dict-file/dict-index.h"
 #include "externs.h"
 #include "word-utils.h"
 #include "utilities.h" /* For Win32 compatibility features */
@@ -335,14 +338,14 @@ GNUC_UNUSED static void print_disjunct_list(Disjunct * c)
  * in the list pointed to by e.  Keep only those whose strings whose
  * direction has the value c.
  */
-static Connector * extract_connectors(Tconnector *e, int c)
+static Connector * extract_connectors(Tconnector *e, int c, Pool_desc *mp)
 {
 	Connector *e1;
 	if (e == NULL) return NULL;
 	if (e->dir == c)
 	{
-		e1 = connector_new();
-		e1->next = extract_connectors(e->next,c);
+		e1 = connector_new(mp);
+		e1->next = extract_connectors(e->next, c, mp);
 		e1->multi = e->multi;
 		e1->string = e->string;
 		e1->word = 0;
@@ -350,26 +353,32 @@ static Connector * extract_connectors(Tconnector *e, int c)
 	}
 	else
 	{
-		return extract_connectors(e->next,c);
+		return extract_connectors(e->next, c, mp);
 	}
 }
 
 /**
  * Build a disjunct list out of the clause list c.
  * string is the print name of word that generated this disjunct.
+ * The disjuncts and connectors are taken from the pools of the
+ * sentence, if there is one.
  */
 static Disjunct *
-build_disjunct(Clause * cl, const char * string, double cost_cutoff)
+build_disjunct(Clause * cl, const char * string, double cost_cutoff,
+               Sentence sent)
 {
 	Disjunct *dis, *ndis;
+	Pool_desc *dpool = (NULL == sent) ? NULL : sent->Disjunct_pool;
+	Pool_desc *cpool = (NULL == sent) ? NULL : sent->Connector_pool;
+
 	dis = NULL;
 	for (; cl != NULL; cl = cl->next)
 	{
 		if (cl->maxcost <= cost_cutoff)
 		{
-			ndis = (Disjunct *) xalloc(sizeof(Disjunct));
-			ndis->left = reverse(extract_connectors(cl->c, '-'));
-			ndis->right = reverse(extract_connectors(cl->c, '+'));
+			ndis = disjunct_new(dpool);
+			ndis->left = reverse(extract_connectors(cl->c, '-', cpool));
+			ndis->right = reverse(extract_connectors(cl->c, '+', cpool));
 			ndis->string = string;
 			ndis->cost = cl->cost;
 			ndis->next = dis;
@@ -379,19 +388,40 @@ build_disjunct(Clause * cl, const char * string, double cost_cutoff)
 	return dis;
 }
 
-Disjunct * build_disjuncts_for_X_node(X_node * x, double cost_cutoff)
+static Disjunct * build_disjuncts(Exp* e, const char *string,
+                                  double cost_cutoff, Sentence sent)
 {
 	Clause *c ;
 	Disjunct * dis;
-	/* print_expression(x->exp);  printf("\n"); */
-	c = build_clause(x->exp);
+	/* print_expression(e);  printf("\n"); */
+	c = build_clause(e);
 	/* print_clause_list(c); */
-	dis = build_disjunct(c, x->string, cost_cutoff);
+	dis = build_disjunct(c, string, cost_cutoff, sent);
 	/* print_disjunct_list(dis); */
 	free_clause_list(c);
 	return dis;
 }
 
+Disjunct * build_disjuncts_for_exp(Exp* e, const char *string, double cost_cutoff)
+{
+	return build_disjuncts(e, string, cost_cutoff, NULL);
+}
+
+Disjunct * build_disjuncts_for_X_node(X_node * x, double cost_cutoff)
+{
+	return build_disjuncts(x->exp, x->string, cost_cutoff, NULL);
+}
+
+/**
+ * Like build_disjuncts_for_X_node(), but the disjuncts are taken from
+ * the pools of the sentence, and are freed with it.
+ */
+Disjunct * build_sentence_disjuncts_for_X_node(Sentence sent, X_node * x,
+                                               double cost_cutoff)
+{
+	return build_disjuncts(x->exp, x->string, cost_cutoff, sent);
+}
+
 #if DEBUG
 /* There is a much better print_expression elsewhere 
  * This one is for low-level debug. */
@@ -494,25 +524,39 @@ unsigned int count_disjunct_for_dict_node(Dict_node *dn)
  * If there, it builds the list of expressions for the word, and returns
  * a pointer to it.
  */
+static X_node * add_word_expression(Dictionary dict, X_node * x,
+                                    const Dict_node * dn)
+{
+	Exp * e = copy_Exp(dn->exp);
+	X_node * y = (X_node *) xalloc(sizeof(X_node));
+
+	y->next = x;
+	y->exp = add_empty_word(dict, dn->string, e);
+	y->string = dn->string;
+	y->dict_exp = dn->exp;
+	y->empty_word = (y->exp != e);
+	return y;
+}
+
 X_node * build_word_expressions(Dictionary dict, const char * s)
 {
 	Dict_node * dn, *dn_head;
-	X_node * x, * y;
+	X_node * x = NULL;
 
-	dn_head = dictionary_lookup_list(dict, s);
-	x = NULL;
-	dn = dn_head;
-	while (dn != NULL)
+	/* A file-backed dictionary lends its entries without copying them. */
+	if (NULL != dict->index)
 	{
-		add_empty_word(dict, dn);
-
-		y = (X_node *) xalloc(sizeof(X_node));
-		y->next = x;
-		x = y;
-		x->exp = copy_Exp(dn->exp);
-		x->string = dn->string;
-		dn = dn->right;
+		Dict_view view = dict_index_lookup(dict->index, s);
+		size_t i;
+
+		for (i = 0; i < view.num; i++)
+			x = add_word_expression(dict, x, view.dn[i]);
+		return x;
 	}
+
+	dn_head = dictionary_lookup_list(dict, s);
+	for (dn = dn_head; dn != NULL; dn = dn->right)
+		x = add_word_expression(dict, x, dn);
 	free_lookup_list (dict, dn_head);
 	return x;
 }
@@ -531,9 +575,15 @@ void build_sentence_disjuncts(Sentence sent, double cost_cutoff)
 		d = NULL;
 		for (x = sent->word[w].x; x != NULL; x = x->next)
 		{
-			Disjunct *dx = build_disjuncts_for_X_node(x, cost_cutoff);
+			Disjunct *dx;
+			if (NULL != sent->dict->disjunct_cache)
+				dx = disjunct_cache_get(sent->dict->disjunct_cache, sent, x,
+				                        cost_cutoff);
+			else
+				dx = build_sentence_disjuncts_for_X_node(sent, x, cost_cutoff);
 			d = catenate_disjuncts(dx, d);
 		}
+		condesc_set_disjuncts(sent->dict->condesc_table, d);
 		sent->word[w].d = d;
 	}
 }
@@ -0,0 +1,266 @@
+/*************************************************************************/
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+/**
+ * The connector descriptor table.
+ *
+ * When a dictionary is loaded, each distinct connector name used in
+ * its expressions gets a descriptor, with a dense number, the hash of
+ * the connector and its row of the match table of its upper-case part
+ * group.  The connectors of the sentence disjuncts point to these
+ * descriptors, so that matching them doesn't need to look at the
+ * strings at all.
+ *
+ * The table is read-only once created, and so can be shared by all the
+ * sentences (and threads) using the dictionary.  Connectors without a
+ * descriptor (e.g. from the SQL dictionary, which has no exp_list) are
+ * matched by their strings, as before.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "api-structures.h"
+#include "condesc.h"
+#include "dict-common.h"
+#include "string-set.h"
+#include "utilities.h"
+#include "word-utils.h"
+
+struct condesc_table_s
+{
+	condesc_t * desc;          /* Sorted by upper-case part */
+	size_t num_desc;
+	const condesc_t ** hash_table;  /* Open addressing, keyed by string */
+	size_t hash_table_size;    /* A power of 2 */
+	unsigned char * match_bits;
+	size_t match_bits_size;
+};
+
+static const char * uc_start(const char *s)
+{
+	if (islower((int) *s)) s++; /* skip head-dependent indicator */
+	return s;
+}
+
+static size_t uc_length(const char *s)
+{
+	size_t n = 0;
+	while (isupper((int) s[n])) n++;
+	return n;
+}
+
+/** Order by the upper-case part, then by the whole name. */
+static int condesc_cmp(const void *a, const void *b)
+{
+	const char *sa = *(const char * const *) a;
+	const char *sb = *(const char * const *) b;
+	const char *ua = uc_start(sa);
+	const char *ub = uc_start(sb);
+	size_t la = uc_length(ua);
+	size_t lb = uc_length(ub);
+	int r;
+
+	r = strncmp(ua, ub, (la < lb) ? la : lb);
+	if (0 != r) return r;
+	if (la != lb) return (la < lb) ? -1 : 1;
+	return strcmp(sa, sb);
+}
+
+static bool same_uc_part(const char *s, const char *t)
+{
+	const char *us = uc_start(s);
+	const char *ut = uc_start(t);
+	size_t ls = uc_length(us);
+
+	return (ls == uc_length(ut)) && (0 == strncmp(us, ut, ls));
+}
+
+static size_t count_connector_exps(Dictionary dict)
+{
+	size_t n = 0;
+	Exp *e;
+
+	for (e = dict->exp_list; NULL != e; e = e->next)
+		if (CONNECTOR_type == e->type) n++;
+	return n;
+}
+
+static void condesc_insert(condesc_table_t *ct, const condesc_t *desc)
+{
+	size_t mask = ct->hash_table_size - 1;
+	size_t i = (unsigned int) string_hash(desc->string) & mask;
+
+	while (NULL != ct->hash_table[i]) i = (i + 1) & mask;
+	ct->hash_table[i] = desc;
+}
+
+/**
+ * Create the connector descriptor table of the connector names used
+ * in the expressions of the dictionary.  Returns NULL if there are none.
+ */
+condesc_table_t * condesc_table_create(Dictionary dict)
+{
+	condesc_table_t *ct;
+	const char **names;
+	size_t num_names = 0, max_names, n, i, j, gstart;
+	size_t bits_size;
+	unsigned int uc_num;
+	unsigned char *row;
+	Exp *e;
+
+	max_names = count_connector_exps(dict) + 1;
+	names = (const char **) xalloc(max_names * sizeof(const char *));
+	for (e = dict->exp_list; NULL != e; e = e->next)
+		if (CONNECTOR_type == e->type) names[num_names++] = e->u.string;
+	if (dict->empty_word_defined)
+		names[num_names++] = string_set_lookup(EMPTY_CONNECTOR, dict->string_set);
+
+	if (0 == num_names)
+	{
+		xfree(names, max_names * sizeof(const char *));
+		return NULL;
+	}
+
+	/* Sort, and remove the duplicate names. */
+	qsort(names, num_names, sizeof(const char *), condesc_cmp);
+	for (n = 1, i = 1; i < num_names; i++)
+	{
+		if (0 != strcmp(names[i], names[n-1])) names[n++] = names[i];
+	}
+
+	ct = (condesc_table_t *) xalloc(sizeof(condesc_table_t));
+	ct->num_desc = n;
+	ct->desc = (condesc_t *) xalloc(n * sizeof(condesc_t));
+
+	/* Number the groups, and find the size of their match tables. */
+	bits_size = 0;
+	uc_num = 0;
+	for (gstart = 0; gstart < n; gstart = i)
+	{
+		size_t gsize;
+
+		for (i = gstart + 1; i < n; i++)
+			if (!same_uc_part(names[gstart], names[i])) break;
+		gsize = i - gstart;
+		bits_size += gsize * ((gsize + 7) / 8);
+
+		for (j = gstart; j < i; j++)
+		{
+			Connector c;
+
+			init_connector(&c);
+			c.string = names[j];
+			ct->desc[j].string = names[j];
+			ct->desc[j].uc_num = uc_num;
+			ct->desc[j].uc_index = (unsigned int) (j - gstart);
+			ct->desc[j].hash = calculate_connector_hash(&c);
+		}
+		uc_num++;
+	}
+
+	/* Fill in the match table rows. */
+	ct->match_bits_size = bits_size;
+	ct->match_bits = (unsigned char *) xalloc(bits_size);
+	memset(ct->match_bits, 0, bits_size);
+	row = ct->match_bits;
+	for (gstart = 0; gstart < n; gstart = i)
+	{
+		size_t row_size;
+
+		for (i = gstart + 1; i < n; i++)
+			if (ct->desc[i].uc_num != ct->desc[gstart].uc_num) break;
+		row_size = (i - gstart + 7) / 8;
+
+		for (j = gstart; j < i; j++)
+		{
+			size_t k;
+			for (k = gstart; k < i; k++)
+			{
+				if (easy_match(names[j], names[k]))
+					row[(k - gstart) >> 3] |= 1 << ((k - gstart) & 7);
+			}
+			ct->desc[j].match_row = row;
+			row += row_size;
+		}
+	}
+	xfree(names, max_names * sizeof(const char *));
+
+	/* At most half full. */
+	ct->hash_table_size = 1;
+	while (ct->hash_table_size < 2 * n) ct->hash_table_size *= 2;
+	ct->hash_table = (const condesc_t **)
+		xalloc(ct->hash_table_size * sizeof(const condesc_t *));
+	memset(ct->hash_table, 0, ct->hash_table_size * sizeof(const condesc_t *));
+	for (i = 0; i < n; i++) condesc_insert(ct, &ct->desc[i]);
+
+	return ct;
+}
+
+void condesc_table_delete(condesc_table_t *ct)
+{
+	if (NULL == ct) return;
+	xfree(ct->hash_table, ct->hash_table_size * sizeof(const condesc_t *));
+	xfree(ct->match_bits, ct->match_bits_size);
+	xfree(ct->desc, ct->num_desc * sizeof(condesc_t));
+	xfree(ct, sizeof(condesc_table_t));
+}
+
+/** Return the number of connector names in the table. */
+size_t condesc_table_size(const condesc_table_t *ct)
+{
+	if (NULL == ct) return 0;
+	return ct->num_desc;
+}
+
+/**
+ * Return the descriptor of the connector name s, or NULL if it is
+ * not in the table.
+ */
+const condesc_t * condesc_lookup(const condesc_table_t *ct, const char *s)
+{
+	size_t mask, i;
+
+	if (NULL == ct) return NULL;
+	mask = ct->hash_table_size - 1;
+	i = (unsigned int) string_hash(s) & mask;
+	for (; NULL != ct->hash_table[i]; i = (i + 1) & mask)
+	{
+		const condesc_t *desc = ct->hash_table[i];
+		if ((desc->string == s) || (0 == strcmp(desc->string, s)))
+			return desc;
+	}
+	return NULL;
+}
+
+/**
+ * Set the descriptor (and so the hash) of the connectors of the list c
+ * that don't have one yet.
+ */
+void condesc_set_connectors(const condesc_table_t *ct, Connector *c)
+{
+	if (NULL == ct) return;
+	for (; NULL != c; c = c->next)
+	{
+		if (NULL != c->desc) continue;
+		c->desc = condesc_lookup(ct, c->string);
+		if (NULL != c->desc) c->hash = c->desc->hash;
+	}
+}
+
+void condesc_set_disjuncts(const condesc_table_t *ct, Disjunct *d)
+{
+	if (NULL == ct) return;
+	for (; NULL != d; d = d->next)
+	{
+		condesc_set_connectors(ct, d->left);
+		condesc_set_connectors(ct, d->right);
+	}
+}
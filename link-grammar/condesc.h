@@ -0,0 +1,58 @@
+/*************************************************************************/
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+#ifndef _CONDESC_H_
+#define _CONDESC_H_
+
+#include "api-types.h"
+#include "structures.h"
+#include "word-utils.h"
+
+/**
+ * The descriptor of a connector name of the dictionary.
+ *
+ * The connector names are grouped by their upper-case part (after the
+ * optional head-dependent indicator).  Two connectors can only match
+ * if they are in the same group, and each group has its own bit matrix
+ * of easy_match() results, so that matching two connectors of the
+ * dictionary is an integer compare and a bit test.
+ */
+struct condesc_struct
+{
+	const char * string;    /* The connector name, without direction */
+	unsigned int uc_num;    /* Number of the upper-case part group */
+	unsigned int uc_index;  /* Index of this name in its group */
+	int hash;               /* calculate_connector_hash() of the name */
+	const unsigned char * match_row; /* Bit uc_index of another name of
+	                                    the group is set if they match */
+};
+
+condesc_table_t * condesc_table_create(Dictionary);
+void condesc_table_delete(condesc_table_t *);
+const condesc_t * condesc_lookup(const condesc_table_t *, const char *);
+size_t condesc_table_size(const condesc_table_t *);
+void condesc_set_connectors(const condesc_table_t *, Connector *);
+void condesc_set_disjuncts(const condesc_table_t *, Disjunct *);
+
+/**
+ * Returns TRUE if the connectors a and b match, the same as
+ * easy_match(a->string, b->string).  If both have a descriptor,
+ * this is a lookup in the match table, else the strings are compared.
+ */
+static inline bool easy_match_connectors(const Connector *a, const Connector *b)
+{
+	const condesc_t *da = a->desc, *db = b->desc;
+
+	if ((NULL == da) || (NULL == db)) return easy_match(a->string, b->string);
+	if (da->uc_num != db->uc_num) return false;
+	return 0 != (da->match_row[db->uc_index >> 3] & (1 << (db->uc_index & 7)));
+}
+
+#endif /* _CONDESC_H_ */
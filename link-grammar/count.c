@@ -12,8 +12,14 @@
 /*************************************************************************/
 
 #include <limits.h>
+#include <stdint.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
 #include "link-includes.h"
 #include "api-structures.h"
+#include "condesc.h"
 #include "count.h"
 #include "disjunct-utils.h"
 #include "fast-match.h"
@@ -24,17 +30,49 @@
 
 /* This file contains the exhaustive search algorithm. */
 
+/*
+ * The count memo table.
+ *
+ * The table entries are allocated, one after the other, from an arena
+ * of fixed-size blocks owned by the count context.  They never move,
+ * and they are all freed at once, a block at a time.  The hash table
+ * itself uses open addressing with linear probing, and holds only the
+ * (32-bit) arena indexes of the entries.  Its initial size is derived
+ * from the number of connectors in the (pruned) sentence, and it is
+ * doubled whenever it gets 3/4 full.
+ *
+ * When counting in parallel, the table is split into shards, selected
+ * by the top bits of the hash, each with its own arena and its own
+ * lock, so that the threads seldom wait for each other.  Otherwise
+ * there is a single shard, and no locking.
+ */
 typedef struct Table_connector_s Table_connector;
 struct Table_connector_s
 {
-	Table_connector  *next;
 	Connector        *le, *re;
-	s64              count;
+	s64              count;  /* -1 while it is being computed */
 	short            lw, rw;
 	unsigned short   cost; /* Cost, here and below, is actually the
 	                        * null-count being considered. */
 };
 
+typedef struct count_table_s count_table_t;
+struct count_table_s
+{
+	unsigned int table_size;
+	unsigned int log2_table_size;
+	unsigned int * table;        /* Entry index + 1, or 0 if empty */
+	unsigned int table_entries;  /* Number of entries in the arena */
+	Table_connector ** block;    /* The entry arena */
+	unsigned int num_blocks;     /* Number of allocated blocks */
+	unsigned int block_array_size;
+#ifdef USE_PTHREADS
+	pthread_mutex_t lock;        /* Taken only when counting in parallel */
+#endif
+};
+
+typedef struct count_parallel_s count_parallel_t;
+
 struct count_context_s
 {
 	Word *  local_sent;
@@ -43,55 +81,248 @@ struct count_context_s
 	bool    null_links;
 	bool    exhausted;
 	int     checktimer;  /* Avoid excess system calls */
-	int     table_size;
-	int     log2_table_size;
-	Table_connector ** table;
+	count_table_t * shard;       /* The memo table */
+	unsigned int log2_num_shards;
+	count_parallel_t * parallel; /* NULL unless counting in parallel */
 	Resources current_resources;
 };
 
-static void free_table(count_context_t *ctxt)
+#define MIN_LOG2_TABLE_SIZE 10
+#define MAX_LOG2_TABLE_SIZE 31
+
+/* Number of entries per arena block (a power of 2). The blocks are
+ * kept below the malloc mmap threshold, so that they can reuse the
+ * memory freed by the earlier parsing stages. */
+#define LOG2_TABLE_BLOCK_SIZE 11
+#define TABLE_BLOCK_SIZE (1U << LOG2_TABLE_BLOCK_SIZE)
+
+/* The number of shards of the table when counting in parallel. */
+#define LOG2_PARALLEL_SHARDS 6
+
+/* Sentences shorter than this are always counted in one thread;
+ * starting the threads would cost more than it saves. */
+#define MIN_PARALLEL_COUNT_LENGTH 30
+
+static void free_table(count_table_t *st)
 {
-	int i;
-	Table_connector *t, *x;
+	unsigned int i;
 
-	for (i=0; i<ctxt->table_size; i++)
+	for (i = 0; i < st->num_blocks; i++)
 	{
-		for(t = ctxt->table[i]; t!= NULL; t=x)
-		{
-			x = t->next;
-			xfree((void *) t, sizeof(Table_connector));
-		}
+		xfree(st->block[i], TABLE_BLOCK_SIZE * sizeof(Table_connector));
+	}
+	xfree(st->block, st->block_array_size * sizeof(Table_connector *));
+	st->block = NULL;
+	st->num_blocks = 0;
+	st->block_array_size = 0;
+	st->table_entries = 0;
+
+	xfree(st->table, st->table_size * sizeof(unsigned int));
+	st->table = NULL;
+	st->table_size = 0;
+}
+
+/**
+ * Size and clear the table of a shard.  The table and the arena blocks
+ * are kept if they are about the right size; the surplus blocks of a
+ * previous, larger sentence are freed.
+ */
+static void clear_table(count_table_t *st, unsigned int shift)
+{
+	unsigned int keep_blocks;
+
+	if (st->table_size != (1U << shift))
+	{
+		xfree(st->table, st->table_size * sizeof(unsigned int));
+		st->table_size = (1U << shift);
+		st->table = (unsigned int *)
+			xalloc(st->table_size * sizeof(unsigned int));
 	}
-	xfree(ctxt->table, ctxt->table_size * sizeof(Table_connector*));
-	ctxt->table = NULL;
-	ctxt->table_size = 0;
+	st->log2_table_size = shift;
+	memset(st->table, 0, st->table_size * sizeof(unsigned int));
+
+	/* Keep as many blocks as the table can index before it grows. */
+	keep_blocks = (3 * (st->table_size / 4) + TABLE_BLOCK_SIZE - 1) /
+	              TABLE_BLOCK_SIZE;
+	while (st->num_blocks > keep_blocks)
+	{
+		st->num_blocks--;
+		xfree(st->block[st->num_blocks],
+		      TABLE_BLOCK_SIZE * sizeof(Table_connector));
+	}
+	st->table_entries = 0;
 }
 
-static void init_table(count_context_t *ctxt, size_t sent_len)
+static count_table_t * alloc_shards(unsigned int log2_num_shards)
 {
+	unsigned int i, n = 1U << log2_num_shards;
+	count_table_t *shard;
+
+	shard = (count_table_t *) xalloc(n * sizeof(count_table_t));
+	memset(shard, 0, n * sizeof(count_table_t));
+	for (i = 0; i < n; i++)
+	{
+#ifdef USE_PTHREADS
+		pthread_mutex_init(&shard[i].lock, NULL);
+#endif
+	}
+	return shard;
+}
+
+static void free_shards(count_context_t *ctxt)
+{
+	unsigned int i, n = 1U << ctxt->log2_num_shards;
+
+	if (NULL == ctxt->shard) return;
+	for (i = 0; i < n; i++)
+	{
+		free_table(&ctxt->shard[i]);
+#ifdef USE_PTHREADS
+		pthread_mutex_destroy(&ctxt->shard[i].lock);
+#endif
+	}
+	xfree(ctxt->shard, n * sizeof(count_table_t));
+	ctxt->shard = NULL;
+	ctxt->log2_num_shards = 0;
+}
+
+/**
+ * Size and clear the table for the sentence.  It is a single shard,
+ * even if the context was used for counting in parallel before.
+ */
+static void init_table(count_context_t *ctxt, Sentence sent)
+{
+	size_t w, num_connectors = 0;
 	unsigned int shift;
-	/* A piecewise exponential function determines the size of the
-	 * hash table. Probably should make use of the actual number of
-	 * disjuncts, rather than just the number of words.
-	 */
-	if (ctxt->table) free_table(ctxt);
 
-	if (sent_len >= 10)
+	/* The number of table entries grows with the number of connectors
+	 * that survived the pruning, times the number of words they may
+	 * be matched against.  Size the table for a fraction of that; it
+	 * grows as needed. */
+	for (w = 0; w < sent->length; w++)
 	{
-		shift = 12 + (sent_len) / 6 ; 
-	} 
-	else
+		Disjunct *d;
+		Connector *c;
+		for (d = sent->word[w].d; d != NULL; d = d->next)
+		{
+			for (c = d->left; c != NULL; c = c->next) num_connectors++;
+			for (c = d->right; c != NULL; c = c->next) num_connectors++;
+		}
+	}
+	num_connectors *= sent->length / 2 + 1;
+
+	for (shift = MIN_LOG2_TABLE_SIZE; shift < MAX_LOG2_TABLE_SIZE; shift++)
+	{
+		if (num_connectors < (1U << shift)) break;
+	}
+
+	if (0 != ctxt->log2_num_shards) free_shards(ctxt);
+	if (NULL == ctxt->shard) ctxt->shard = alloc_shards(0);
+	clear_table(&ctxt->shard[0], shift);
+}
+
+/**
+ * The hash of the quintuple, after a multiplicative (Fibonacci)
+ * scramble, so that its top bits can be used as the table index.
+ */
+static inline unsigned int count_hash(int lw, int rw,
+                                      const Connector *le, const Connector *re,
+                                      unsigned int cost)
+{
+	/* sdbm-based hash, as in pair_hash() */
+	unsigned int i = cost;
+	i = lw + (i << 6) + (i << 16) - i;
+	i = rw + (i << 6) + (i << 16) - i;
+	i = ((unsigned long) le) + (i << 6) + (i << 16) - i;
+	i = ((unsigned long) re) + (i << 6) + (i << 16) - i;
+	return i * 2654435769U;
+}
+
+/** The shard of the hash h, given by its top bits. */
+static inline count_table_t * table_shard(count_context_t *ctxt,
+                                          unsigned int h)
+{
+	return &ctxt->shard[(unsigned int)
+		(((uint64_t) h << ctxt->log2_num_shards) >> 32)];
+}
+
+/** The table index of the hash h in its shard: the next top bits. */
+static inline unsigned int table_index(count_context_t *ctxt,
+                                       count_table_t *st, unsigned int h)
+{
+	return (h << ctxt->log2_num_shards) >> (32 - st->log2_table_size);
+}
+
+static inline Table_connector * table_entry(count_table_t *st,
+                                            unsigned int i)
+{
+	return &st->block[i >> LOG2_TABLE_BLOCK_SIZE][i & (TABLE_BLOCK_SIZE-1)];
+}
+
+static inline void shard_lock(count_context_t *ctxt, count_table_t *st)
+{
+#ifdef USE_PTHREADS
+	if (NULL != ctxt->parallel) pthread_mutex_lock(&st->lock);
+#endif
+}
+
+static inline void shard_unlock(count_context_t *ctxt, count_table_t *st)
+{
+#ifdef USE_PTHREADS
+	if (NULL != ctxt->parallel) pthread_mutex_unlock(&st->lock);
+#endif
+}
+
+static void grow_table(count_context_t *ctxt, count_table_t *st)
+{
+	unsigned int i;
+	unsigned int mask;
+	unsigned int old_size = st->table_size;
+	unsigned int *old_table = st->table;
+
+	st->log2_table_size++;
+	st->table_size = (1U << st->log2_table_size);
+	st->table = (unsigned int *)
+		xalloc(st->table_size * sizeof(unsigned int));
+	memset(st->table, 0, st->table_size * sizeof(unsigned int));
+	mask = st->table_size - 1;
+
+	for (i = 0; i < old_size; i++)
 	{
-		shift = 12;
+		Table_connector *t;
+		unsigned int h;
+
+		if (0 == old_table[i]) continue;
+		t = table_entry(st, old_table[i] - 1);
+		h = table_index(ctxt, st,
+		                count_hash(t->lw, t->rw, t->le, t->re, t->cost));
+		while (0 != st->table[h]) h = (h + 1) & mask;
+		st->table[h] = old_table[i];
 	}
+	xfree(old_table, old_size * sizeof(unsigned int));
+}
+
+/** Get a new entry from the arena. */
+static Table_connector * table_alloc(count_table_t *st)
+{
+	unsigned int i = st->table_entries;
+	unsigned int b = i >> LOG2_TABLE_BLOCK_SIZE;
 
-	/* Clamp at max 4*(1<<24) == 64 MBytes */
-	if (24 < shift) shift = 24;
-	ctxt->table_size = (1U << shift);
-	ctxt->log2_table_size = shift;
-	ctxt->table = (Table_connector**) 
-		xalloc(ctxt->table_size * sizeof(Table_connector*));
-	memset(ctxt->table, 0, ctxt->table_size*sizeof(Table_connector*));
+	if (b == st->num_blocks)
+	{
+		if (b == st->block_array_size)
+		{
+			unsigned int n = (0 == b) ? 16 : 2 * b;
+			st->block = (Table_connector **) xrealloc(st->block,
+				b * sizeof(Table_connector *), n * sizeof(Table_connector *));
+			st->block_array_size = n;
+		}
+		st->block[b] = (Table_connector *)
+			xalloc(TABLE_BLOCK_SIZE * sizeof(Table_connector));
+		st->num_blocks++;
+	}
+	st->table_entries++;
+	return &st->block[b][i & (TABLE_BLOCK_SIZE-1)];
 }
 
 /*
@@ -103,74 +334,195 @@ bool do_match(Connector *a, Connector *b, int aw, int bw)
 	int dist = bw - aw;
 	assert(aw < bw, "do_match() did not receive params in the natural order.");
 	if (dist > a->length_limit || dist > b->length_limit) return false;
-	return easy_match(a->string, b->string);
+	return easy_match_connectors(a, b);
 }
 
-/** 
- * Stores the value in the table.  Assumes it's not already there.
+/**
+ * Stores the value in the shard st of the hash h.  Assumes it's not
+ * already there.
  */
 static Table_connector * table_store(count_context_t *ctxt,
+                                     count_table_t *st, unsigned int h,
                                      int lw, int rw,
                                      Connector *le, Connector *re,
                                      unsigned int cost, s64 count)
 {
-	Table_connector *t, *n;
-	unsigned int h;
+	Table_connector *n;
+	unsigned int i;
+
+	if (4 * (st->table_entries + 1) > 3 * st->table_size) grow_table(ctxt, st);
 
-	n = (Table_connector *) xalloc(sizeof(Table_connector));
+	i = table_index(ctxt, st, h);
+	while (0 != st->table[i]) i = (i + 1) & (st->table_size - 1);
+	st->table[i] = st->table_entries + 1;
+
+	n = table_alloc(st);
 	n->count = count;
 	n->lw = lw; n->rw = rw; n->le = le; n->re = re; n->cost = cost;
-	h = pair_hash(ctxt->log2_table_size,lw, rw, le, re, cost);
-	t = ctxt->table[h];
-	n->next = t;
-	ctxt->table[h] = n;
 	return n;
 }
 
 /** returns the pointer to this info, NULL if not there */
-static Table_connector * 
+static Table_connector *
 find_table_pointer(count_context_t *ctxt,
-                   int lw, int rw, 
+                   count_table_t *st, unsigned int h,
+                   int lw, int rw,
                    Connector *le, Connector *re,
                    unsigned int cost)
 {
-	Table_connector *t;
-	unsigned int h = pair_hash(ctxt->log2_table_size,lw, rw, le, re, cost);
-	t = ctxt->table[h];
-	for (; t != NULL; t = t->next) {
-		if ((t->lw == lw) && (t->rw == rw)
-		    && (t->le == le) && (t->re == re)
+	unsigned int i = table_index(ctxt, st, h);
+
+	for (; 0 != st->table[i]; i = (i + 1) & (st->table_size - 1))
+	{
+		Table_connector *t = table_entry(st, st->table[i] - 1);
+		if ((t->le == le) && (t->re == re)
+		    && (t->lw == lw) && (t->rw == rw)
 		    && (t->cost == cost))  return t;
 	}
+	return NULL;
+}
 
-	/* Create a new connector only if resources are exhausted.
-	 * (???) Huh? I guess we're in panic parse mode in that case.
-	 * checktimer is a device to avoid a gazillion system calls
+#ifdef USE_PTHREADS
+/* Counting in parallel.
+ *
+ * The top-level span of the sentence is split on its middle word, as
+ * in do_count(): each pair of a right connector of the left wall and
+ * a middle word is a task, computing the counts of the left and right
+ * subspans.  The tasks are handed out, from the last middle word to the
+ * first, so that the threads tend to go from the small subspans to the
+ * big ones, to a pool of threads that share the memo table.
+ *
+ * The threads only fill the memo table: do_count() is then run as
+ * usual, and finds the counts of the subspans there.  So the result is
+ * exactly that of counting in a single thread.  A thread that meets an
+ * entry that another thread is still computing computes it too,
+ * instead of waiting for it; both get the same count.
+ */
+typedef struct
+{
+	Connector * le;
+	int w;
+} count_task_t;
+
+struct count_parallel_s
+{
+	count_task_t * task;
+	size_t num_tasks;
+	size_t next_task;
+	int rw;
+	int null_count;
+	bool exhausted;            /* Set by the thread that finds it out */
+	pthread_mutex_t lock;
+};
+
+typedef struct
+{
+	count_parallel_t * par;
+	count_context_t ctxt;      /* The thread's own copy of the context */
+	fast_matcher_t * mchxt;
+} count_worker_t;
+#endif /* USE_PTHREADS */
+
+/**
+ * Check (now and then) whether the resources are exhausted.  When
+ * counting in parallel, only the calling thread checks them, and it
+ * tells the others.
+ */
+static bool count_exhausted(count_context_t *ctxt)
+{
+	/* checktimer is a device to avoid a gazillion system calls
 	 * to get the timer value. On circa-2009 machines, it results
 	 * in maybe 5-10 timer calls per second.
 	 */
 	ctxt->checktimer ++;
-	if (ctxt->exhausted || ((0 == ctxt->checktimer%450100) &&
-	                       (ctxt->current_resources != NULL) && 
-	                       resources_exhausted(ctxt->current_resources)))
-	{
+	if (ctxt->exhausted) return true;
+
+	/* A cancellation is only a memory read away, so look for it
+	 * much more often than at the timer. */
+	if ((0 == (ctxt->checktimer & 1023)) &&
+	    (ctxt->current_resources != NULL) &&
+	    resources_cancelled(ctxt->current_resources))
 		ctxt->exhausted = true;
-		return table_store(ctxt, lw, rw, le, re, cost, 0);
+	else if (0 != ctxt->checktimer%450100) return false;
+
+	if ((ctxt->current_resources != NULL) &&
+	    resources_exhausted(ctxt->current_resources))
+		ctxt->exhausted = true;
+
+#ifdef USE_PTHREADS
+	if (NULL != ctxt->parallel)
+	{
+		count_parallel_t *par = ctxt->parallel;
+		pthread_mutex_lock(&par->lock);
+		if (ctxt->exhausted) par->exhausted = true;
+		else ctxt->exhausted = par->exhausted;
+		pthread_mutex_unlock(&par->lock);
+	}
+#endif
+	return ctxt->exhausted;
+}
+
+/**
+ * Returns the count for this quintuple if it is known, -1 otherwise.
+ * If it is not known, and tp is not NULL, *tp is set to the entry that
+ * is to receive it: a new one, or one that another thread is computing.
+ */
+static s64 find_count(count_context_t *ctxt,
+                      int lw, int rw, Connector *le, Connector *re,
+                      unsigned int cost, Table_connector **tp)
+{
+	unsigned int h = count_hash(lw, rw, le, re, cost);
+	count_table_t *st = table_shard(ctxt, h);
+	Table_connector *t;
+	s64 count;
+
+	shard_lock(ctxt, st);
+	t = find_table_pointer(ctxt, st, h, lw, rw, le, re, cost);
+	if (NULL == t)
+	{
+		/* Create a new connector only if resources are exhausted.
+		 * (???) Huh? I guess we're in panic parse mode in that case.
+		 */
+		if (count_exhausted(ctxt))
+			t = table_store(ctxt, st, h, lw, rw, le, re, cost, 0);
+		else if (NULL != tp)
+			t = table_store(ctxt, st, h, lw, rw, le, re, cost, -1);
+	}
+	count = (NULL == t) ? -1 : t->count;
+	shard_unlock(ctxt, st);
+
+	if (NULL != tp) *tp = t;
+	return count;
+}
+
+/** Set the count of the entry t, and return it. */
+static inline s64 set_count(count_context_t *ctxt, Table_connector *t,
+                            s64 count)
+{
+#ifdef USE_PTHREADS
+	if (NULL != ctxt->parallel)
+	{
+		count_table_t *st =
+			table_shard(ctxt, count_hash(t->lw, t->rw, t->le, t->re, t->cost));
+		pthread_mutex_lock(&st->lock);
+		t->count = count;
+		pthread_mutex_unlock(&st->lock);
+		return count;
 	}
-	else return NULL;
+#endif
+	t->count = count;
+	return count;
 }
 
 /** returns the count for this quintuple if there, -1 otherwise */
-s64 table_lookup(count_context_t * ctxt, 
+s64 table_lookup(count_context_t * ctxt,
                  int lw, int rw, Connector *le, Connector *re, unsigned int cost)
 {
-	Table_connector *t = find_table_pointer(ctxt, lw, rw, le, re, cost);
-
-	if (t == NULL) return -1; else return t->count;
+	return find_count(ctxt, lw, rw, le, re, cost, NULL);
 }
 
 /**
- * Returns 0 if and only if this entry is in the hash table 
+ * Returns 0 if and only if this entry is in the hash table
  * with a count value of 0.
  */
 static s64 pseudocount(count_context_t * ctxt,
@@ -181,7 +533,10 @@ static s64 pseudocount(count_context_t * ctxt,
 	if (count == 0) return 0; else return 1;
 }
 
-static s64 do_count(fast_matcher_t *mchxt, 
+static bool do_count_word(fast_matcher_t *, count_context_t *,
+                          int, int, Connector *, Connector *, int, int, s64 *);
+
+static s64 do_count(fast_matcher_t *mchxt,
                     count_context_t *ctxt,
                     int lw, int rw,
                     Connector *le, Connector *re, int null_count)
@@ -192,13 +547,10 @@ static s64 do_count(fast_matcher_t *mchxt,
 
 	if (null_count < 0) return 0;  /* can this ever happen?? */
 
-	t = find_table_pointer(ctxt, lw, rw, le, re, null_count);
-
-	if (t) return t->count;
-
-	/* Create the table entry with a tentative null count of 0. 
-	 * This count must be updated before we return. */
-	t = table_store(ctxt, lw, rw, le, re, null_count, 0);
+	/* If it is not known, this creates the table entry, to be updated
+	 * before we return. */
+	total = find_count(ctxt, lw, rw, le, re, null_count, &t);
+	if (0 <= total) return total;
 
 	if (rw == 1+lw)
 	{
@@ -206,13 +558,12 @@ static s64 do_count(fast_matcher_t *mchxt,
 		/* You can't have a linkage here with null_count > 0 */
 		if ((le == NULL) && (re == NULL) && (null_count == 0))
 		{
-			t->count = 1;
+			return set_count(ctxt, t, 1);
 		}
 		else
 		{
-			t->count = 0;
+			return set_count(ctxt, t, 0);
 		}
-		return t->count;
 	}
 
 	if ((le == NULL) && (re == NULL))
@@ -228,26 +579,25 @@ static s64 do_count(fast_matcher_t *mchxt,
 			{
 				/* If null_block=4 then the null_count of
 				   1,2,3,4 nulls is 1; and 5,6,7,8 is 2 etc. */
-				t->count = 1;
+				return set_count(ctxt, t, 1);
 			}
 			else
 			{
-				t->count = 0;
+				return set_count(ctxt, t, 0);
 			}
-			return t->count;
 		}
 		if (null_count == 0)
 		{
 			/* There is no solution without nulls in this case. There is
 			 * a slight efficiency hack to separate this null_count==0
 			 * case out, but not necessary for correctness */
-			t->count = 0;
+			return set_count(ctxt, t, 0);
 		}
 		else
 		{
 			Disjunct * d;
-			s64 total = 0;
 			int w = lw + 1;
+			total = 0;
 			for (d = ctxt->local_sent[w].d; d != NULL; d = d->next)
 			{
 				if (d->left == NULL)
@@ -256,9 +606,8 @@ static s64 do_count(fast_matcher_t *mchxt,
 				}
 			}
 			total += do_count(mchxt, ctxt, w, rw, NULL, NULL, null_count-1);
-			t->count = total;
+			return set_count(ctxt, t, total);
 		}
-		return t->count;
 	}
 
 	if (le == NULL)
@@ -283,108 +632,279 @@ static s64 do_count(fast_matcher_t *mchxt,
 
 	for (w = start_word; w < end_word; w++)
 	{
-		Match_node *m, *m1;
-		m1 = m = form_match_list(mchxt, w, le, lw, re, rw);
-		for (; m != NULL; m = m->next)
+		if (do_count_word(mchxt, ctxt, lw, rw, le, re, null_count, w, &total))
+			break;
+	}
+	return set_count(ctxt, t, total);
+}
+
+/**
+ * Add to *total the counts of the span lw, rw with the middle word w,
+ * as in do_count().  Returns TRUE if the total overflowed, in which
+ * case it has been clamped.
+ */
+static bool do_count_word(fast_matcher_t *mchxt,
+                          count_context_t *ctxt,
+                          int lw, int rw,
+                          Connector *le, Connector *re, int null_count,
+                          int w, s64 *total)
+{
+	size_t mlb, mle;
+	Disjunct * d;
+
+	mle = mlb = form_match_list(mchxt, w, le, lw, re, rw);
+	for (; (d = get_match_list_element(mchxt, mle)) != NULL; mle++)
+	{
+		unsigned int lcost, rcost;
+		unsigned int null_count_p1;
+		null_count_p1 = null_count + 1; /* avoid gcc warning: unsafe loop opt */
+		for (lcost = 0; lcost < null_count_p1; lcost++)
 		{
-			unsigned int lcost, rcost;
-			unsigned int null_count_p1;
-			Disjunct * d;
-			d = m->d;
-			null_count_p1 = null_count + 1; /* avoid gcc warning: unsafe loop opt */
-			for (lcost = 0; lcost < null_count_p1; lcost++)
+			bool Lmatch, Rmatch;
+			s64 leftcount = 0, rightcount = 0;
+			s64 pseudototal;
+
+			rcost = null_count - lcost;
+			/* Now lcost and rcost are the costs we're assigning
+			 * to those parts respectively */
+
+			/* Now, we determine if (based on table only) we can see that
+			   the current range is not parsable. */
+			Lmatch = (le != NULL) && (d->left != NULL) &&
+			         do_match(le, d->left, lw, w);
+			Rmatch = (d->right != NULL) && (re != NULL) &&
+			         do_match(d->right, re, w, rw);
+
+			if (Lmatch)
 			{
-				bool Lmatch, Rmatch;
-				s64 leftcount = 0, rightcount = 0;
-				s64 pseudototal;
-
-				rcost = null_count - lcost;
-				/* Now lcost and rcost are the costs we're assigning
-				 * to those parts respectively */
-
-				/* Now, we determine if (based on table only) we can see that
-				   the current range is not parsable. */
-				Lmatch = (le != NULL) && (d->left != NULL) && 
-				         do_match(le, d->left, lw, w);
-				Rmatch = (d->right != NULL) && (re != NULL) && 
-				         do_match(d->right, re, w, rw);
-
-				if (Lmatch)
-				{
-					leftcount = pseudocount(ctxt, lw, w, le->next, d->left->next, lcost);
-					if (le->multi) leftcount += pseudocount(ctxt, lw, w, le, d->left->next, lcost);
-					if (d->left->multi) leftcount += pseudocount(ctxt, lw, w, le->next, d->left, lcost);
-					if (le->multi && d->left->multi) leftcount += pseudocount(ctxt, lw, w, le, d->left, lcost);
+				leftcount = pseudocount(ctxt, lw, w, le->next, d->left->next, lcost);
+				if (le->multi) leftcount += pseudocount(ctxt, lw, w, le, d->left->next, lcost);
+				if (d->left->multi) leftcount += pseudocount(ctxt, lw, w, le->next, d->left, lcost);
+				if (le->multi && d->left->multi) leftcount += pseudocount(ctxt, lw, w, le, d->left, lcost);
+			}
+
+			if (Rmatch)
+			{
+				rightcount = pseudocount(ctxt, w, rw, d->right->next, re->next, rcost);
+				if (d->right->multi) rightcount += pseudocount(ctxt, w,rw,d->right,re->next, rcost);
+				if (re->multi) rightcount += pseudocount(ctxt, w, rw, d->right->next, re, rcost);
+				if (d->right->multi && re->multi) rightcount += pseudocount(ctxt, w, rw, d->right, re, rcost);
+			}
+
+			/* total number where links are used on both sides */
+			pseudototal = leftcount*rightcount;
+
+			if (leftcount > 0) {
+				/* evaluate using the left match, but not the right */
+				pseudototal += leftcount * pseudocount(ctxt, w, rw, d->right, re, rcost);
+			}
+			if ((le == NULL) && (rightcount > 0)) {
+				/* evaluate using the right match, but not the left */
+				pseudototal += rightcount * pseudocount(ctxt, lw, w, le, d->left, lcost);
+			}
+
+			/* now pseudototal is 0 implies that we know that the true total is 0 */
+			if (pseudototal != 0) {
+				rightcount = leftcount = 0;
+				if (Lmatch) {
+					leftcount = do_count(mchxt, ctxt, lw, w, le->next, d->left->next, lcost);
+					if (le->multi) leftcount += do_count(mchxt, ctxt, lw, w, le, d->left->next, lcost);
+					if (d->left->multi) leftcount += do_count(mchxt, ctxt, lw, w, le->next, d->left, lcost);
+					if (le->multi && d->left->multi) leftcount += do_count(mchxt, ctxt, lw, w, le, d->left, lcost);
 				}
 
-				if (Rmatch)
-				{
-					rightcount = pseudocount(ctxt, w, rw, d->right->next, re->next, rcost);
-					if (d->right->multi) rightcount += pseudocount(ctxt, w,rw,d->right,re->next, rcost);
-					if (re->multi) rightcount += pseudocount(ctxt, w, rw, d->right->next, re, rcost);
-					if (d->right->multi && re->multi) rightcount += pseudocount(ctxt, w, rw, d->right, re, rcost);
+				if (Rmatch) {
+					rightcount = do_count(mchxt, ctxt, w, rw, d->right->next, re->next, rcost);
+					if (d->right->multi) rightcount += do_count(mchxt, ctxt, w, rw, d->right,re->next, rcost);
+					if (re->multi) rightcount += do_count(mchxt, ctxt, w, rw, d->right->next, re, rcost);
+					if (d->right->multi && re->multi) rightcount += do_count(mchxt, ctxt, w, rw, d->right, re, rcost);
 				}
 
-				/* total number where links are used on both sides */
-				pseudototal = leftcount*rightcount;
+				/* Total number where links are used on both sides */
+				*total += leftcount*rightcount;
 
 				if (leftcount > 0) {
-					/* evaluate using the left match, but not the right */
-					pseudototal += leftcount * pseudocount(ctxt, w, rw, d->right, re, rcost);
+					/* Evaluate using the left match, but not the right */
+					*total += leftcount * do_count(mchxt, ctxt, w, rw, d->right, re, rcost);
 				}
 				if ((le == NULL) && (rightcount > 0)) {
-					/* evaluate using the right match, but not the left */
-					pseudototal += rightcount * pseudocount(ctxt, lw, w, le, d->left, lcost);
+					/* Evaluate using the right match, but not the left */
+					*total += rightcount * do_count(mchxt, ctxt, lw, w, le, d->left, lcost);
 				}
 
-				/* now pseudototal is 0 implies that we know that the true total is 0 */
-				if (pseudototal != 0) {
-					rightcount = leftcount = 0;
-					if (Lmatch) {
-						leftcount = do_count(mchxt, ctxt, lw, w, le->next, d->left->next, lcost);
-						if (le->multi) leftcount += do_count(mchxt, ctxt, lw, w, le, d->left->next, lcost);
-						if (d->left->multi) leftcount += do_count(mchxt, ctxt, lw, w, le->next, d->left, lcost);
-						if (le->multi && d->left->multi) leftcount += do_count(mchxt, ctxt, lw, w, le, d->left, lcost);
-					}
-
-					if (Rmatch) {
-						rightcount = do_count(mchxt, ctxt, w, rw, d->right->next, re->next, rcost);
-						if (d->right->multi) rightcount += do_count(mchxt, ctxt, w, rw, d->right,re->next, rcost);
-						if (re->multi) rightcount += do_count(mchxt, ctxt, w, rw, d->right->next, re, rcost);
-						if (d->right->multi && re->multi) rightcount += do_count(mchxt, ctxt, w, rw, d->right, re, rcost);
-					}
-
-					/* Total number where links are used on both sides */
-					total += leftcount*rightcount;
-
-					if (leftcount > 0) {
-						/* Evaluate using the left match, but not the right */
-						total += leftcount * do_count(mchxt, ctxt, w, rw, d->right, re, rcost);
-					}
-					if ((le == NULL) && (rightcount > 0)) {
-						/* Evaluate using the right match, but not the left */
-						total += rightcount * do_count(mchxt, ctxt, lw, w, le, d->left, lcost);
-					}
-
-					/* Sigh. Overflows can and do occur, esp for the ANY language. */
-					if (INT_MAX < total)
-					{
-						total = INT_MAX;
-						t->count = total;
-						put_match_list(mchxt, m1);
-						return total;
-					}
+				/* Sigh. Overflows can and do occur, esp for the ANY language. */
+				if (INT_MAX < *total)
+				{
+					*total = INT_MAX;
+					pop_match_list(mchxt, mlb);
+					return true;
 				}
 			}
 		}
-		put_match_list(mchxt, m1);
 	}
-	t->count = total;
-	return total;
+	pop_match_list(mchxt, mlb);
+	return false;
 }
 
+#ifdef USE_PTHREADS
+static int default_num_threads(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	if (0 < n) return (int) n;
+#endif
+	return 1;
+}
+
+/**
+ * Split the table into shards, if it is still empty.  (If it is not,
+ * it is left alone; it is then a single shard, which is still correct,
+ * only slower.)
+ */
+static void shard_table(count_context_t *ctxt)
+{
+	unsigned int shift, i;
+
+	if (0 != ctxt->log2_num_shards) return;
+	if (0 != ctxt->shard[0].table_entries) return;
+
+	shift = ctxt->shard[0].log2_table_size;
+	shift = (shift > MIN_LOG2_TABLE_SIZE + LOG2_PARALLEL_SHARDS) ?
+	        shift - LOG2_PARALLEL_SHARDS : MIN_LOG2_TABLE_SIZE;
+	free_shards(ctxt);
+	ctxt->shard = alloc_shards(LOG2_PARALLEL_SHARDS);
+	ctxt->log2_num_shards = LOG2_PARALLEL_SHARDS;
+	for (i = 0; i < (1U << LOG2_PARALLEL_SHARDS); i++)
+		clear_table(&ctxt->shard[i], shift);
+}
+
+static count_task_t * next_task(count_parallel_t *par)
+{
+	count_task_t *task = NULL;
+
+	pthread_mutex_lock(&par->lock);
+	if (!par->exhausted && (par->next_task < par->num_tasks))
+		task = &par->task[par->next_task++];
+	pthread_mutex_unlock(&par->lock);
+	return task;
+}
+
+static void * count_worker(void *arg)
+{
+	count_worker_t *cw = (count_worker_t *) arg;
+	count_parallel_t *par = cw->par;
+	count_task_t *task;
+
+	while ((task = next_task(par)) != NULL)
+	{
+		s64 total = 0;
+		do_count_word(cw->mchxt, &cw->ctxt, 0, par->rw, task->le, NULL,
+		              par->null_count, task->w, &total);
+		if (cw->ctxt.exhausted) break;
+	}
+	return NULL;
+}
+
+/**
+ * Fill the memo table with the counts of the subspans of the top-level
+ * span, on num_threads threads.  The count of the top-level span is
+ * then computed by do_count(), as usual.
+ */
+static void parallel_count(Sentence sent, fast_matcher_t *mchxt,
+                           count_context_t *ctxt, int null_count,
+                           int num_threads)
+{
+	count_parallel_t par;
+	count_worker_t *cw;
+	pthread_t *tid;
+	Disjunct *d;
+	size_t num_tasks = 0;
+	int rw = sent->length;
+	int w, i, started;
+
+	/* The connector hashes are computed on first use; do it now, so
+	 * that the threads only read them. */
+	for (w = 0; w < rw; w++)
+	{
+		for (d = sent->word[w].d; d != NULL; d = d->next)
+		{
+			Connector *c;
+			for (c = d->left; c != NULL; c = c->next) connector_hash(c);
+			for (c = d->right; c != NULL; c = c->next) connector_hash(c);
+		}
+	}
+
+	/* As in do_count(), the top-level span is split on the left wall,
+	 * using each of its disjuncts that has only right connectors. */
+	for (d = sent->word[0].d; d != NULL; d = d->next)
+	{
+		if ((NULL != d->left) || (NULL == d->right)) continue;
+		if (d->right->word < rw) num_tasks += rw - d->right->word;
+	}
+	if (0 == num_tasks) return;
+
+	par.task = (count_task_t *) xalloc(num_tasks * sizeof(count_task_t));
+	par.num_tasks = 0;
+	for (w = rw-1; w > 0; w--)
+	{
+		for (d = sent->word[0].d; d != NULL; d = d->next)
+		{
+			if ((NULL != d->left) || (NULL == d->right)) continue;
+			if (d->right->word > w) continue;
+			par.task[par.num_tasks].le = d->right;
+			par.task[par.num_tasks].w = w;
+			par.num_tasks++;
+		}
+	}
+	par.next_task = 0;
+	par.rw = rw;
+	par.null_count = null_count;
+	par.exhausted = ctxt->exhausted;
+	pthread_mutex_init(&par.lock, NULL);
+
+	shard_table(ctxt);
+
+	/* Thread 0 is the calling one; it alone checks the resources. */
+	cw = (count_worker_t *) xalloc(num_threads * sizeof(count_worker_t));
+	tid = (pthread_t *) xalloc(num_threads * sizeof(pthread_t));
+	for (i = 0; i < num_threads; i++)
+	{
+		cw[i].par = &par;
+		cw[i].ctxt = *ctxt;
+		cw[i].ctxt.parallel = &par;
+		if (0 == i)
+		{
+			cw[i].mchxt = mchxt;
+		}
+		else
+		{
+			cw[i].ctxt.current_resources = NULL;
+			cw[i].ctxt.checktimer = 0;
+			cw[i].mchxt = alloc_shared_fast_matcher(mchxt);
+		}
+	}
+
+	started = 1;
+	for (i = 1; i < num_threads; i++)
+	{
+		if (0 != pthread_create(&tid[i], NULL, count_worker, &cw[i])) break;
+		started++;
+	}
+	count_worker(&cw[0]);
+	for (i = 1; i < started; i++) pthread_join(tid[i], NULL);
 
-/** 
+	ctxt->exhausted = par.exhausted || cw[0].ctxt.exhausted;
+	ctxt->checktimer = cw[0].ctxt.checktimer;
+
+	for (i = 1; i < num_threads; i++) free_shared_fast_matcher(cw[i].mchxt);
+	xfree(tid, num_threads * sizeof(pthread_t));
+	xfree(cw, num_threads * sizeof(count_worker_t));
+	pthread_mutex_destroy(&par.lock);
+	xfree(par.task, num_tasks * sizeof(count_task_t));
+}
+#endif /* USE_PTHREADS */
+
+/**
  * Returns the number of ways the sentence can be parsed with the
  * specified null count. Assumes that the faster matcher and the count
  * context have already been initialized, and are freed later. The
@@ -406,6 +926,9 @@ static s64 do_count(fast_matcher_t *mchxt,
  *
  * The count returned here is mean to be completely accurate; it is
  * not an approximation!
+ *
+ * If the count_threads option asks for it, the counting of long
+ * sentences is spread over several threads; the count is the same.
  */
 s64 do_parse(Sentence sent,
              fast_matcher_t *mchxt,
@@ -424,6 +947,17 @@ s64 do_parse(Sentence sent,
 	/* ctxt->null_block = 1; */
 	ctxt->islands_ok = opts->islands_ok;
 
+#ifdef USE_PTHREADS
+	if ((1 != opts->count_threads) &&
+	    (MIN_PARALLEL_COUNT_LENGTH <= sent->length))
+	{
+		int num_threads = opts->count_threads;
+		if (0 >= num_threads) num_threads = default_num_threads();
+		if (1 < num_threads)
+			parallel_count(sent, mchxt, ctxt, null_count, num_threads);
+	}
+#endif
+
 	total = do_count(mchxt, ctxt, -1, sent->length, NULL, NULL, null_count+1);
 
 	ctxt->local_sent = NULL;
@@ -453,18 +987,95 @@ void delete_unmarked_disjuncts(Sentence sent)
 	}
 }
 
-/* sent_length is used only as a hint for the hash table size ... */
-count_context_t * alloc_count_context(size_t sent_length)
+/* The sentence disjuncts are used only as a hint for the hash table size */
+count_context_t * alloc_count_context(Sentence sent)
 {
 	count_context_t *ctxt = (count_context_t *) xalloc (sizeof(count_context_t));
 	memset(ctxt, 0, sizeof(count_context_t));
 
-	init_table(ctxt, sent_length);
+	init_table(ctxt, sent);
 	return ctxt;
 }
 
+/** Prepare a context for reuse with another sentence */
+void reset_count_context(count_context_t *ctxt, Sentence sent)
+{
+	init_table(ctxt, sent);
+}
+
+/**
+ * Drop the entries of the shard st whose span has a changed word.
+ * nchanged[w+1] is the number of changed words up to word w.
+ */
+static void forget_changed_spans(count_context_t *ctxt, count_table_t *st,
+                                 const unsigned int *nchanged, int length)
+{
+	unsigned int i, n = 0;
+	unsigned int mask = st->table_size - 1;
+
+	memset(st->table, 0, st->table_size * sizeof(unsigned int));
+	for (i = 0; i < st->table_entries; i++)
+	{
+		Table_connector *t = table_entry(st, i);
+		int lw = (t->lw < 0) ? 0 : t->lw;
+		int rw = (t->rw >= length) ? length-1 : t->rw;
+		unsigned int h;
+
+		if (nchanged[rw+1] != nchanged[lw]) continue;
+
+		h = table_index(ctxt, st,
+		                count_hash(t->lw, t->rw, t->le, t->re, t->cost));
+		while (0 != st->table[h]) h = (h + 1) & mask;
+		st->table[h] = n + 1;
+		if (n != i) *table_entry(st, n) = *t;
+		n++;
+	}
+	st->table_entries = n;
+}
+
+/**
+ * Prepare a context for reuse with the same sentence, after the
+ * disjuncts of some of its words have changed.  The count of a span
+ * depends only on the disjuncts of the words in it, from lw to rw,
+ * so only the counts of the spans that contain a changed word are
+ * forgotten.
+ */
+void update_count_context(count_context_t *ctxt, Sentence sent,
+                          const bool *changed)
+{
+	size_t w;
+	unsigned int i;
+	unsigned int *nchanged;
+
+	nchanged = (unsigned int *) xalloc((sent->length+1) * sizeof(unsigned int));
+	nchanged[0] = 0;
+	for (w = 0; w < sent->length; w++)
+		nchanged[w+1] = nchanged[w] + (changed[w] ? 1 : 0);
+
+	for (i = 0; i < (1U << ctxt->log2_num_shards); i++)
+		forget_changed_spans(ctxt, &ctxt->shard[i], nchanged, sent->length);
+
+	xfree(nchanged, (sent->length+1) * sizeof(unsigned int));
+}
+
+/** The memory held by the context, for deciding whether to keep it */
+size_t count_context_memory(const count_context_t *ctxt)
+{
+	unsigned int i;
+	size_t bytes = 0;
+
+	for (i = 0; i < (1U << ctxt->log2_num_shards); i++)
+	{
+		const count_table_t *st = &ctxt->shard[i];
+		bytes += st->table_size * sizeof(unsigned int) +
+		         st->block_array_size * sizeof(Table_connector *) +
+		         (size_t) st->num_blocks * TABLE_BLOCK_SIZE * sizeof(Table_connector);
+	}
+	return bytes;
+}
+
 void free_count_context(count_context_t *ctxt)
 {
-	free_table(ctxt);
+	free_shards(ctxt);
 	xfree(ctxt, sizeof(count_context_t));
 }
@@ -18,6 +18,9 @@ bool do_match(Connector *a, Connector *b, int wa, int wb);
 s64  do_parse(Sentence, fast_matcher_t*, count_context_t*, int null_count, Parse_Options);
 void delete_unmarked_disjuncts(Sentence sent);
 
-count_context_t* alloc_count_context(size_t);
+count_context_t* alloc_count_context(Sentence);
+void reset_count_context(count_context_t*, Sentence);
+void update_count_context(count_context_t*, Sentence, const bool *changed);
+size_t count_context_memory(const count_context_t*);
 void free_count_context(count_context_t*);
 
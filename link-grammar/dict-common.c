@@ -11,9 +11,13 @@
 /*                                                                       */
 /*************************************************************************/
 
+#include "affix-trie.h"
+#include "condesc.h"
 #include "dict-api.h"
 #include "dict-common.h"
+#include "disjunct-cache.h"
 #include "externs.h"
+#include "parse-cache.h"
 #include "pp_knowledge.h"
 #include "regex-morph.h"
 #include "spellcheck.h"
@@ -22,6 +26,8 @@
 #include "utilities.h"
 #include "word-utils.h"
 #include "dict-sql/read-sql.h"
+#include "dict-file/dict-binary.h"
+#include "dict-file/dict-index.h"
 #include "dict-file/read-dict.h"
 #include "dict-file/word-file.h"
 
@@ -128,6 +134,74 @@ const char * dictionary_get_lang(Dictionary dict)
 	return dict->lang;
 }
 
+/* ======================================================================== */
+/* Disjunct cache */
+
+/**
+ * Set the maximal number of disjuncts kept in the disjunct cache of
+ * the dictionary. Zero disables the cache.  The cache is not supported
+ * for SQL-backed dictionaries, for which this does nothing.
+ */
+void dictionary_set_disjunct_cache_size(Dictionary dict, size_t max_disjuncts)
+{
+	if (!dict || !dict->disjunct_cache) return;
+	disjunct_cache_set_size(dict->disjunct_cache, max_disjuncts);
+}
+
+size_t dictionary_get_disjunct_cache_size(Dictionary dict)
+{
+	if (!dict || !dict->disjunct_cache) return 0;
+	return disjunct_cache_get_size(dict->disjunct_cache);
+}
+
+size_t dictionary_get_disjunct_cache_hits(Dictionary dict)
+{
+	size_t hits = 0;
+	if (!dict || !dict->disjunct_cache) return 0;
+	disjunct_cache_get_stats(dict->disjunct_cache, &hits, NULL);
+	return hits;
+}
+
+size_t dictionary_get_disjunct_cache_misses(Dictionary dict)
+{
+	size_t misses = 0;
+	if (!dict || !dict->disjunct_cache) return 0;
+	disjunct_cache_get_stats(dict->disjunct_cache, NULL, &misses);
+	return misses;
+}
+
+/**
+ * Set the maximal number of sentences whose parse results are kept in
+ * the parse cache of the dictionary. Zero disables the cache.
+ */
+void dictionary_set_parse_cache_size(Dictionary dict, size_t max_sentences)
+{
+	if (!dict || !dict->parse_cache) return;
+	parse_cache_set_size(dict->parse_cache, max_sentences);
+}
+
+size_t dictionary_get_parse_cache_size(Dictionary dict)
+{
+	if (!dict || !dict->parse_cache) return 0;
+	return parse_cache_get_size(dict->parse_cache);
+}
+
+size_t dictionary_get_parse_cache_hits(Dictionary dict)
+{
+	size_t hits = 0;
+	if (!dict || !dict->parse_cache) return 0;
+	parse_cache_get_stats(dict->parse_cache, &hits, NULL);
+	return hits;
+}
+
+size_t dictionary_get_parse_cache_misses(Dictionary dict)
+{
+	size_t misses = 0;
+	if (!dict || !dict->parse_cache) return 0;
+	parse_cache_get_stats(dict->parse_cache, NULL, &misses);
+	return misses;
+}
+
 /* ======================================================================== */
 /* Dictionary lookup stuff */
 
@@ -314,8 +388,16 @@ static void free_dict_node_recursive(Dict_node * dn)
 
 static void free_dictionary(Dictionary dict)
 {
+	dict_index_delete(dict->index);
+	if (dict->binary)
+	{
+		/* All of it is in the arrays of the binary dictionary. */
+		dict_binary_delete(dict->binary);
+		return;
+	}
 	free_dict_node_recursive(dict->root);
 	free_Word_file(dict->word_file_header);
+	free_Word_file(dict->include_file_header);
 	free_Exp_list(dict->exp_list);
 }
 
@@ -326,6 +408,7 @@ static void affix_list_delete(Dictionary dict)
 	for (i=0, atc = dict->afdict_class; i < AFDICT_NUM_ENTRIES; i++, atc++)
 	{
 		if (atc->string) free(atc->string);
+		afdict_trie_delete(atc->trie);
 	}
 	free(dict->afdict_class);
 }
@@ -349,6 +432,25 @@ void dictionary_delete(Dictionary dict)
 	spellcheck_destroy(dict->spell_checker);
 
 	connector_set_delete(dict->unlimited_connector_set);
+	condesc_table_delete(dict->condesc_table);
+
+	if (dict->disjunct_cache != NULL) {
+		if (verbosity > 1) {
+			size_t hits, misses;
+			disjunct_cache_get_stats(dict->disjunct_cache, &hits, &misses);
+			prt_error("Info: Disjunct cache: %zu hits, %zu misses", hits, misses);
+		}
+		disjunct_cache_delete(dict->disjunct_cache);
+	}
+
+	if (dict->parse_cache != NULL) {
+		if (verbosity > 1) {
+			size_t hits, misses;
+			parse_cache_get_stats(dict->parse_cache, &hits, &misses);
+			prt_error("Info: Parse cache: %zu hits, %zu misses", hits, misses);
+		}
+		parse_cache_delete(dict->parse_cache);
+	}
 
 	if (dict->close) dict->close(dict);
 
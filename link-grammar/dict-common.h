@@ -23,8 +23,11 @@
 bool find_word_in_dict(Dictionary dict, const char *);
 Afdict_class * afdict_find(Dictionary, const char *, bool);
 
+/* The connector of the empty word */
+#define EMPTY_CONNECTOR "ZZZ"
+
 Exp * Exp_create(Dictionary);
-void add_empty_word(Dictionary, Dict_node *);
+Exp * add_empty_word(Dictionary, const char *, Exp *);
 
 void patch_subscript(char *);
 
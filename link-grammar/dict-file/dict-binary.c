@@ -0,0 +1,856 @@
+/*************************************************************************/
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+/**
+ * The binary dictionary.
+ *
+ * Reading 4.0.dict (and its word files) means lexing it a character at
+ * a time, building the expressions a node at a time and rebalancing the
+ * word tree.  dictionary_write_binary() saves the result - the word
+ * tree, the expressions and the strings - in a file with no pointers in
+ * it, and dict_binary_load() maps that file (read-only, so the pages
+ * are shared by all the processes that use it) instead of reading the
+ * text.  The word strings are used in place; the Dict_node, Exp and
+ * E_list structs are rebuilt in one pass over flat arrays, since the
+ * rest of the library uses them by pointer.
+ *
+ * The binary file records the size and the modification time of each
+ * text file it came from (the dict file, its #include's and its word
+ * files).  If any of them has changed, or the binary file is from
+ * another version of the library or another byte order, it is ignored
+ * and the text is read as usual.
+ *
+ * Only the main dictionary is saved.  The affix, regex and knowledge
+ * files are small, and the affix classes are derived from the main
+ * dictionary when it is loaded, so they are read as before.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#include "api-structures.h"
+#include "dict-api.h"
+#include "dict-binary.h"
+#include "dict-common.h"
+#include "read-dict.h"
+#include "string-set.h"
+#include "structures.h"
+#include "utilities.h"
+#include "word-file.h"
+
+#define LGDB_MAGIC "LGDICTB"
+#define LGDB_VERSION 1
+#define LGDB_BYTE_ORDER 0x01020304
+
+/* References that may be NULL are stored as index + 1, with 0 for NULL.
+ * Strings are stored as offsets into the string pool. */
+typedef struct
+{
+	char     magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t num_sources;
+	uint32_t num_word_files;
+	uint32_t num_includes;
+	uint32_t num_connectors;
+	uint32_t num_exps;
+	uint32_t num_elists;
+	uint32_t num_nodes;
+	uint32_t root;           /* Node index + 1 */
+	int32_t  num_entries;
+	uint32_t unused;
+	uint64_t sources;        /* File offsets of the sections */
+	uint64_t word_files;
+	uint64_t includes;
+	uint64_t connectors;
+	uint64_t exps;
+	uint64_t elists;
+	uint64_t nodes;
+	uint64_t strings;
+	uint64_t strings_size;
+	uint64_t file_size;
+} lgdb_header;
+
+typedef struct
+{
+	uint64_t size;
+	int64_t  mtime;
+	uint32_t name;
+	uint32_t unused;
+} lgdb_source;
+
+typedef struct
+{
+	double   cost;
+	uint32_t u;              /* Connector index, or E_list index + 1 */
+	uint8_t  type;
+	char     dir;
+	uint8_t  multi;
+	uint8_t  unused;
+} lgdb_exp;
+
+typedef struct
+{
+	uint32_t next;           /* E_list index + 1 */
+	uint32_t e;              /* Exp index */
+} lgdb_elist;
+
+typedef struct
+{
+	uint32_t string;
+	uint32_t file;           /* Word file index + 1 */
+	uint32_t exp;            /* Exp index */
+	uint32_t left;           /* Node index + 1 */
+	uint32_t right;          /* Node index + 1 */
+} lgdb_node;
+
+struct dict_binary_s
+{
+	const char * map;        /* The binary file contents */
+	size_t       map_size;
+	Dict_node *  nodes;
+	size_t       num_nodes;
+	Exp *        exps;
+	size_t       num_exps;
+	E_list *     elists;
+	size_t       num_elists;
+	Word_file *  word_files; /* The word files, then the #include'd ones */
+	size_t       num_word_files;
+};
+
+/* ======================================================== */
+/* Pointer to index map, for numbering the structs to save. */
+
+typedef struct
+{
+	const void * key;
+	uint32_t     val;
+} ptr_entry;
+
+typedef struct
+{
+	ptr_entry * table;
+	size_t      size;        /* A power of 2 */
+	size_t      count;
+} ptr_map;
+
+static size_t ptr_hash(const void * p, size_t mask)
+{
+	uintptr_t h = (uintptr_t) p >> 3;
+	return (size_t) ((h * 2654435761U) ^ (h >> 15)) & mask;
+}
+
+static void ptr_map_init(ptr_map * m)
+{
+	m->size = 1024;
+	m->count = 0;
+	m->table = (ptr_entry *) calloc(m->size, sizeof(ptr_entry));
+}
+
+static void ptr_map_free(ptr_map * m)
+{
+	free(m->table);
+}
+
+static bool ptr_map_get(const ptr_map * m, const void * key, uint32_t * val)
+{
+	size_t mask = m->size - 1;
+	size_t i;
+
+	for (i = ptr_hash(key, mask); NULL != m->table[i].key; i = (i + 1) & mask)
+	{
+		if (m->table[i].key == key)
+		{
+			*val = m->table[i].val;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void ptr_map_put(ptr_map * m, const void * key, uint32_t val)
+{
+	size_t mask, i;
+
+	if (2 * (m->count + 1) > m->size)
+	{
+		ptr_entry * old = m->table;
+		size_t old_size = m->size;
+
+		m->size *= 2;
+		m->count = 0;
+		m->table = (ptr_entry *) calloc(m->size, sizeof(ptr_entry));
+		for (i = 0; i < old_size; i++)
+			if (NULL != old[i].key) ptr_map_put(m, old[i].key, old[i].val);
+		free(old);
+	}
+
+	mask = m->size - 1;
+	for (i = ptr_hash(key, mask); NULL != m->table[i].key; i = (i + 1) & mask)
+		;
+	m->table[i].key = key;
+	m->table[i].val = val;
+	m->count++;
+}
+
+/* ======================================================== */
+/* Writing. */
+
+typedef struct
+{
+	const Dict_node ** nodes;
+	size_t num_nodes, max_nodes;
+	const Exp ** exps;
+	size_t num_exps, max_exps;
+	const E_list ** elists;
+	size_t num_elists, max_elists;
+	const char ** connectors;
+	size_t num_connectors, max_connectors;
+	const Word_file ** word_files;
+	size_t num_word_files, max_word_files;
+	char * strings;
+	size_t strings_size, max_strings;
+
+	ptr_map obj_map;         /* Nodes, Exps, E_lists and word files */
+	ptr_map conn_map;        /* Connector names */
+	ptr_map string_map;      /* Other strings */
+} writer;
+
+#define PUSH(w, arr, num, max, item) \
+	do { \
+		if ((w)->num == (w)->max) { \
+			(w)->max = (0 == (w)->max) ? 1024 : 2 * (w)->max; \
+			(w)->arr = realloc((w)->arr, (w)->max * sizeof(*(w)->arr)); \
+		} \
+		(w)->arr[(w)->num++] = (item); \
+	} while (0)
+
+static uint32_t add_string(writer * w, const char * s)
+{
+	uint32_t off;
+	size_t len;
+
+	if (ptr_map_get(&w->string_map, s, &off)) return off;
+
+	len = strlen(s) + 1;
+	while (w->strings_size + len > w->max_strings)
+	{
+		w->max_strings = (0 == w->max_strings) ? 65536 : 2 * w->max_strings;
+		w->strings = (char *) realloc(w->strings, w->max_strings);
+	}
+	off = (uint32_t) w->strings_size;
+	memcpy(w->strings + off, s, len);
+	w->strings_size += len;
+	ptr_map_put(&w->string_map, s, off);
+	return off;
+}
+
+static void add_exp(writer * w, const Exp * e)
+{
+	uint32_t idx;
+	E_list * l;
+
+	if (ptr_map_get(&w->obj_map, e, &idx)) return;
+	ptr_map_put(&w->obj_map, e, (uint32_t) w->num_exps);
+	PUSH(w, exps, num_exps, max_exps, e);
+
+	if (CONNECTOR_type == e->type)
+	{
+		if (!ptr_map_get(&w->conn_map, e->u.string, &idx))
+		{
+			ptr_map_put(&w->conn_map, e->u.string, (uint32_t) w->num_connectors);
+			PUSH(w, connectors, num_connectors, max_connectors, e->u.string);
+		}
+		return;
+	}
+
+	for (l = e->u.l; NULL != l; l = l->next)
+	{
+		ptr_map_put(&w->obj_map, l, (uint32_t) w->num_elists);
+		PUSH(w, elists, num_elists, max_elists, l);
+		add_exp(w, l->e);
+	}
+}
+
+static void add_nodes(writer * w, const Dict_node * dn)
+{
+	if (NULL == dn) return;
+
+	ptr_map_put(&w->obj_map, dn, (uint32_t) w->num_nodes);
+	PUSH(w, nodes, num_nodes, max_nodes, dn);
+	add_exp(w, dn->exp);
+	add_nodes(w, dn->left);
+	add_nodes(w, dn->right);
+}
+
+static uint32_t obj_ref(const writer * w, const void * p)
+{
+	uint32_t idx = 0;
+	if (NULL == p) return 0;
+	ptr_map_get(&w->obj_map, p, &idx);
+	return idx + 1;
+}
+
+/** Fill in the size and the modification time of a text file. */
+static bool stat_source(const char * name, lgdb_source * src)
+{
+	struct stat buf;
+	FILE * fp = dictopen(name, "r");
+
+	if (NULL == fp) return false;
+	if (0 != fstat(fileno(fp), &buf))
+	{
+		fclose(fp);
+		return false;
+	}
+	fclose(fp);
+
+	src->size = (uint64_t) buf.st_size;
+	src->mtime = (int64_t) buf.st_mtime;
+	return true;
+}
+
+static bool write_section(FILE * fp, const void * data, size_t size,
+                          uint64_t * offset)
+{
+	static const char zeros[8] = { 0 };
+	long pos = ftell(fp);
+	size_t pad = (8 - (pos % 8)) % 8;
+
+	if ((0 != pad) && (1 != fwrite(zeros, pad, 1, fp))) return false;
+	*offset = (uint64_t) (pos + pad);
+	if (0 == size) return true;
+	return 1 == fwrite(data, size, 1, fp);
+}
+
+static bool write_binary(writer * w, Dictionary dict, FILE * fp)
+{
+	lgdb_header hdr;
+	lgdb_source * sources;
+	uint32_t * word_files, * includes, * connectors;
+	lgdb_exp * exps;
+	lgdb_elist * elists;
+	lgdb_node * nodes;
+	const Word_file * wf;
+	size_t num_includes = 0, num_sources, i;
+	bool ok = false;
+
+	for (wf = dict->include_file_header; NULL != wf; wf = wf->next)
+		num_includes++;
+
+	/* The text files it all came from. */
+	num_sources = 1 + num_includes + w->num_word_files;
+	sources = (lgdb_source *) calloc(num_sources, sizeof(lgdb_source));
+	sources[0].name = add_string(w, dict->name);
+	i = 1;
+	includes = (uint32_t *) calloc(num_includes + 1, sizeof(uint32_t));
+	for (wf = dict->include_file_header; NULL != wf; wf = wf->next, i++)
+	{
+		includes[i-1] = add_string(w, wf->file);
+		sources[i].name = includes[i-1];
+	}
+	word_files = (uint32_t *) calloc(w->num_word_files + 1, sizeof(uint32_t));
+	for (; i < num_sources; i++)
+	{
+		word_files[i-1-num_includes] =
+			add_string(w, w->word_files[i-1-num_includes]->file);
+		sources[i].name = word_files[i-1-num_includes];
+	}
+	for (i = 0; i < num_sources; i++)
+	{
+		const char * name = w->strings + sources[i].name;
+		if (!stat_source(name, &sources[i]))
+		{
+			prt_error("Error: Could not open dictionary file %s", name);
+			free(sources);
+			free(includes);
+			free(word_files);
+			return false;
+		}
+	}
+
+	connectors = (uint32_t *) calloc(w->num_connectors + 1, sizeof(uint32_t));
+	for (i = 0; i < w->num_connectors; i++)
+		connectors[i] = add_string(w, w->connectors[i]);
+
+	exps = (lgdb_exp *) calloc(w->num_exps + 1, sizeof(lgdb_exp));
+	for (i = 0; i < w->num_exps; i++)
+	{
+		const Exp * e = w->exps[i];
+		exps[i].cost = e->cost;
+		exps[i].type = (uint8_t) e->type;
+		if (CONNECTOR_type == e->type)
+		{
+			/* dir and multi are not set in the other types. */
+			exps[i].dir = e->dir;
+			exps[i].multi = e->multi;
+			ptr_map_get(&w->conn_map, e->u.string, &exps[i].u);
+		}
+		else
+		{
+			exps[i].u = obj_ref(w, e->u.l);
+		}
+	}
+
+	elists = (lgdb_elist *) calloc(w->num_elists + 1, sizeof(lgdb_elist));
+	for (i = 0; i < w->num_elists; i++)
+	{
+		elists[i].next = obj_ref(w, w->elists[i]->next);
+		elists[i].e = obj_ref(w, w->elists[i]->e) - 1;
+	}
+
+	nodes = (lgdb_node *) calloc(w->num_nodes + 1, sizeof(lgdb_node));
+	for (i = 0; i < w->num_nodes; i++)
+	{
+		const Dict_node * dn = w->nodes[i];
+		nodes[i].string = add_string(w, dn->string);
+		nodes[i].file = obj_ref(w, dn->file);
+		nodes[i].exp = obj_ref(w, dn->exp) - 1;
+		nodes[i].left = obj_ref(w, dn->left);
+		nodes[i].right = obj_ref(w, dn->right);
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, LGDB_MAGIC, sizeof(hdr.magic));
+	hdr.version = LGDB_VERSION;
+	hdr.byte_order = LGDB_BYTE_ORDER;
+	hdr.num_sources = (uint32_t) num_sources;
+	hdr.num_word_files = (uint32_t) w->num_word_files;
+	hdr.num_includes = (uint32_t) num_includes;
+	hdr.num_connectors = (uint32_t) w->num_connectors;
+	hdr.num_exps = (uint32_t) w->num_exps;
+	hdr.num_elists = (uint32_t) w->num_elists;
+	hdr.num_nodes = (uint32_t) w->num_nodes;
+	hdr.root = obj_ref(w, dict->root);
+	hdr.num_entries = dict->num_entries;
+	hdr.strings_size = w->strings_size;
+
+	/* Write a placeholder header, then the sections, then the real
+	 * header with the section offsets. */
+	if ((1 == fwrite(&hdr, sizeof(hdr), 1, fp)) &&
+	    write_section(fp, sources, num_sources * sizeof(lgdb_source),
+	                  &hdr.sources) &&
+	    write_section(fp, word_files, w->num_word_files * sizeof(uint32_t),
+	                  &hdr.word_files) &&
+	    write_section(fp, includes, num_includes * sizeof(uint32_t),
+	                  &hdr.includes) &&
+	    write_section(fp, connectors, w->num_connectors * sizeof(uint32_t),
+	                  &hdr.connectors) &&
+	    write_section(fp, exps, w->num_exps * sizeof(lgdb_exp), &hdr.exps) &&
+	    write_section(fp, elists, w->num_elists * sizeof(lgdb_elist),
+	                  &hdr.elists) &&
+	    write_section(fp, nodes, w->num_nodes * sizeof(lgdb_node),
+	                  &hdr.nodes) &&
+	    write_section(fp, w->strings, w->strings_size, &hdr.strings))
+	{
+		hdr.file_size = (uint64_t) ftell(fp);
+		ok = (0 == fseek(fp, 0, SEEK_SET)) &&
+		     (1 == fwrite(&hdr, sizeof(hdr), 1, fp));
+	}
+
+	free(nodes);
+	free(elists);
+	free(exps);
+	free(connectors);
+	free(word_files);
+	free(includes);
+	free(sources);
+	return ok;
+}
+
+/**
+ * Save the word tree and the expressions of the dictionary in the
+ * binary file filename.  If filename is NULL, the binary file is
+ * written next to the dictionary file, with the name that
+ * dictionary_create_lang() looks for (e.g. "en/4.0.dict.bin").
+ * Returns false on error.
+ */
+bool dictionary_write_binary(Dictionary dict, const char * filename)
+{
+	writer w;
+	const Word_file * wf;
+	char * path;
+	char * tmp_name;
+	FILE * fp;
+	bool ok;
+
+	if ((NULL == dict) || (NULL == dict->root) ||
+	    (dict->lookup_list != lookup_list))
+	{
+		prt_error("Error: Only a dictionary read from a file can be saved");
+		return false;
+	}
+
+	if (NULL == filename)
+	{
+		char * dict_path = dict_file_path(dict->name);
+		if (NULL == dict_path)
+		{
+			prt_error("Error: Could not find dictionary %s", dict->name);
+			return false;
+		}
+		path = (char *) malloc(strlen(dict_path) + sizeof(DICT_BINARY_SUFFIX));
+		strcpy(path, dict_path);
+		strcat(path, DICT_BINARY_SUFFIX);
+		free(dict_path);
+	}
+	else
+	{
+		path = strdup(filename);
+	}
+
+	memset(&w, 0, sizeof(w));
+	ptr_map_init(&w.obj_map);
+	ptr_map_init(&w.conn_map);
+	ptr_map_init(&w.string_map);
+
+	for (wf = dict->word_file_header; NULL != wf; wf = wf->next)
+	{
+		ptr_map_put(&w.obj_map, wf, (uint32_t) w.num_word_files);
+		PUSH(&w, word_files, num_word_files, max_word_files, wf);
+	}
+	add_nodes(&w, dict->root);
+
+	/* Write to a temporary file, and rename it when complete, so that
+	 * processes that have the old one mapped are not disturbed. */
+	tmp_name = (char *) malloc(strlen(path) + sizeof(".tmp"));
+	strcpy(tmp_name, path);
+	strcat(tmp_name, ".tmp");
+	fp = fopen(tmp_name, "wb");
+	if (NULL == fp)
+	{
+		prt_error("Error: Could not create %s", tmp_name);
+		ok = false;
+	}
+	else
+	{
+		ok = write_binary(&w, dict, fp);
+		if (0 != fclose(fp)) ok = false;
+#ifdef _WIN32
+		if (ok) remove(path);
+#endif
+		if (ok && (0 != rename(tmp_name, path)))
+		{
+			prt_error("Error: Could not rename %s to %s", tmp_name, path);
+			ok = false;
+		}
+		if (!ok) remove(tmp_name);
+	}
+
+	ptr_map_free(&w.string_map);
+	ptr_map_free(&w.conn_map);
+	ptr_map_free(&w.obj_map);
+	free(w.strings);
+	free(w.word_files);
+	free(w.connectors);
+	free(w.elists);
+	free(w.exps);
+	free(w.nodes);
+	free(tmp_name);
+	free(path);
+	return ok;
+}
+
+/* ======================================================== */
+/* Loading. */
+
+static void unmap_file(const char * map, size_t size)
+{
+#ifdef _WIN32
+	free((void *) map);
+#else
+	munmap((void *) map, size);
+#endif
+}
+
+/**
+ * Map the whole file fp, read-only.
+ * On systems without mmap(), it is just read into memory.
+ */
+static const char * map_file(FILE * fp, size_t size)
+{
+#ifdef _WIN32
+	char * buf = (char *) malloc(size);
+	if ((NULL != buf) && (1 != fread(buf, size, 1, fp)))
+	{
+		free(buf);
+		buf = NULL;
+	}
+	return buf;
+#else
+	void * map = mmap(NULL, size, PROT_READ, MAP_SHARED, fileno(fp), 0);
+	if (MAP_FAILED == map) return NULL;
+	return (const char *) map;
+#endif
+}
+
+static bool section_ok(const lgdb_header * hdr, uint64_t offset,
+                       uint64_t num, size_t elsize)
+{
+	if (0 != (offset % 8)) return false;
+	if (offset > hdr->file_size) return false;
+	return num <= (hdr->file_size - offset) / elsize;
+}
+
+static bool header_ok(const lgdb_header * hdr, size_t file_size)
+{
+	if (0 != memcmp(hdr->magic, LGDB_MAGIC, sizeof(hdr->magic))) return false;
+	if (LGDB_VERSION != hdr->version) return false;
+	if (LGDB_BYTE_ORDER != hdr->byte_order) return false;
+	if (file_size != hdr->file_size) return false;
+	if (hdr->num_sources != 1 + hdr->num_includes + hdr->num_word_files)
+		return false;
+	if (hdr->root > hdr->num_nodes) return false;
+
+	return section_ok(hdr, hdr->sources, hdr->num_sources, sizeof(lgdb_source)) &&
+	       section_ok(hdr, hdr->word_files, hdr->num_word_files, sizeof(uint32_t)) &&
+	       section_ok(hdr, hdr->includes, hdr->num_includes, sizeof(uint32_t)) &&
+	       section_ok(hdr, hdr->connectors, hdr->num_connectors, sizeof(uint32_t)) &&
+	       section_ok(hdr, hdr->exps, hdr->num_exps, sizeof(lgdb_exp)) &&
+	       section_ok(hdr, hdr->elists, hdr->num_elists, sizeof(lgdb_elist)) &&
+	       section_ok(hdr, hdr->nodes, hdr->num_nodes, sizeof(lgdb_node)) &&
+	       section_ok(hdr, hdr->strings, hdr->strings_size, 1) &&
+	       (0 < hdr->strings_size);
+}
+
+/** Return true if none of the text files has changed. */
+static bool sources_fresh(const lgdb_header * hdr, const char * map)
+{
+	const lgdb_source * src = (const lgdb_source *) (map + hdr->sources);
+	const char * strings = map + hdr->strings;
+	uint32_t i;
+
+	for (i = 0; i < hdr->num_sources; i++)
+	{
+		lgdb_source now;
+
+		if (src[i].name >= hdr->strings_size) return false;
+		if (!stat_source(strings + src[i].name, &now)) return false;
+		if ((now.size != src[i].size) || (now.mtime != src[i].mtime))
+			return false;
+	}
+	return true;
+}
+
+static void free_binary(dict_binary_t * db)
+{
+	if (db->map) unmap_file(db->map, db->map_size);
+	if (db->nodes) xfree(db->nodes, (db->num_nodes + 1) * sizeof(Dict_node));
+	if (db->exps) xfree(db->exps, (db->num_exps + 1) * sizeof(Exp));
+	if (db->elists) xfree(db->elists, (db->num_elists + 1) * sizeof(E_list));
+	if (db->word_files)
+		xfree(db->word_files, (db->num_word_files + 1) * sizeof(Word_file));
+	xfree(db, sizeof(dict_binary_t));
+}
+
+/**
+ * Rebuild the structs of the dictionary from the mapped file.
+ * Returns false if the file is inconsistent.
+ */
+static bool build_dictionary(Dictionary dict, dict_binary_t * db,
+                             const lgdb_header * hdr)
+{
+	const char * map = db->map;
+	const char * strings = map + hdr->strings;
+	const uint32_t * wfname = (const uint32_t *) (map + hdr->word_files);
+	const uint32_t * incname = (const uint32_t *) (map + hdr->includes);
+	const uint32_t * connectors = (const uint32_t *) (map + hdr->connectors);
+	const lgdb_exp * exps = (const lgdb_exp *) (map + hdr->exps);
+	const lgdb_elist * elists = (const lgdb_elist *) (map + hdr->elists);
+	const lgdb_node * nodes = (const lgdb_node *) (map + hdr->nodes);
+	const char ** conn_string;
+	size_t i;
+	bool ok = true;
+
+	/* The pool ends with a NUL, so any offset into it is a string. */
+	if ('\0' != strings[hdr->strings_size - 1]) return false;
+#define STRING_OK(off) ((off) < hdr->strings_size)
+
+	db->num_word_files = hdr->num_word_files + hdr->num_includes;
+	db->word_files = (Word_file *)
+		xalloc((db->num_word_files + 1) * sizeof(Word_file));
+	for (i = 0; i < db->num_word_files; i++)
+	{
+		uint32_t name = (i < hdr->num_word_files) ?
+			wfname[i] : incname[i - hdr->num_word_files];
+		if (!STRING_OK(name)) return false;
+		safe_strcpy(db->word_files[i].file, strings + name,
+		            sizeof(db->word_files[i].file));
+		db->word_files[i].changed = false;
+		db->word_files[i].next = NULL;
+		if ((i + 1 != hdr->num_word_files) && (i + 1 < db->num_word_files))
+			db->word_files[i].next = &db->word_files[i+1];
+	}
+
+	/* The connector names are added to the string set, as the code
+	 * that reads the text does, so that they can be compared by
+	 * their address. */
+	conn_string = (const char **)
+		xalloc((hdr->num_connectors + 1) * sizeof(const char *));
+	for (i = 0; i < hdr->num_connectors; i++)
+	{
+		if (!STRING_OK(connectors[i])) { ok = false; break; }
+		conn_string[i] = string_set_add(strings + connectors[i], dict->string_set);
+	}
+
+	db->num_exps = hdr->num_exps;
+	db->exps = (Exp *) xalloc((db->num_exps + 1) * sizeof(Exp));
+	db->num_elists = hdr->num_elists;
+	db->elists = (E_list *) xalloc((db->num_elists + 1) * sizeof(E_list));
+	db->num_nodes = hdr->num_nodes;
+	db->nodes = (Dict_node *) xalloc((db->num_nodes + 1) * sizeof(Dict_node));
+
+	for (i = 0; ok && (i < db->num_exps); i++)
+	{
+		Exp * e = &db->exps[i];
+
+		e->next = (i + 1 < db->num_exps) ? &db->exps[i+1] : NULL;
+		e->type = (Exp_type) exps[i].type;
+		e->dir = exps[i].dir;
+		e->multi = exps[i].multi;
+		e->cost = exps[i].cost;
+		if (CONNECTOR_type == e->type)
+		{
+			if (exps[i].u >= hdr->num_connectors) { ok = false; break; }
+			e->u.string = conn_string[exps[i].u];
+		}
+		else if ((AND_type == e->type) || (OR_type == e->type))
+		{
+			if (exps[i].u > db->num_elists) { ok = false; break; }
+			e->u.l = (0 == exps[i].u) ? NULL : &db->elists[exps[i].u - 1];
+		}
+		else
+		{
+			ok = false;
+		}
+	}
+
+	for (i = 0; ok && (i < db->num_elists); i++)
+	{
+		E_list * l = &db->elists[i];
+
+		if ((elists[i].next > db->num_elists) || (elists[i].e >= db->num_exps))
+		{
+			ok = false;
+			break;
+		}
+		l->next = (0 == elists[i].next) ? NULL : &db->elists[elists[i].next - 1];
+		l->e = &db->exps[elists[i].e];
+	}
+
+	for (i = 0; ok && (i < db->num_nodes); i++)
+	{
+		Dict_node * dn = &db->nodes[i];
+
+		if (!STRING_OK(nodes[i].string) ||
+		    (nodes[i].file > hdr->num_word_files) ||
+		    (nodes[i].exp >= db->num_exps) ||
+		    (nodes[i].left > db->num_nodes) ||
+		    (nodes[i].right > db->num_nodes))
+		{
+			ok = false;
+			break;
+		}
+		dn->string = strings + nodes[i].string;
+		dn->file = (0 == nodes[i].file) ? NULL : &db->word_files[nodes[i].file - 1];
+		dn->exp = &db->exps[nodes[i].exp];
+		dn->left = (0 == nodes[i].left) ? NULL : &db->nodes[nodes[i].left - 1];
+		dn->right = (0 == nodes[i].right) ? NULL : &db->nodes[nodes[i].right - 1];
+	}
+#undef STRING_OK
+
+	xfree(conn_string, (hdr->num_connectors + 1) * sizeof(const char *));
+	if (!ok) return false;
+
+	dict->root = (0 == hdr->root) ? NULL : &db->nodes[hdr->root - 1];
+	dict->num_entries = hdr->num_entries;
+	dict->exp_list = (0 == db->num_exps) ? NULL : &db->exps[0];
+	dict->word_file_header = (0 == hdr->num_word_files) ? NULL : &db->word_files[0];
+	dict->include_file_header = (0 == hdr->num_includes) ?
+		NULL : &db->word_files[hdr->num_word_files];
+	return true;
+}
+
+/**
+ * Load the word tree and the expressions of dict from the binary file
+ * bin_name, if it exists and is up to date.  Returns false (leaving
+ * dict unchanged) if the text files should be read instead.
+ */
+bool dict_binary_load(Dictionary dict, const char * bin_name)
+{
+	struct stat buf;
+	dict_binary_t * db;
+	const lgdb_header * hdr;
+	FILE * fp;
+
+	fp = dictopen(bin_name, "rb");
+	if (NULL == fp) return false;
+
+	if ((0 != fstat(fileno(fp), &buf)) ||
+	    ((size_t) buf.st_size < sizeof(lgdb_header)))
+	{
+		fclose(fp);
+		return false;
+	}
+
+	db = (dict_binary_t *) xalloc(sizeof(dict_binary_t));
+	memset(db, 0, sizeof(dict_binary_t));
+	db->map_size = (size_t) buf.st_size;
+	db->map = map_file(fp, db->map_size);
+	fclose(fp);
+	if (NULL == db->map)
+	{
+		xfree(db, sizeof(dict_binary_t));
+		return false;
+	}
+
+	hdr = (const lgdb_header *) db->map;
+	if (!header_ok(hdr, db->map_size))
+	{
+		prt_error("Warning: Ignoring the invalid binary dictionary %s",
+		          bin_name);
+		free_binary(db);
+		return false;
+	}
+	if (!sources_fresh(hdr, db->map))
+	{
+		prt_error("Info: Binary dictionary %s is out of date; "
+		          "reading the text files", bin_name);
+		free_binary(db);
+		return false;
+	}
+	if (!build_dictionary(dict, db, hdr))
+	{
+		prt_error("Warning: Ignoring the invalid binary dictionary %s",
+		          bin_name);
+		dict->root = NULL;
+		dict->num_entries = 0;
+		dict->exp_list = NULL;
+		dict->word_file_header = NULL;
+		dict->include_file_header = NULL;
+		free_binary(db);
+		return false;
+	}
+
+	dict->binary = db;
+	return true;
+}
+
+void dict_binary_delete(dict_binary_t * db)
+{
+	if (NULL == db) return;
+	free_binary(db);
+}
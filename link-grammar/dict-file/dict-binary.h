@@ -0,0 +1,23 @@
+/*************************************************************************/
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+#ifndef _LG_DICT_BINARY_H_
+#define _LG_DICT_BINARY_H_
+
+#include "api-types.h"
+#include "link-includes.h"
+
+/* The binary dictionary of "en/4.0.dict" is "en/4.0.dict.bin". */
+#define DICT_BINARY_SUFFIX ".bin"
+
+bool dict_binary_load(Dictionary, const char * bin_name);
+void dict_binary_delete(dict_binary_t *);
+
+#endif /* _LG_DICT_BINARY_H_ */
@@ -0,0 +1,178 @@
+/*************************************************************************/
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+/**
+ * The word index of a file-backed dictionary.
+ *
+ * Looking a word up in the dictionary tree compares it with a string
+ * at every level, and the lookup list that is returned is a copy of
+ * the matching nodes, allocated one by one.  Once the dictionary has
+ * been read, the tree does not change any more, so an index is built
+ * instead: all the nodes, in tree order, in one array, in which the
+ * entries of a word ("make", "make.n", "make.v", ...) are next to each
+ * other, and a hash table that maps the word without its subscript to
+ * the slice of the array that holds them.  A lookup hashes the word
+ * once and returns that slice (a Dict_view), without allocating.
+ */
+
+#include <string.h>
+
+#include "dict-index.h"
+#include "utilities.h"
+
+typedef struct
+{
+	unsigned int start;    /* Of the entries of the word, in entry[] */
+	unsigned int num;      /* 0 for an empty slot */
+} index_slot_t;
+
+struct dict_index_s
+{
+	Dict_node ** entry;    /* All the dictionary nodes, in tree order */
+	size_t num_entries;
+	index_slot_t * slot;   /* Hash table of the words */
+	size_t size;           /* A power of 2 */
+};
+
+/** The length of the word, without its subscript. */
+static inline size_t bare_length(const char * s)
+{
+	const char * p = s;
+	while ((*p != '\0') && (*p != SUBSCRIPT_MARK)) p++;
+	return p - s;
+}
+
+/** FNV-1a */
+static inline unsigned int bare_hash(const char * s, size_t len)
+{
+	unsigned int h = 2166136261U;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+	{
+		h ^= (unsigned char) s[i];
+		h *= 16777619U;
+	}
+	return h;
+}
+
+static inline bool bare_equal(const char * t, const char * s, size_t len)
+{
+	return (0 == strncmp(t, s, len)) &&
+	       (('\0' == t[len]) || (SUBSCRIPT_MARK == t[len]));
+}
+
+static size_t count_nodes(Dict_node * dn)
+{
+	if (NULL == dn) return 0;
+	return 1 + count_nodes(dn->left) + count_nodes(dn->right);
+}
+
+static void list_nodes(Dict_node * dn, Dict_node ** entry, size_t * n)
+{
+	if (NULL == dn) return;
+	list_nodes(dn->left, entry, n);
+	entry[(*n)++] = dn;
+	list_nodes(dn->right, entry, n);
+}
+
+/**
+ * Index the dictionary tree.  The tree is ordered by dict_order_strict(),
+ * in which the subscript mark sorts before any other character, so the
+ * entries of a word are consecutive in tree order.
+ */
+dict_index_t * dict_index_create(Dict_node * root)
+{
+	dict_index_t * di;
+	size_t i, j, num_words, n = 0;
+
+	di = (dict_index_t *) xalloc(sizeof(dict_index_t));
+	di->num_entries = count_nodes(root);
+	di->entry = (Dict_node **) xalloc(di->num_entries * sizeof(Dict_node *));
+	list_nodes(root, di->entry, &n);
+
+	num_words = 0;
+	for (i = 0; i < di->num_entries; i = j)
+	{
+		size_t len = bare_length(di->entry[i]->string);
+		for (j = i+1; j < di->num_entries; j++)
+			if (!bare_equal(di->entry[j]->string, di->entry[i]->string, len)) break;
+		num_words++;
+	}
+
+	/* Keep the table at most half full. */
+	for (di->size = 16; di->size < 2 * num_words; di->size *= 2)
+		;
+	di->slot = (index_slot_t *) xalloc(di->size * sizeof(index_slot_t));
+	memset(di->slot, 0, di->size * sizeof(index_slot_t));
+
+	for (i = 0; i < di->num_entries; i = j)
+	{
+		const char * s = di->entry[i]->string;
+		size_t len = bare_length(s);
+		size_t h = bare_hash(s, len) & (di->size - 1);
+
+		for (j = i+1; j < di->num_entries; j++)
+			if (!bare_equal(di->entry[j]->string, s, len)) break;
+
+		while (0 != di->slot[h].num) h = (h + 1) & (di->size - 1);
+		di->slot[h].start = i;
+		di->slot[h].num = j - i;
+	}
+
+	return di;
+}
+
+void dict_index_delete(dict_index_t * di)
+{
+	if (NULL == di) return;
+	xfree(di->slot, di->size * sizeof(index_slot_t));
+	xfree(di->entry, di->num_entries * sizeof(Dict_node *));
+	xfree(di, sizeof(dict_index_t));
+}
+
+/**
+ * Return the entries that match s, as abridged_lookup_list() matches
+ * them, but including the idioms: if s has no subscript, all the
+ * entries of the word, else only the one with the same subscript.
+ */
+Dict_view dict_index_lookup(const dict_index_t * di, const char * s)
+{
+	Dict_view view = {NULL, 0};
+	size_t len = bare_length(s);
+	size_t h = bare_hash(s, len) & (di->size - 1);
+
+	for (; 0 != di->slot[h].num; h = (h + 1) & (di->size - 1))
+	{
+		Dict_node * const * dn = &di->entry[di->slot[h].start];
+		size_t i;
+
+		if (!bare_equal(dn[0]->string, s, len)) continue;
+
+		if ('\0' == s[len])
+		{
+			view.dn = dn;
+			view.num = di->slot[h].num;
+			return view;
+		}
+
+		for (i = 0; i < di->slot[h].num; i++)
+		{
+			if (0 == strcmp(dn[i]->string, s))
+			{
+				view.dn = &dn[i];
+				view.num = 1;
+				return view;
+			}
+		}
+		return view;
+	}
+	return view;
+}
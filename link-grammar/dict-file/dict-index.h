@@ -0,0 +1,33 @@
+/*************************************************************************/
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+#ifndef _LG_DICT_INDEX_H_
+#define _LG_DICT_INDEX_H_
+
+#include "api-types.h"
+#include "structures.h"
+
+/**
+ * A view of the dictionary entries of a word.  It is borrowed from the
+ * index: it is not freed, and it is valid as long as the dictionary.
+ * The entries are in the order of the dictionary tree, and their right
+ * pointers are those of the tree, not a lookup list.
+ */
+typedef struct
+{
+	Dict_node * const * dn;
+	size_t num;
+} Dict_view;
+
+dict_index_t * dict_index_create(Dict_node * root);
+void dict_index_delete(dict_index_t *);
+Dict_view dict_index_lookup(const dict_index_t *, const char * s);
+
+#endif /* _LG_DICT_INDEX_H_ */
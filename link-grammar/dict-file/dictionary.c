@@ -11,14 +11,20 @@
 /*                                                                       */
 /*************************************************************************/
 
+#include "affix-trie.h"
 #ifdef USE_ANYSPLIT
 #include "anysplit.h"
 #endif
 #include "api-structures.h"
+#include "condesc.h"
 #include "dict-api.h"
+#include "dict-binary.h"
+#include "dict-index.h"
 #include "dict-common.h"
+#include "disjunct-cache.h"
 #include "externs.h"
 #include "idiom.h"
+#include "parse-cache.h"
 #include "pp_knowledge.h"
 #include "read-dict.h"
 #include "read-regex.h"
@@ -361,6 +367,7 @@ static bool afdict_init(Dictionary dict)
 		afdict->regex_root = sm_re;
 		sm_re->name = strdup(afdict_classname[AFDICT_SANEMORPHISM]);
 		sm_re->re = NULL;
+		sm_re->matcher = NULL;
 		sm_re->next = NULL;
 		rc = compile_regexs(afdict->regex_root, afdict);
 		if (rc) {
@@ -396,6 +403,15 @@ static bool afdict_init(Dictionary dict)
 	}
 #endif /* AFDICT_ORDER_NOT_PRESERVED */
 
+	/* The affixes that suffix_split() and mprefix_split() strip are
+	 * looked up in tries, the suffixes from the end of the word. */
+	ac = AFCLASS(afdict, AFDICT_PRE);
+	ac->trie = afdict_trie_create(ac, false);
+	ac = AFCLASS(afdict, AFDICT_SUF);
+	ac->trie = afdict_trie_create(ac, true);
+	ac = AFCLASS(afdict, AFDICT_MPRE);
+	ac->trie = afdict_trie_create(ac, false);
+
 	if (! afdict_to_wide(afdict, AFDICT_QUOTES)) return false;
 	if (! afdict_to_wide(afdict, AFDICT_BULLETS)) return false;
 
@@ -425,12 +441,14 @@ dictionary_six(const char * lang, const char * dict_name,
                const char * pp_name, const char * cons_name,
                const char * affix_name, const char * regex_name);
 /**
- * Read dictionary entries from a wide-character string "input".
- * All other parts are read from files.
+ * Read dictionary entries from a wide-character string "input",
+ * or from the binary dictionary bin_name if it is not NULL and is
+ * up to date.  All other parts are read from files.
  */
 static Dictionary
 dictionary_six_str(const char * lang,
                    const char * input,
+                   const char * bin_name,
                    const char * dict_name,
                    const char * pp_name, const char * cons_name,
                    const char * affix_name, const char * regex_name)
@@ -449,6 +467,9 @@ dictionary_six_str(const char * lang,
 	dict->root = NULL;
 	dict->regex_root = NULL;
 	dict->word_file_header = NULL;
+	dict->include_file_header = NULL;
+	dict->binary = NULL;
+	dict->index = NULL;
 	dict->exp_list = NULL;
 	dict->affix_table = NULL;
 	dict->recursive_error = false;
@@ -500,21 +521,33 @@ dictionary_six_str(const char * lang,
 			dict->afdict_class[i].mem_elems = 0;
 			dict->afdict_class[i].length = 0;
 			dict->afdict_class[i].string = NULL;
+			dict->afdict_class[i].trie = NULL;
 		}
 	}
 	dict->affix_table = NULL;
 
-	/* Read dictionary from the input string. */
-	dict->input = input;
-	dict->pin = dict->input;
-	if (!read_dictionary(dict))
+	if ((NULL != bin_name) && dict_binary_load(dict, bin_name))
 	{
+		lgdebug(+1, "Dictionary %s read from %s\n", dict->name, bin_name);
+	}
+	else
+	{
+		/* Read dictionary from the input string. */
+		dict->input = input;
+		dict->pin = dict->input;
+		if (!read_dictionary(dict))
+		{
+			dict->pin = NULL;
+			dict->input = NULL;
+			goto failure;
+		}
 		dict->pin = NULL;
 		dict->input = NULL;
-		goto failure;
 	}
-	dict->pin = NULL;
-	dict->input = NULL;
+
+	/* The word tree is complete; look words up through an index of it. */
+	if (dict->lookup_list == lookup_list)
+		dict->index = dict_index_create(dict->root);
 
 	if (NULL == affix_name)
 	{
@@ -546,6 +579,8 @@ dictionary_six_str(const char * lang,
 	dict->right_wall_defined = boolean_dictionary_lookup(dict, RIGHT_WALL_WORD);
 
 	dict->empty_word_defined = boolean_dictionary_lookup(dict, EMPTY_WORD_MARK);
+	if (dict->empty_word_defined)
+		string_set_add(EMPTY_CONNECTOR, dict->string_set);
 
 	dict->base_knowledge  = pp_knowledge_open(pp_name);
 	dict->hpsg_knowledge  = pp_knowledge_open(cons_name);
@@ -561,9 +596,15 @@ dictionary_six_str(const char * lang,
 	}
 	free_lookup(dict_node);
 
+	dict->condesc_table = condesc_table_create(dict);
+	dict->disjunct_cache = disjunct_cache_create(DISJUNCT_CACHE_DEFAULT_SIZE);
+	dict->parse_cache = parse_cache_create(PARSE_CACHE_DEFAULT_SIZE);
+
 	return dict;
 
 failure:
+	dict_index_delete(dict->index);
+	dict_binary_delete(dict->binary);
 	string_set_delete(dict->string_set);
 	if (dict->affix_table) xfree(dict->affix_table, sizeof(struct Dictionary_s));
 	xfree(dict, sizeof(struct Dictionary_s));
@@ -579,6 +620,7 @@ dictionary_six(const char * lang, const char * dict_name,
                const char * affix_name, const char * regex_name)
 {
 	Dictionary dict;
+	char * bin_name = NULL;
 
 	char* input = get_file_contents(dict_name);
 	if (NULL == input)
@@ -587,9 +629,18 @@ dictionary_six(const char * lang, const char * dict_name,
 		return NULL;
 	}
 
-	dict = dictionary_six_str(lang, input, dict_name, pp_name,
+	/* Only the main dictionary may have a binary version. */
+	if (NULL != affix_name)
+	{
+		bin_name = (char *) malloc(strlen(dict_name) + sizeof(DICT_BINARY_SUFFIX));
+		strcpy(bin_name, dict_name);
+		strcat(bin_name, DICT_BINARY_SUFFIX);
+	}
+
+	dict = dictionary_six_str(lang, input, bin_name, dict_name, pp_name,
 				  cons_name, affix_name, regex_name);
 
+	free(bin_name);
 	free(input);
 	return dict;
 }
@@ -646,12 +697,12 @@ Dictionary dictionary_create_from_utf8(const char * input)
 
 	lang = get_default_locale();
 	if (lang && *lang) {
-		dictionary = dictionary_six_str(lang, input, "string",
+		dictionary = dictionary_six_str(lang, input, NULL, "string",
 		                                NULL, NULL, NULL, NULL);
 		free(lang);
 	} else {
 		/* Default to en when locales are broken (e.g. WIN32) */
-		dictionary = dictionary_six_str("en", input, "string",
+		dictionary = dictionary_six_str("en", input, NULL, "string",
 		                                NULL, NULL, NULL, NULL);
 	}
 
@@ -16,6 +16,7 @@
 #include "build-disjuncts.h"
 #include "dict-api.h"
 #include "dict-common.h"
+#include "dict-index.h"
 #include "disjunct-utils.h"
 #include "error.h"
 #include "print.h"
@@ -691,6 +692,28 @@ rdictionary_lookup(Dict_node *llist,
 	return llist;
 }
 
+/**
+ * Copy the entries of the view into a lookup list, in the same order
+ * as rdictionary_lookup() would list them.
+ */
+static Dict_node * view_to_list(Dict_view view, bool match_idiom)
+{
+	Dict_node * llist = NULL;
+	size_t i;
+
+	for (i = view.num; i > 0; i--)
+	{
+		Dict_node * dn_new;
+
+		if (!match_idiom && is_idiom_word(view.dn[i-1]->string)) continue;
+		dn_new = dict_node_new();
+		*dn_new = *view.dn[i-1];
+		dn_new->right = llist;
+		llist = dn_new;
+	}
+	return llist;
+}
+
 /**
  * lookup_list() - return list of words in the file-backed dictionary.
  *
@@ -705,16 +728,26 @@ rdictionary_lookup(Dict_node *llist,
  */
 Dict_node * lookup_list(Dictionary dict, const char *s)
 {
-	Dict_node * llist =
-		rdictionary_lookup(NULL, dict->root, s, true, dict_order_bare);
+	Dict_node * llist;
+
+	if (NULL != dict->index)
+		return view_to_list(dict_index_lookup(dict->index, s), true);
+
+	llist = rdictionary_lookup(NULL, dict->root, s, true, dict_order_bare);
 	llist = prune_lookup_list(llist, s);
 	return llist;
 }
 
 bool boolean_lookup(Dictionary dict, const char *s)
 {
-	Dict_node *llist = lookup_list(dict, s);
-	bool boool = (llist != NULL);
+	Dict_node *llist;
+	bool boool;
+
+	if (NULL != dict->index)
+		return 0 != dict_index_lookup(dict->index, s).num;
+
+	llist = lookup_list(dict, s);
+	boool = (llist != NULL);
 	free_lookup(llist);
 	return boool;
 }
@@ -766,6 +799,10 @@ static Dict_node * dictionary_lookup_wild(Dictionary dict, const char *s)
 Dict_node * abridged_lookup_list(Dictionary dict, const char *s)
 {
 	Dict_node *llist;
+
+	if (NULL != dict->index)
+		return view_to_list(dict_index_lookup(dict->index, s), false);
+
 	llist = rdictionary_lookup(NULL, dict->root, s, false, dict_order_bare);
 	llist = prune_lookup_list(llist, s);
 	return llist;
@@ -977,8 +1014,6 @@ static Exp * make_connector(Dictionary dict)
 /* ======================================================================== */
 /* Empty-word handling. */
 
-#define EMPTY_CONNECTOR "ZZZ"
-
 /**
  * Insert empty-word connectors.
  *
@@ -1004,57 +1039,79 @@ static Exp * make_connector(Dictionary dict)
  *
  * Note that the printing of ZZZ connectors is suppressed in print.c,
  * although API users will see this link.
+ *
+ * Returns the expression e of the word, wrapped as described above if
+ * the word qualifies.  e must be a private copy of the dictionary
+ * expression.
  */
 
-void add_empty_word(Dictionary dict, Dict_node * dn)
+Exp * add_empty_word(Dictionary dict, const char * word, Exp * e)
 {
 	size_t len;
-	Exp *zn, *an;
+	Exp *zn, *on, *an;
 	E_list *elist, *flist;
 	/* We assume the affix file has been read by now, so INFIX_MARK is set */
 	char infix_mark = INFIX_MARK(dict->affix_table);
 
-	if (! dict->empty_word_defined) return;
+	if (! dict->empty_word_defined) return e;
 
-	if (is_stem(dn->string)) return;
-	len = strlen(dn->string);
-	if ((len > 1) && (infix_mark == dn->string[0])) return;
-	if ((len > 1) && (infix_mark == dn->string[len-1])) return;
-	if (0 == strcmp(dn->string, LEFT_WALL_WORD)) return;
-	if (0 == strcmp(dn->string, RIGHT_WALL_WORD)) return;
-	//lgdebug(+0, "Processing '%s'\n", dn->string);
+	if (is_stem(word)) return e;
+	len = strlen(word);
+	if ((len > 1) && (infix_mark == word[0])) return e;
+	if ((len > 1) && (infix_mark == word[len-1])) return e;
+	if (0 == strcmp(word, LEFT_WALL_WORD)) return e;
+	if (0 == strcmp(word, RIGHT_WALL_WORD)) return e;
+	//lgdebug(+0, "Processing '%s'\n", word);
 
 	/* If we are here, then this appears to be not a stem, not a
 	 * suffix, and not an idiom word.
-	 * Create {ZZZ+} & (plain-word-exp). */
+	 * Create {ZZZ+} & (plain-word-exp).
+	 * The new nodes are not linked into the dict->exp_list, and the
+	 * dictionary is not otherwise modified, since it may be shared
+	 * by several threads.  They are freed along with e. */
 
-	/* zn points at {ZZZ+} */
-	zn = Exp_create(dict);
+	/* zn points at ZZZ+ */
+	zn = (Exp *) xalloc(sizeof(Exp));
 	zn->dir = '+';
-	zn->u.string = string_set_add(EMPTY_CONNECTOR, dict->string_set);
+	zn->u.string = string_set_lookup(EMPTY_CONNECTOR, dict->string_set);
 	zn->multi = false;
 	zn->type = CONNECTOR_type;
 	zn->cost = 0.0;
-	zn = make_optional_node(dict, zn);
+
+	/* on will be {ZZZ+}, i.e. (() or ZZZ+) */
+	flist = (E_list *) xalloc(sizeof(E_list));
+	flist->next = NULL;
+	flist->e = zn;
+
+	elist = (E_list *) xalloc(sizeof(E_list));
+	elist->next = flist;
+	elist->e = (Exp *) xalloc(sizeof(Exp));
+	elist->e->type = AND_type;
+	elist->e->cost = 0.0;
+	elist->e->u.l = NULL;
+
+	on = (Exp *) xalloc(sizeof(Exp));
+	on->type = OR_type;
+	on->cost = 0.0;
+	on->u.l = elist;
 
 	/* flist is plain-word-exp */
 	flist = (E_list *) xalloc(sizeof(E_list));
 	flist->next = NULL;
-	flist->e = dn->exp;
+	flist->e = e;
 
 	/* elist is {ZZZ+} */
 	elist = (E_list *) xalloc(sizeof(E_list));
 	elist->next = flist;
-	elist->e = zn;
+	elist->e = on;
 
 	/* an will be {ZZZ+} & (plain-word-exp) */
-	an = Exp_create(dict);
+	an = (Exp *) xalloc(sizeof(Exp));
 	an->type = AND_type;
 	an->cost = 0.0;
 	an->u.l = elist;
 
-	/* replace the plain-word-exp with {ZZZ+} & (plain-word-exp) */
-	dn->exp = an;
+	return an;
 }
 
 /* ======================================================================== */
@@ -1659,6 +1716,16 @@ static bool read_entry(Dictionary dict)
 			dict->line_number    = save_line_number;
 
 			free(instr);
+			if (rc)
+			{
+				/* Remember it, for checking if a binary dictionary
+				 * is up to date. */
+				Word_file * inc = (Word_file *) xalloc(sizeof(Word_file));
+				safe_strcpy(inc->file, dict_name, sizeof(inc->file));
+				inc->changed = false;
+				inc->next = dict->include_file_header;
+				dict->include_file_header = inc;
+			}
 			free(dict_name);
 			if (!rc) goto syntax_error;
 
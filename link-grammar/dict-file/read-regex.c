@@ -146,6 +146,7 @@ int read_regex_file(Dictionary dict, const char *file_name)
 		new_re->name    = strdup(name);
 		new_re->pattern = strdup(regex);
 		new_re->re      = NULL;
+		new_re->matcher = NULL;
 		new_re->next    = NULL;
 		*tail = new_re;
 		tail	= &new_re->next;
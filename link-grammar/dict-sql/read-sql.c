@@ -24,6 +24,7 @@
 #include "dict-common.h"
 #include "dict-structures.h"
 #include "externs.h"
+#include "parse-cache.h"
 #include "spellcheck.h"
 #include "string-set.h"
 #include "structures.h"
@@ -349,6 +350,8 @@ Dictionary dictionary_create_from_db(const char *lang)
 	dict->right_wall_defined = boolean_dictionary_lookup(dict, RIGHT_WALL_WORD);
 
 	dict->empty_word_defined = boolean_dictionary_lookup(dict, EMPTY_WORD_MARK);
+	if (dict->empty_word_defined)
+		string_set_add(EMPTY_CONNECTOR, dict->string_set);
 
 	dict->unknown_word_defined = boolean_dictionary_lookup(dict, UNKNOWN_WORD);
 	dict->use_unknown_word = true;
@@ -361,6 +364,8 @@ Dictionary dictionary_create_from_db(const char *lang)
 	}
 	free_lookup_list(dict, dict_node);
 
+	dict->parse_cache = parse_cache_create(PARSE_CACHE_DEFAULT_SIZE);
+
 	return dict;
 }
 
@@ -0,0 +1,434 @@
+/*************************************************************************/
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+/**
+ * Per-dictionary cache of expanded word disjuncts.
+ *
+ * Expanding the expressions of the sentence words into disjuncts is
+ * a noticeable part of preparing a sentence for parsing, and the same
+ * common words are expanded over and over again, for every sentence.
+ * This cache keeps the expanded disjunct lists, with the duplicates
+ * already removed, so that they can be reused across sentences.
+ *
+ * The disjuncts are built after expression_prune() has removed from
+ * the word expressions the connectors that cannot possibly match
+ * anything in the sentence.  The expanded list thus depends on which
+ * connectors survived, and not only on the word itself.  The cache key
+ * is therefore made of the dictionary expression (its address), the
+ * disjunct cost cutoff, and the sequence of connectors that remained
+ * in the pruned expression.  Given the dictionary expression, that
+ * sequence fully determines the pruned expression, and so the result
+ * is exactly the list that would have been built without the cache.
+ *
+ * The cached disjuncts are never handed out directly; each use gets
+ * a fresh copy, so that pruning and parsing may modify them freely.
+ *
+ * The cache is bounded by the total number of disjuncts it holds;
+ * the least recently used entries are discarded first.  It is
+ * protected by a mutex, so that a dictionary may be shared by
+ * several threads.
+ *
+ * Dictionary expressions must live as long as the dictionary does,
+ * since their addresses are used in the keys.  This is not the case
+ * for the SQL-backed dictionaries, which thus don't have a cache.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "build-disjuncts.h"
+#include "condesc.h"
+#include "disjunct-cache.h"
+#include "disjunct-utils.h"
+#include "utilities.h"
+#include "word-utils.h"
+
+/* One connector of the pruned expression. */
+typedef struct
+{
+	const char * string;
+	char dir;
+} conn_key;
+
+typedef struct dcache_entry_s dcache_entry;
+struct dcache_entry_s
+{
+	/* The key */
+	const Exp *    exp;          /* The dictionary expression */
+	bool           empty_word;   /* It was wrapped by add_empty_word() */
+	double         cost_cutoff;
+	conn_key *     conn;         /* Connectors of the pruned expression */
+	size_t         num_conn;
+	unsigned int   hash;
+
+	Disjunct *     dj;           /* Its disjuncts, without duplicates */
+	size_t         num_disjuncts;
+
+	dcache_entry * next;         /* Hash chain */
+	dcache_entry * newer;        /* LRU list */
+	dcache_entry * older;
+};
+
+struct disjunct_cache_s
+{
+	size_t          max_disjuncts;
+	size_t          num_disjuncts;
+	size_t          num_entries;
+	size_t          table_size;  /* A power of 2 */
+	dcache_entry ** table;
+	dcache_entry *  newest;
+	dcache_entry *  oldest;
+	size_t          hits;
+	size_t          misses;
+#ifdef USE_PTHREADS
+	pthread_mutex_t lock;
+#endif
+};
+
+#define DCACHE_INITIAL_TABLE_SIZE 512
+
+static inline void dcache_lock(disjunct_cache_t *dc)
+{
+#ifdef USE_PTHREADS
+	pthread_mutex_lock(&dc->lock);
+#endif
+}
+
+static inline void dcache_unlock(disjunct_cache_t *dc)
+{
+#ifdef USE_PTHREADS
+	pthread_mutex_unlock(&dc->lock);
+#endif
+}
+
+disjunct_cache_t * disjunct_cache_create(size_t max_disjuncts)
+{
+	disjunct_cache_t *dc;
+
+	dc = (disjunct_cache_t *) xalloc(sizeof(disjunct_cache_t));
+	memset(dc, 0, sizeof(disjunct_cache_t));
+	dc->max_disjuncts = max_disjuncts;
+	dc->table_size = DCACHE_INITIAL_TABLE_SIZE;
+	dc->table = (dcache_entry **) xalloc(dc->table_size * sizeof(dcache_entry *));
+	memset(dc->table, 0, dc->table_size * sizeof(dcache_entry *));
+#ifdef USE_PTHREADS
+	pthread_mutex_init(&dc->lock, NULL);
+#endif
+	return dc;
+}
+
+static void entry_delete(dcache_entry *ce)
+{
+	free_disjuncts(ce->dj);
+	xfree(ce->conn, ce->num_conn * sizeof(conn_key));
+	xfree(ce, sizeof(dcache_entry));
+}
+
+void disjunct_cache_delete(disjunct_cache_t *dc)
+{
+	dcache_entry *ce, *next;
+
+	if (NULL == dc) return;
+	for (ce = dc->newest; NULL != ce; ce = next)
+	{
+		next = ce->older;
+		entry_delete(ce);
+	}
+#ifdef USE_PTHREADS
+	pthread_mutex_destroy(&dc->lock);
+#endif
+	xfree(dc->table, dc->table_size * sizeof(dcache_entry *));
+	xfree(dc, sizeof(disjunct_cache_t));
+}
+
+/* ======================================================== */
+/* The key. */
+
+static size_t count_exp_connectors(const Exp *e)
+{
+	E_list *l;
+	size_t n = 0;
+
+	if (CONNECTOR_type == e->type) return 1;
+	for (l = e->u.l; NULL != l; l = l->next)
+		n += count_exp_connectors(l->e);
+	return n;
+}
+
+static conn_key * get_exp_connectors(const Exp *e, conn_key *ck)
+{
+	E_list *l;
+
+	if (CONNECTOR_type == e->type)
+	{
+		ck->string = e->u.string;
+		ck->dir = e->dir;
+		return ck + 1;
+	}
+	for (l = e->u.l; NULL != l; l = l->next)
+		ck = get_exp_connectors(l->e, ck);
+	return ck;
+}
+
+static unsigned int key_hash(const dcache_entry *key)
+{
+	size_t i;
+	uintptr_t h = ((uintptr_t) key->exp >> 4) ^ key->empty_word;
+
+	for (i = 0; i < key->num_conn; i++)
+	{
+		h = h * 31 + ((uintptr_t) key->conn[i].string >> 2);
+		h = h * 3 + ('+' == key->conn[i].dir);
+	}
+	h ^= h >> 16;
+	return (unsigned int) (h * 2654435761U);
+}
+
+static bool conn_equal(const conn_key *a, const conn_key *b, size_t n)
+{
+	size_t i;
+	for (i = 0; i < n; i++)
+	{
+		if ((a[i].string != b[i].string) || (a[i].dir != b[i].dir))
+			return false;
+	}
+	return true;
+}
+
+/* ======================================================== */
+/* Table and LRU list maintenance. The cache must be locked. */
+
+static void lru_unlink(disjunct_cache_t *dc, dcache_entry *ce)
+{
+	if (ce->newer) ce->newer->older = ce->older;
+	else dc->newest = ce->older;
+	if (ce->older) ce->older->newer = ce->newer;
+	else dc->oldest = ce->newer;
+}
+
+static void lru_push(disjunct_cache_t *dc, dcache_entry *ce)
+{
+	ce->newer = NULL;
+	ce->older = dc->newest;
+	if (dc->newest) dc->newest->newer = ce;
+	else dc->oldest = ce;
+	dc->newest = ce;
+}
+
+static dcache_entry * table_find(disjunct_cache_t *dc, const dcache_entry *key)
+{
+	dcache_entry *ce;
+
+	for (ce = dc->table[key->hash & (dc->table_size - 1)]; NULL != ce; ce = ce->next)
+	{
+		if ((ce->hash == key->hash) && (ce->exp == key->exp) &&
+		    (ce->empty_word == key->empty_word) &&
+		    (ce->cost_cutoff == key->cost_cutoff) &&
+		    (ce->num_conn == key->num_conn) &&
+		    conn_equal(ce->conn, key->conn, ce->num_conn))
+			return ce;
+	}
+	return NULL;
+}
+
+static void table_grow(disjunct_cache_t *dc)
+{
+	size_t i;
+	size_t new_size = 2 * dc->table_size;
+	dcache_entry **new_table;
+
+	new_table = (dcache_entry **) xalloc(new_size * sizeof(dcache_entry *));
+	memset(new_table, 0, new_size * sizeof(dcache_entry *));
+	for (i = 0; i < dc->table_size; i++)
+	{
+		dcache_entry *ce, *next;
+		for (ce = dc->table[i]; NULL != ce; ce = next)
+		{
+			next = ce->next;
+			ce->next = new_table[ce->hash & (new_size - 1)];
+			new_table[ce->hash & (new_size - 1)] = ce;
+		}
+	}
+	xfree(dc->table, dc->table_size * sizeof(dcache_entry *));
+	dc->table = new_table;
+	dc->table_size = new_size;
+}
+
+static void table_remove(disjunct_cache_t *dc, dcache_entry *ce)
+{
+	dcache_entry **p;
+
+	p = &dc->table[ce->hash & (dc->table_size - 1)];
+	while (*p != ce) p = &(*p)->next;
+	*p = ce->next;
+}
+
+/** Discard the least recently used entries, until n more disjuncts fit. */
+static void evict(disjunct_cache_t *dc, size_t n)
+{
+	while ((NULL != dc->oldest) && (dc->num_disjuncts + n > dc->max_disjuncts))
+	{
+		dcache_entry *ce = dc->oldest;
+		lru_unlink(dc, ce);
+		table_remove(dc, ce);
+		dc->num_disjuncts -= ce->num_disjuncts;
+		dc->num_entries--;
+		entry_delete(ce);
+	}
+}
+
+/* ======================================================== */
+
+static Connector * copy_connectors(Connector *c, Pool_desc *mp)
+{
+	Connector head;
+	Connector *tail = &head;
+
+	for (; NULL != c; c = c->next)
+	{
+		Connector *n = connector_new(mp);
+		n->multi = c->multi;
+		n->string = c->string;
+		n->desc = c->desc;
+		if (NULL != c->desc) n->hash = c->desc->hash;
+		n->word = 0;
+		tail->next = n;
+		tail = n;
+	}
+	tail->next = NULL;
+	return head.next;
+}
+
+/**
+ * Return a copy of the disjunct list dj, with the print name string,
+ * taken from the pools of the sentence.
+ */
+static Disjunct * copy_disjuncts(Disjunct *dj, const char *string,
+                                 Sentence sent)
+{
+	Disjunct head;
+	Disjunct *tail = &head;
+
+	for (; NULL != dj; dj = dj->next)
+	{
+		Disjunct *n = disjunct_new(sent->Disjunct_pool);
+		n->left = copy_connectors(dj->left, sent->Connector_pool);
+		n->right = copy_connectors(dj->right, sent->Connector_pool);
+		n->string = string;
+		n->cost = dj->cost;
+		n->marked = false;
+		tail->next = n;
+		tail = n;
+	}
+	tail->next = NULL;
+	return head.next;
+}
+
+/**
+ * Return the disjuncts of the X_node x of the sentence, as
+ * build_sentence_disjuncts_for_X_node() would, but without duplicates,
+ * and taken from the cache if possible.  On a cache miss, the disjuncts
+ * are built and added to the cache.
+ */
+Disjunct * disjunct_cache_get(disjunct_cache_t *dc, Sentence sent, X_node *x,
+                              double cost_cutoff)
+{
+	dcache_entry key;
+	dcache_entry *ce;
+	Disjunct *dj, *d;
+	size_t n;
+
+	if ((NULL == x->dict_exp) || (0 == dc->max_disjuncts))
+		return build_sentence_disjuncts_for_X_node(sent, x, cost_cutoff);
+
+	key.exp = x->dict_exp;
+	key.empty_word = x->empty_word;
+	key.cost_cutoff = cost_cutoff;
+	key.num_conn = count_exp_connectors(x->exp);
+	key.conn = (conn_key *) xalloc(key.num_conn * sizeof(conn_key));
+	get_exp_connectors(x->exp, key.conn);
+	key.hash = key_hash(&key);
+
+	dcache_lock(dc);
+	ce = table_find(dc, &key);
+	if (NULL != ce)
+	{
+		dc->hits++;
+		lru_unlink(dc, ce);
+		lru_push(dc, ce);
+		d = copy_disjuncts(ce->dj, x->string, sent);
+		dcache_unlock(dc);
+		xfree(key.conn, key.num_conn * sizeof(conn_key));
+		return d;
+	}
+	dc->misses++;
+	dcache_unlock(dc);
+
+	/* Build outside of the lock; this is the expensive part. */
+	dj = build_disjuncts_for_X_node(x, cost_cutoff);
+	dj = eliminate_duplicate_disjuncts(dj);
+	n = count_disjuncts(dj);
+	d = copy_disjuncts(dj, x->string, sent);
+
+	dcache_lock(dc);
+	if ((n > dc->max_disjuncts) || (NULL != table_find(dc, &key)))
+	{
+		/* Too big to be cached, or another thread was faster. */
+		dcache_unlock(dc);
+		free_disjuncts(dj);
+		xfree(key.conn, key.num_conn * sizeof(conn_key));
+		return d;
+	}
+
+	evict(dc, n);
+	ce = (dcache_entry *) xalloc(sizeof(dcache_entry));
+	*ce = key;
+	ce->dj = dj;
+	ce->num_disjuncts = n;
+	if (dc->num_entries >= dc->table_size) table_grow(dc);
+	ce->next = dc->table[ce->hash & (dc->table_size - 1)];
+	dc->table[ce->hash & (dc->table_size - 1)] = ce;
+	lru_push(dc, ce);
+	dc->num_entries++;
+	dc->num_disjuncts += n;
+	dcache_unlock(dc);
+
+	return d;
+}
+
+/* ======================================================== */
+
+/**
+ * Set the maximal number of disjuncts the cache may hold.
+ * Zero disables the cache, and discards its current content.
+ */
+void disjunct_cache_set_size(disjunct_cache_t *dc, size_t max_disjuncts)
+{
+	dcache_lock(dc);
+	dc->max_disjuncts = max_disjuncts;
+	evict(dc, 0);
+	dcache_unlock(dc);
+}
+
+size_t disjunct_cache_get_size(disjunct_cache_t *dc)
+{
+	return dc->max_disjuncts;
+}
+
+void disjunct_cache_get_stats(disjunct_cache_t *dc, size_t *hits, size_t *misses)
+{
+	dcache_lock(dc);
+	if (hits) *hits = dc->hits;
+	if (misses) *misses = dc->misses;
+	dcache_unlock(dc);
+}
@@ -0,0 +1,34 @@
+/*************************************************************************/
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+#ifndef _DISJUNCT_CACHE_H_
+#define _DISJUNCT_CACHE_H_
+
+#include "api-types.h"
+#include "structures.h"
+
+/* Default upper bound on the number of disjuncts held by a cache.
+ * The cache is disabled by default: it pays off only when the same
+ * words keep recurring in similar contexts, and otherwise just costs
+ * memory and copying.  Use dictionary_set_disjunct_cache_size() to
+ * enable it; some 300000 disjuncts (about 50MB for English) are
+ * enough to hold the working set of a typical corpus. */
+#define DISJUNCT_CACHE_DEFAULT_SIZE 0
+
+disjunct_cache_t * disjunct_cache_create(size_t max_disjuncts);
+void disjunct_cache_delete(disjunct_cache_t *);
+void disjunct_cache_set_size(disjunct_cache_t *, size_t max_disjuncts);
+size_t disjunct_cache_get_size(disjunct_cache_t *);
+void disjunct_cache_get_stats(disjunct_cache_t *, size_t *hits, size_t *misses);
+
+Disjunct * disjunct_cache_get(disjunct_cache_t *, Sentence, X_node *,
+                              double cost_cutoff);
+
+#endif /* _DISJUNCT_CACHE_H_ */
@@ -14,27 +14,149 @@
 #include <string.h>
 #include "disjunct-utils.h"
 #include "externs.h"
+#include "memory-pool.h"
 #include "structures.h"
 #include "utilities.h"
 #include "word-utils.h"
 
 /* Disjunct utilities ... */
 
+/**
+ * Return a new disjunct, from the pool mp, or from the heap if mp is
+ * NULL.  Its fields, but for the pooled flag, are to be set.
+ */
+Disjunct * disjunct_new(Pool_desc *mp)
+{
+	Disjunct *d;
+
+	if (NULL == mp)
+		d = (Disjunct *) xalloc(sizeof(Disjunct));
+	else
+		d = (Disjunct *) pool_alloc(mp);
+	d->pooled = (NULL != mp);
+	return d;
+}
+
 /**
  * free_disjuncts() -- free the list of disjuncts pointed to by c
  * (does not free any strings)
+ * The pooled disjuncts, and their connectors, are left to the pools
+ * or the packed block of their sentence.
  */
 void free_disjuncts(Disjunct *c)
 {
 	Disjunct *c1;
 	for (;c != NULL; c = c1) {
 		c1 = c->next;
+		if (c->pooled) continue;
 		free_connectors(c->left);
 		free_connectors(c->right);
 		xfree((char *)c, sizeof(Disjunct));
 	}
 }
 
+static Connector * pack_connectors(Connector *c, Connector **block)
+{
+	Connector head;
+	Connector *tail = &head;
+
+	for (; c != NULL; c = c->next)
+	{
+		Connector *n = (*block)++;
+		*n = *c;
+		tail->next = n;
+		tail = n;
+	}
+	tail->next = NULL;
+	return head.next;
+}
+
+/**
+ * Move the disjuncts of the sentence, and their connectors, into one
+ * block: first all the disjuncts, word after word, each in the order
+ * of its list, and then their connectors, the left ones of a disjunct
+ * followed by its right ones.  The lists are linked as before, so the
+ * code that walks them does not change; but it walks through memory
+ * in order, instead of jumping all over the heap.
+ *
+ * The packed disjuncts and connectors are freed all at once, with the
+ * block, by free_sentence_disjuncts().  Disjuncts that are added to
+ * the lists later, by relax_null_pruning(), are not packed.
+ *
+ * Nothing is left in the pools of the sentence after packing, so they
+ * are reused for the disjuncts built later.
+ */
+void pack_sentence_disjuncts(Sentence sent)
+{
+	size_t w, num_disjuncts = 0, num_connectors = 0;
+	Disjunct *d, *dblock;
+	Connector *c, *cblock;
+
+	assert(NULL == sent->disjunct_block, "Disjuncts already packed");
+
+	for (w = 0; w < sent->length; w++)
+	{
+		for (d = sent->word[w].d; d != NULL; d = d->next)
+		{
+			num_disjuncts++;
+			for (c = d->left; c != NULL; c = c->next) num_connectors++;
+			for (c = d->right; c != NULL; c = c->next) num_connectors++;
+		}
+	}
+	if (0 == num_disjuncts) return;
+
+	sent->disjunct_block_size = num_disjuncts * sizeof(Disjunct) +
+	                            num_connectors * sizeof(Connector);
+	sent->disjunct_block = xalloc(sent->disjunct_block_size);
+	dblock = (Disjunct *) sent->disjunct_block;
+	cblock = (Connector *) (dblock + num_disjuncts);
+
+	for (w = 0; w < sent->length; w++)
+	{
+		Disjunct head;
+		Disjunct *tail = &head;
+
+		for (d = sent->word[w].d; d != NULL; d = d->next)
+		{
+			Disjunct *n = dblock++;
+			*n = *d;
+			n->pooled = true;
+			n->left = pack_connectors(d->left, &cblock);
+			n->right = pack_connectors(d->right, &cblock);
+			tail->next = n;
+			tail = n;
+		}
+		tail->next = NULL;
+
+		free_disjuncts(sent->word[w].d);
+		sent->word[w].d = head.next;
+	}
+	pool_reuse(sent->Disjunct_pool);
+	pool_reuse(sent->Connector_pool);
+}
+
+/**
+ * Free the disjuncts of all the words of the sentence, pooled, packed
+ * or not.  The blocks of the pools are kept for the next parse.
+ */
+void free_sentence_disjuncts(Sentence sent)
+{
+	size_t w;
+
+	for (w = 0; w < sent->length; w++)
+	{
+		free_disjuncts(sent->word[w].d);
+		sent->word[w].d = NULL;
+	}
+	pool_reuse(sent->Disjunct_pool);
+	pool_reuse(sent->Connector_pool);
+
+	if (NULL == sent->disjunct_block) return;
+	xfree(sent->disjunct_block, sent->disjunct_block_size);
+	sent->disjunct_block = NULL;
+	sent->disjunct_block_size = 0;
+}
+
 /**
  * Destructively catenates the two disjunct lists d1 followed by d2.
  * Doesn't change the contents of the disjuncts.
@@ -155,11 +277,19 @@ static void disjunct_dup_table_delete(disjunct_dup_table *dt)
  * Takes the list of disjuncts pointed to by d, eliminates all
  * duplicates, and returns a pointer to a new list.
  * It frees the disjuncts that are eliminated.
+ *
+ * The surviving disjuncts keep the order of their first occurrence
+ * in d, and get the lowest cost of their duplicates.  Thus the result
+ * does not depend on the size of the hash table, and a list that has
+ * already been de-duplicated may be catenated with others and
+ * de-duplicated again with the same outcome.
  */
 Disjunct * eliminate_duplicate_disjuncts(Disjunct * d)
 {
-	unsigned int i, h, count;
+	unsigned int h, count;
 	Disjunct *dn, *dx;
+	Disjunct head;
+	Disjunct *tail = &head;
 	disjunct_dup_table *dt;
 
 	count = 0;
@@ -170,14 +300,17 @@ Disjunct * eliminate_duplicate_disjuncts(Disjunct * d)
 		dn = d->next;
 		h = old_hash_disjunct(dt, d);
 
-		for (dx = dt->dup_table[h]; dx != NULL; dx = dx->next)
+		/* Open addressing, linear probing; the table is at most half full. */
+		for (dx = dt->dup_table[h]; dx != NULL; dx = dt->dup_table[h])
 		{
 			if (disjuncts_equal(dx, d)) break;
+			h = (h + 1) & (dt->dup_table_size - 1);
 		}
 		if (dx == NULL)
 		{
-			d->next = dt->dup_table[h];
 			dt->dup_table[h] = d;
+			tail->next = d;
+			tail = d;
 		}
 		else
 		{
@@ -188,21 +321,94 @@ Disjunct * eliminate_duplicate_disjuncts(Disjunct * d)
 		}
 		d = dn;
 	}
+	tail->next = NULL;
+
+	if ((verbosity > 2) && (count != 0)) printf("killed %u duplicates\n", count);
+
+	disjunct_dup_table_delete(dt);
+	return head.next;
+}
+
+/* ============================================================= */
+
+/**
+ * Takes the list of disjuncts "pruned", the result of a pruning of
+ * the same word as "relaxed", but a harder one, and returns the list
+ * "relaxed", in its order, with the disjuncts of "pruned" substituted
+ * for their copies.  The connectors of the disjuncts of "pruned" get
+ * the words found by the relaxed pruning.  The copies are freed.
+ *
+ * So the disjuncts of "pruned", and the counts that were memoized
+ * for them, are kept.  *changed is set to TRUE if the result differs
+ * from "pruned" in any way.  Both lists must be free of duplicates.
+ */
+Disjunct * restore_disjuncts(Disjunct * pruned, Disjunct * relaxed,
+                             bool * changed)
+{
+	size_t h;
+	Disjunct *d, *dn, *dx;
+	Disjunct head;
+	Disjunct *tail = &head;
+	Connector *c, *cx;
+	disjunct_dup_table *dt;
 
-	/* d is already null */
-	for (i=0; i < dt->dup_table_size; i++)
+	dt = disjunct_dup_table_new(next_power_of_two_up(2 * count_disjuncts(pruned)));
+	for (d = pruned; d != NULL; d = d->next)
 	{
-		for (dn = dt->dup_table[i]; dn != NULL; dn = dx) {
-			dx = dn->next;
-			dn->next = d;
-			d = dn;
+		h = old_hash_disjunct(dt, d);
+		while (dt->dup_table[h] != NULL) h = (h + 1) & (dt->dup_table_size - 1);
+		dt->dup_table[h] = d;
+		d->marked = false;
+	}
+
+	for (d = relaxed; d != NULL; d = dn)
+	{
+		dn = d->next;
+		h = old_hash_disjunct(dt, d);
+		for (dx = dt->dup_table[h]; dx != NULL; dx = dt->dup_table[h])
+		{
+			if (disjuncts_equal(dx, d)) break;
+			h = (h + 1) & (dt->dup_table_size - 1);
+		}
+		if (dx == NULL)
+		{
+			*changed = true;
+			tail->next = d;
+			tail = d;
+			continue;
 		}
+
+		for (c = d->left, cx = dx->left; c != NULL; c = c->next, cx = cx->next)
+		{
+			if (cx->word != c->word) *changed = true;
+			cx->word = c->word;
+		}
+		for (c = d->right, cx = dx->right; c != NULL; c = c->next, cx = cx->next)
+		{
+			if (cx->word != c->word) *changed = true;
+			cx->word = c->word;
+		}
+		dx->marked = true;
+		tail->next = dx;
+		tail = dx;
+		d->next = NULL;
+		free_disjuncts(d);
 	}
 
-	if ((verbosity > 2) && (count != 0)) printf("killed %u duplicates\n", count);
+	/* A harder pruning does not keep more disjuncts; but if it did,
+	 * keeping them is harmless, and they may be in use. */
+	for (h = 0; h < dt->dup_table_size; h++)
+	{
+		d = dt->dup_table[h];
+		if ((d == NULL) || d->marked) continue;
+		*changed = true;
+		tail->next = d;
+		tail = d;
+	}
+	tail->next = NULL;
 
 	disjunct_dup_table_delete(dt);
-	return d;
+	return head.next;
 }
 
 /* ============================================================= */
@@ -13,13 +13,24 @@
 #ifndef _LINK_GRAMMAR_DISJUNCT_UTILS_H_
 #define _LINK_GRAMMAR_DISJUNCT_UTILS_H_
 
+#include <stdbool.h>
 #include "api-types.h"
+#include "link-includes.h"
+
+/* Number of disjuncts and connectors per block of the pools of a
+ * sentence */
+#define DISJUNCT_POOL_BLOCK 2048
+#define CONNECTOR_POOL_BLOCK 2048
 
 /* Disjunct utilities ... */
+Disjunct * disjunct_new(Pool_desc *);
 void free_disjuncts(Disjunct *);
+void pack_sentence_disjuncts(Sentence);
+void free_sentence_disjuncts(Sentence);
 unsigned int count_disjuncts(Disjunct *);
 Disjunct * catenate_disjuncts(Disjunct *, Disjunct *);
 Disjunct * eliminate_duplicate_disjuncts(Disjunct * );
+Disjunct * restore_disjuncts(Disjunct *, Disjunct *, bool *);
 char * print_one_disjunct(Disjunct *);
 
 #endif /* _LINK_GRAMMAR_DISJUNCT_UTILS_H_ */
@@ -10,10 +10,23 @@
 /*                                                                       */
 /*************************************************************************/
 
-/* verbosity global is held in utilities.c */
-extern int verbosity;          /* the verbosity level for error messages */
-extern char * debug;           /* comma-separated function list to debug */
-extern char * test;            /* comma-separated function list to debug */
+/* Thread-local storage */
+#ifndef TLS
+#ifdef _MSC_VER
+#define TLS __declspec(thread)
+#else
+#define TLS __thread
+#endif
+#endif /* TLS */
+
+/* verbosity global is held in utilities.c.
+ * These are per-thread copies of the corresponding Parse_Options
+ * fields, for the code that has no access to the options. They are
+ * set whenever the options are set, and on entry to the API functions
+ * that take a Parse_Options argument. */
+extern TLS int verbosity;      /* the verbosity level for error messages */
+extern TLS char * debug;       /* comma-separated function list to debug */
+extern TLS char * test;        /* comma-separated function list to debug */
 
 /* size of random table for computing the
    hash functions.  must be a power of 2 */
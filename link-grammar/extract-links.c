@@ -16,6 +16,7 @@
 #include "count.h"
 #include "fast-match.h"
 #include "extract-links.h"
+#include "memory-pool.h"
 #include "word-utils.h"
 
 /**
@@ -28,42 +29,79 @@
  * continuation).
  */
 
+/**
+ * The cost of a linkage, in the order in which the linkages are sorted
+ * (see VDAL_compare_parse()): the number of words without a disjunct,
+ * then the sum of the costs of the chosen disjuncts, then the sum of
+ * the lengths of the links.  Each of them is a sum over the choices
+ * that make up the linkage, so the cheapest linkages of a set can be
+ * found from the cheapest linkages of its subsets.
+ */
+typedef struct
+{
+	int unused;
+	int link;
+	double disjunct;
+} Linkage_cost;
+
+/** A linkage of a set: one of its choices, and a linkage of each
+ * of the two sets of the choice, given by their rank in cost order. */
+typedef struct
+{
+	Parse_choice * pc;
+	unsigned int rank[2];
+	Linkage_cost cost;
+} Derivation;
+
+struct Parse_kbest_struct
+{
+	Parse_kbest * next;    /* The list of them in the parse info */
+	Derivation * best;     /* The cheapest linkages found, in cost order */
+	size_t nbest, best_size;
+	Derivation * cand;     /* Heap of the candidates for the next one */
+	size_t ncand, cand_size;
+	bool pending;          /* The next candidates of the last one found
+	                          have not been put in the heap yet */
+};
+
+static void free_kbest(Parse_kbest *kb)
+{
+	Parse_kbest *next;
+
+	for (; kb != NULL; kb = next)
+	{
+		next = kb->next;
+		xfree(kb->best, kb->best_size * sizeof(Derivation));
+		xfree(kb->cand, kb->cand_size * sizeof(Derivation));
+		xfree(kb, sizeof(Parse_kbest));
+	}
+}
+
 static Parse_set * dummy_set(void)
 {
-	static Parse_set ds;
-	ds.first = ds.current = NULL;
-	ds.count = 1;
+	/* Never modified, so it may be shared by all threads */
+	static Parse_set ds = {1, NULL, NULL, NULL};
 	return &ds;
 }
 
 /** Returns an empty set of parses */
-static inline Parse_set * empty_set(void)
+static inline Parse_set * empty_set(Parse_info pi)
 {
 	Parse_set *s;
-	s = (Parse_set *) xalloc(sizeof(Parse_set));
+	s = (Parse_set *) pool_alloc(pi->Parse_set_pool);
 	s->first = s->current = NULL;
+	s->kbest = NULL;
 	s->count = 0;
 	return s;
 }
 
-static void free_set(Parse_set *s)
-{
-	Parse_choice *p, *xp;
-	if (s == NULL) return;
-	for (p=s->first; p != NULL; p = xp) {
-		xp = p->next;
-		xfree((void *)p, sizeof(*p));
-	}
-	xfree((void *)s, sizeof(*s));
-}
-
 static Parse_choice *
 make_choice(Parse_set *lset, int llw, int lrw, Connector * llc, Connector * lrc,
             Parse_set *rset, int rlw, int rrw, Connector * rlc, Connector * rrc,
-            Disjunct *ld, Disjunct *md, Disjunct *rd)
+            Disjunct *ld, Disjunct *md, Disjunct *rd, Parse_info pi)
 {
 	Parse_choice *pc;
-	pc = (Parse_choice *) xalloc(sizeof(*pc));
+	pc = (Parse_choice *) pool_alloc(pi->Parse_choice_pool);
 	pc->next = NULL;
 	pc->set[0] = lset;
 	pc->link[0].link_name = NULL;
@@ -102,15 +140,25 @@ static void put_choice_in_set(Parse_set *s, Parse_choice *pc)
 }
 
 /**
- * Allocate the parse info struct
- *
  * A piecewise exponential function determines the size of the hash
  * table.  Probably should make use of the actual number of disjuncts,
  * rather than just the number of words.
  */
+static unsigned int x_table_log2_size(int nwords)
+{
+	if (nwords >= 10) return 14;
+	if (nwords >= 4) return nwords;
+	return 4;
+}
+
+/* Number of elements per block of the pools of the parse info */
+#define PARSE_INFO_POOL_BLOCK 2048
+
+/**
+ * Allocate the parse info struct
+ */
 Parse_info parse_info_new(int nwords)
 {
-	int log2_table_size;
 	Parse_info pi;
 
 	pi = (Parse_info) xalloc(sizeof(struct Parse_info_struct));
@@ -118,17 +166,17 @@ Parse_info parse_info_new(int nwords)
 	pi->N_words = nwords;
 
 	pi->parse_set = NULL;
+	pi->kbest_list = NULL;
+	pi->X_table_connector_pool = pool_new("X_table_connector",
+		sizeof(X_table_connector), PARSE_INFO_POOL_BLOCK);
+	pi->Parse_set_pool = pool_new("Parse_set",
+		sizeof(Parse_set), PARSE_INFO_POOL_BLOCK);
+	pi->Parse_choice_pool = pool_new("Parse_choice",
+		sizeof(Parse_choice), PARSE_INFO_POOL_BLOCK);
 
 	/* Alloc the x_table */
-	if (nwords >= 10) {
-		log2_table_size = 14;
-	} else if (nwords >= 4) {
-		log2_table_size = nwords;
-	} else {
-		log2_table_size = 4;
-	}
-	pi->log2_x_table_size = log2_table_size;
-	pi->x_table_size = (1 << log2_table_size);
+	pi->log2_x_table_size = x_table_log2_size(nwords);
+	pi->x_table_size = (1 << pi->log2_x_table_size);
 
 	/*printf("Allocating x_table of size %d\n", x_table_size);*/
 	pi->x_table = (X_table_connector**) xalloc(pi->x_table_size * sizeof(X_table_connector*));
@@ -138,26 +186,30 @@ Parse_info parse_info_new(int nwords)
 }
 
 /**
- * This is the function that should be used to free the set structure. Since
- * it's a dag, a recursive free function won't work.  Every time we create
- * a set element, we put it in the hash table, so this is OK.
+ * This is the function that should be used to free the set structure.
+ * The table entries, the sets and their choices all come from the pools
+ * of the parse info, so they are all forgotten at once, a block at a
+ * time; only the k-best lists of the sets are freed one by one.
  */
+static void free_x_table_entries(Parse_info pi)
+{
+	memset(pi->x_table, 0, pi->x_table_size * sizeof(X_table_connector*));
+	pool_reuse(pi->X_table_connector_pool);
+	pool_reuse(pi->Parse_set_pool);
+	pool_reuse(pi->Parse_choice_pool);
+	free_kbest(pi->kbest_list);
+	pi->kbest_list = NULL;
+	pi->parse_set = NULL;
+}
+
 void free_parse_info(Parse_info pi)
 {
-	unsigned int i;
-	X_table_connector *t, *x;
 	if (!pi) return;
 
-	for (i=0; i<pi->x_table_size; i++)
-	{
-		for(t = pi->x_table[i]; t!= NULL; t=x)
-		{
-			x = t->next;
-			free_set(t->set);
-			xfree((void *) t, sizeof(X_table_connector));
-		}
-	}
-	pi->parse_set = NULL;
+	free_kbest(pi->kbest_list);
+	pool_delete(pi->X_table_connector_pool);
+	pool_delete(pi->Parse_set_pool);
+	pool_delete(pi->Parse_choice_pool);
 
 	/*printf("Freeing x_table of size %d\n", x_table_size);*/
 	xfree((void *) pi->x_table, pi->x_table_size * sizeof(X_table_connector*));
@@ -167,6 +219,29 @@ void free_parse_info(Parse_info pi)
 	xfree((void *) pi, sizeof(struct Parse_info_struct));
 }
 
+/**
+ * Empty the parse info, so that it may be used for another sentence
+ * of nwords words.  The x_table is kept if it has the right size.
+ */
+void reset_parse_info(Parse_info pi, int nwords)
+{
+	unsigned int log2_table_size = x_table_log2_size(nwords);
+
+	free_x_table_entries(pi);
+	pi->N_words = nwords;
+	pi->rand_state = 0;
+	pi->best_first = false;
+
+	if (log2_table_size != pi->log2_x_table_size)
+	{
+		xfree((void *) pi->x_table, pi->x_table_size * sizeof(X_table_connector*));
+		pi->log2_x_table_size = log2_table_size;
+		pi->x_table_size = (1 << log2_table_size);
+		pi->x_table = (X_table_connector**) xalloc(pi->x_table_size * sizeof(X_table_connector*));
+		memset(pi->x_table, 0, pi->x_table_size * sizeof(X_table_connector*));
+	}
+}
+
 /**
  * Returns the pointer to this info, NULL if not there.
  */
@@ -194,8 +269,8 @@ static X_table_connector * x_table_store(int lw, int rw,
 	X_table_connector *t, *n;
 	unsigned int h;
 
-	n = (X_table_connector *) xalloc(sizeof(X_table_connector));
-	n->set = empty_set();
+	n = (X_table_connector *) pool_alloc(pi->X_table_connector_pool);
+	n->set = empty_set(pi);
 	n->lw = lw; n->rw = rw; n->le = le; n->re = re; n->null_count = null_count;
 	h = pair_hash(pi->log2_x_table_size, lw, rw, le, re, null_count);
 	t = pi->x_table[h];
@@ -242,7 +317,7 @@ Parse_set * mk_parse_set(Sentence sent, fast_matcher_t *mchxt,
 	Parse_set *ls[4], *rs[4], *lset, *rset;
 	Parse_choice * a_choice;
 
-	Match_node * m, *m1;
+	size_t mlb, mle;
 	X_table_connector *xt;
 	s64 count;
 
@@ -263,6 +338,9 @@ Parse_set * mk_parse_set(Sentence sent, fast_matcher_t *mchxt,
 
 	if (xt != NULL) return xt->set;  /* we've already computed it */
 
+	/* A cancelled parse gets no linkages; stop building the set. */
+	if (flag_is_set(&sent->cancelled)) return NULL;
+
 	/* Start it out with the empty set of options. */
 	/* This entry must be updated before we return. */
 	xt = x_table_store(lw, rw, le, re, null_count, pi);
@@ -286,9 +364,10 @@ Parse_set * mk_parse_set(Sentence sent, fast_matcher_t *mchxt,
 				rs[0] = mk_parse_set(sent, mchxt, ctxt, dis, NULL, w, rw, dis->right,
 				                  NULL, null_count-1, islands_ok, pi);
 				if (rs[0] == NULL) continue;
+				/* No link here; dis is only recorded for its cost. */
 				a_choice = make_choice(dummy_set(), lw, w, NULL, NULL,
 				                       rs[0], w, rw, NULL, NULL,
-				                       NULL, NULL, NULL);
+				                       NULL, dis, NULL, pi);
 				put_choice_in_set(xt->set, a_choice);
 			}
 		}
@@ -298,7 +377,7 @@ Parse_set * mk_parse_set(Sentence sent, fast_matcher_t *mchxt,
 		{
 			a_choice = make_choice(dummy_set(), lw, w, NULL, NULL,
 			                       rs[0], w, rw, NULL, NULL,
-			                       NULL, NULL, NULL);
+			                       NULL, NULL, NULL, pi);
 			put_choice_in_set(xt->set, a_choice);
 		}
 		return xt->set;
@@ -329,10 +408,9 @@ Parse_set * mk_parse_set(Sentence sent, fast_matcher_t *mchxt,
 
 	for (w = start_word; w < end_word; w++)
 	{
-		m1 = m = form_match_list(mchxt, w, le, lw, re, rw);
-		for (; m!=NULL; m=m->next)
+		mle = mlb = form_match_list(mchxt, w, le, lw, re, rw);
+		for (; (d = get_match_list_element(mchxt, mle)) != NULL; mle++)
 		{
-			d = m->d;
 			for (lnull_count = 0; lnull_count <= null_count; lnull_count++)
 			{
 				rnull_count = null_count-lnull_count;
@@ -370,7 +448,7 @@ Parse_set * mk_parse_set(Sentence sent, fast_matcher_t *mchxt,
 						if (rs[j] == NULL) continue;
 						a_choice = make_choice(ls[i], lw, w, le, d->left,
 						                       rs[j], w, rw, d->right, re,
-						                       ld, d, rd);
+						                       ld, d, rd, pi);
 						put_choice_in_set(xt->set, a_choice);
 					}
 				}
@@ -389,7 +467,7 @@ Parse_set * mk_parse_set(Sentence sent, fast_matcher_t *mchxt,
 							a_choice = make_choice(ls[i], lw, w, le, d->left,
 							         rset, w, rw, NULL /* d->right */,
 							         re,  /* the NULL indicates no link*/
-							         ld, d, rd);
+							         ld, d, rd, pi);
 							put_choice_in_set(xt->set, a_choice);
 						}
 					}
@@ -410,14 +488,14 @@ Parse_set * mk_parse_set(Sentence sent, fast_matcher_t *mchxt,
 							a_choice = make_choice(lset, lw, w, NULL /* le */,
 							          d->left,  /* NULL indicates no link */
 							          rs[i], w, rw, d->right, re,
-							          ld, d, rd);
+							          ld, d, rd, pi);
 							put_choice_in_set(xt->set, a_choice);
 						}
 					}
 				}
 			}
 		}
-		put_match_list(mchxt, m1);
+		pop_match_list(mchxt, mlb);
 	}
 	xt->set->current = xt->set->first;
 	return xt->set;
@@ -488,6 +566,7 @@ bool build_parse_set(Sentence sent, fast_matcher_t *mchxt,
 	}
 
 	sent->parse_info->parse_set = whole_set;
+	sent->parse_info->best_first = false;
 
 	return verify_set(sent->parse_info);
 }
@@ -565,6 +644,218 @@ static void list_random_links(Linkage lkg, Parse_info pi, Parse_set * set)
 	list_random_links(lkg, pi, pc->set[1]);
 }
 
+/* ======================================================== */
+/* Best-first enumeration of the linkages */
+
+/* The disjunct costs are summed in different orders, so that sums
+ * that should be equal may differ in their last bits; those have to
+ * compare equal, for the link costs to decide between them. */
+#define COST_EPSILON 1.0e-6
+
+static inline bool cost_less(const Linkage_cost *a, const Linkage_cost *b)
+{
+	if (a->unused != b->unused) return a->unused < b->unused;
+	if (a->disjunct < b->disjunct - COST_EPSILON) return true;
+	if (a->disjunct > b->disjunct + COST_EPSILON) return false;
+	return a->link < b->link;
+}
+
+/** The part of the cost of a linkage that is due to this choice. */
+static void choice_cost(Parse_choice *pc, Linkage_cost *c)
+{
+	int i;
+
+	c->unused = 0;
+	c->link = 0;
+	c->disjunct = 0.0;
+
+	for (i = 0; i < 2; i++)
+	{
+		if (pc->link[i].lc != NULL)
+			c->link += pc->link[i].rw - pc->link[i].lw - 1;
+	}
+
+	/* The disjunct of the middle word is chosen here.  A choice
+	 * without one skips a word; so does the start of an island
+	 * on a disjunct that has no connectors. */
+	if ((pc->md == NULL) ||
+	    ((pc->link[0].lc == NULL) && (pc->link[1].lc == NULL) &&
+	     (pc->md->right == NULL)))
+		c->unused = 1;
+	else
+		c->disjunct = pc->md->cost;
+}
+
+static void cand_push(Parse_kbest *kb, const Derivation *d)
+{
+	size_t i;
+
+	if (kb->ncand == kb->cand_size)
+	{
+		size_t oldsz = kb->cand_size;
+		kb->cand_size = 2 * oldsz + 8;
+		kb->cand = xrealloc(kb->cand, oldsz * sizeof(Derivation),
+		                    kb->cand_size * sizeof(Derivation));
+	}
+
+	for (i = kb->ncand++; i > 0; i = (i-1)/2)
+	{
+		Derivation *parent = &kb->cand[(i-1)/2];
+		if (!cost_less(&d->cost, &parent->cost)) break;
+		kb->cand[i] = *parent;
+	}
+	kb->cand[i] = *d;
+}
+
+static void cand_pop(Parse_kbest *kb, Derivation *d)
+{
+	Derivation *last;
+	size_t i, child;
+
+	*d = kb->cand[0];
+	last = &kb->cand[--kb->ncand];
+	for (i = 0; (child = 2*i + 1) < kb->ncand; i = child)
+	{
+		if ((child+1 < kb->ncand) &&
+		    cost_less(&kb->cand[child+1].cost, &kb->cand[child].cost))
+			child++;
+		if (!cost_less(&kb->cand[child].cost, &last->cost)) break;
+		kb->cand[i] = kb->cand[child];
+	}
+	kb->cand[i] = *last;
+}
+
+static bool kbest_get(Parse_set *, size_t, Linkage_cost *, Parse_info);
+
+/** Compute the cost of d.  Returns false if one of its sets does not
+ * have a linkage of the given rank. */
+static bool derivation_cost(Derivation *d, Parse_info pi)
+{
+	Linkage_cost c;
+	int i;
+
+	choice_cost(d->pc, &d->cost);
+	for (i = 0; i < 2; i++)
+	{
+		if (!kbest_get(d->pc->set[i], d->rank[i], &c, pi)) return false;
+		d->cost.unused += c.unused;
+		d->cost.link += c.link;
+		d->cost.disjunct += c.disjunct;
+	}
+	return true;
+}
+
+/**
+ * Put in *cost the cost of the rank'th cheapest linkage of the set
+ * (counting from 0).  Returns false if the set has fewer linkages.
+ *
+ * The linkages are found lazily, as in Huang and Chiang, "Better
+ * k-best parsing" (2005): a set keeps the linkages found so far, and
+ * a heap of candidates for the next one.  When a linkage (choice, i, j)
+ * is taken from the heap, the next ones of the same choice, (i, j+1)
+ * and, if j is 0, (i+1, 0), become candidates.  Each derivation thus
+ * has a single predecessor, and is never put in the heap twice.
+ */
+static bool kbest_get(Parse_set *set, size_t rank, Linkage_cost *cost,
+                      Parse_info pi)
+{
+	Parse_kbest *kb;
+
+	/* A set without choices stands for a single linkage, of no cost. */
+	if (set->first == NULL)
+	{
+		if (0 != rank) return false;
+		cost->unused = 0;
+		cost->link = 0;
+		cost->disjunct = 0.0;
+		return true;
+	}
+
+	kb = set->kbest;
+	if (kb == NULL)
+	{
+		Parse_choice *pc;
+
+		kb = (Parse_kbest *) xalloc(sizeof(Parse_kbest));
+		memset(kb, 0, sizeof(Parse_kbest));
+		kb->next = pi->kbest_list;
+		pi->kbest_list = kb;
+		set->kbest = kb;
+		for (pc = set->first; pc != NULL; pc = pc->next)
+		{
+			Derivation d;
+			d.pc = pc;
+			d.rank[0] = d.rank[1] = 0;
+			if (derivation_cost(&d, pi)) cand_push(kb, &d);
+		}
+	}
+
+	while (kb->nbest <= rank)
+	{
+		if (kb->pending)
+		{
+			Derivation last = kb->best[kb->nbest-1];
+			Derivation d = last;
+
+			d.rank[1]++;
+			if (derivation_cost(&d, pi)) cand_push(kb, &d);
+			if (0 == last.rank[1])
+			{
+				d = last;
+				d.rank[0]++;
+				if (derivation_cost(&d, pi)) cand_push(kb, &d);
+			}
+			kb->pending = false;
+		}
+		if (0 == kb->ncand) return false;
+
+		if (kb->nbest == kb->best_size)
+		{
+			size_t oldsz = kb->best_size;
+			kb->best_size = 2 * oldsz + 4;
+			kb->best = xrealloc(kb->best, oldsz * sizeof(Derivation),
+			                    kb->best_size * sizeof(Derivation));
+		}
+		cand_pop(kb, &kb->best[kb->nbest++]);
+		kb->pending = true;
+	}
+
+	*cost = kb->best[rank].cost;
+	return true;
+}
+
+static void list_best_links(Linkage lkg, Parse_set * set, size_t rank)
+{
+	Derivation *d;
+
+	if (set == NULL || set->first == NULL) return;
+	d = &set->kbest->best[rank];
+	issue_links_for_choice(lkg, d->pc);
+	list_best_links(lkg, d->pc->set[0], d->rank[0]);
+	list_best_links(lkg, d->pc->set[1], d->rank[1]);
+}
+
+/**
+ * Find the k cheapest linkages of the parse set, and make the index
+ * given to extract_links() their rank in cost order.  Returns the
+ * number of linkages found, which is less than k only if the parse
+ * set has fewer.  Unlike walking the linkages by index, this is not
+ * misled by counts that overflowed.
+ */
+size_t find_best_linkages(Parse_info pi, size_t k)
+{
+	Linkage_cost cost;
+	size_t n = 0;
+
+	pi->best_first = true;
+	if ((pi->parse_set == NULL) || (0 == k)) return 0;
+	if (kbest_get(pi->parse_set, k-1, &cost, pi)) return k;
+
+	if (pi->parse_set->kbest != NULL) n = pi->parse_set->kbest->nbest;
+	else if (pi->parse_set->first == NULL) n = 1;
+	return n;
+}
+
 /**
  * Generate the list of all links of the index'th parsing of the
  * sentence.  For this to work, you must have already called parse, and
@@ -574,7 +865,10 @@ void extract_links(Linkage lkg, Parse_info pi)
 {
 	int index = lkg->lifo.index;
 	initialize_links(lkg);
-	if (index < 0) {
+	if (pi->best_first) {
+		list_best_links(lkg, pi->parse_set, index);
+	}
+	else if (index < 0) {
 		pi->rand_state = index;
 		list_random_links(lkg, pi, pi->parse_set);
 	}
@@ -15,5 +15,7 @@
 
 Parse_info parse_info_new(int nwords);
 void free_parse_info(Parse_info);
+void reset_parse_info(Parse_info, int nwords);
 bool build_parse_set(Sentence, fast_matcher_t*, count_context_t*, unsigned int null_count, Parse_Options);
+size_t find_best_linkages(Parse_info, size_t k);
 void extract_links(Linkage, Parse_info);
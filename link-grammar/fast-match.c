@@ -14,6 +14,7 @@
 #include "api-structures.h"
 #include "externs.h"
 #include "fast-match.h"
+#include "memory-pool.h"
 #include "word-utils.h"
 
 /**
@@ -28,8 +29,16 @@
  * by connectors they could potentially connect to.  The lookup table
  * is created by calling the alloc_fast_matcher() function.
  *
+ * form_match_list() pushes the candidates onto a stack of disjunct
+ * pointers kept in the matcher, and returns the index of the first
+ * one; the list is terminated by a NULL.  Since the caller recurses
+ * while walking the list, and the recursion pushes its own lists on
+ * top of it, the list must be accessed by index, with
+ * get_match_list_element().  pop_match_list() releases it.
+ *
  * free_fast_matcher() is used to free the matcher.
- * put_match_list() releases the memory that form_match_list returned.
+ * reset_fast_matcher() stocks the matcher for another sentence; the
+ * match nodes and the tables of the previous one are kept and reused.
  */
 
 /**
@@ -54,62 +63,15 @@ static int right_disjunct_list_length(const Disjunct * d)
 	return i;
 }
 
-struct fast_matcher_s
-{
-	size_t size;
-	unsigned int match_cost;     /* used for nothing but debugging ... */
-	unsigned int *l_table_size;  /* the sizes of the hash tables */
-	unsigned int *r_table_size;
-
-	/* the beginnings of the hash tables */
-	Match_node *** l_table;
-	Match_node *** r_table;
-
-	/* I'll pedantically maintain my own list of these cells */
-	Match_node * mn_free_list;
-};
-
+/* Number of match nodes per block of the pool */
+#define MATCH_NODE_BLOCK 2048
 
 /**
  * Return a match node to be used by the caller
  */
-static Match_node * get_match_node(fast_matcher_t *ctxt)
-{
-	Match_node * m;
-	if (ctxt->mn_free_list != NULL)
-	{
-		m = ctxt->mn_free_list;
-		ctxt->mn_free_list = m->next;
-	}
-	else
-	{
-		m = (Match_node *) xalloc(sizeof(Match_node));
-	}
-	return m;
-}
-
-/**
- * Put these nodes back onto my free list
- */
-void put_match_list(fast_matcher_t *ctxt, Match_node *m)
-{
-	Match_node * xm;
-
-	for (; m != NULL; m = xm)
-	{
-		xm = m->next;
-		m->next = ctxt->mn_free_list;
-		ctxt->mn_free_list = m;
-	}
-}
-
-static void free_match_list(Match_node * t)
+static inline Match_node * get_match_node(fast_matcher_t *ctxt)
 {
-	Match_node *xt;
-	for (; t!=NULL; t=xt) {
-		xt = t->next;
-		xfree((char *)t, sizeof(Match_node));
-	}
+	return (Match_node *) pool_alloc(ctxt->Match_node_pool);
 }
 
 /**
@@ -118,27 +80,19 @@ static void free_match_list(Match_node * t)
 void free_fast_matcher(fast_matcher_t *mchxt)
 {
 	size_t w;
-	unsigned int i;
 
 	if (verbosity > 1) printf("%d Match cost\n", mchxt->match_cost);
-	for (w = 0; w < mchxt->size; w++)
+	for (w = 0; w < mchxt->alloc_size; w++)
 	{
-		for (i = 0; i < mchxt->l_table_size[w]; i++)
-		{
-			free_match_list(mchxt->l_table[w][i]);
-		}
-		xfree((char *)mchxt->l_table[w], mchxt->l_table_size[w] * sizeof (Match_node *));
-		for (i = 0; i < mchxt->r_table_size[w]; i++)
-		{
-			free_match_list(mchxt->r_table[w][i]);
-		}
-		xfree((char *)mchxt->r_table[w], mchxt->r_table_size[w] * sizeof (Match_node *));
+		xfree((char *)mchxt->l_table[w], mchxt->l_table_alloc[w] * sizeof (Match_node *));
+		xfree((char *)mchxt->r_table[w], mchxt->r_table_alloc[w] * sizeof (Match_node *));
 	}
-	free_match_list(mchxt->mn_free_list);
-	mchxt->mn_free_list = NULL;
+	pool_delete(mchxt->Match_node_pool);
 
-	xfree(mchxt->l_table_size, mchxt->size * sizeof(unsigned int));
-	xfree(mchxt->l_table, mchxt->size * sizeof(Match_node **));
+	xfree(mchxt->l_table_size, 4 * mchxt->alloc_size * sizeof(unsigned int));
+	xfree(mchxt->l_table, 2 * mchxt->alloc_size * sizeof(Match_node **));
+	xfree(mchxt->match_stamp, mchxt->match_stamp_size * sizeof(unsigned int));
+	xfree(mchxt->match_list, mchxt->match_list_size * sizeof(Disjunct *));
 	xfree(mchxt, sizeof(fast_matcher_t));
 }
 
@@ -210,15 +164,18 @@ static Match_node * add_to_left_table_list(Match_node * m, Match_node * l)
  * dir =  1, we're putting this into a right table.
  * dir = -1, we're putting this into a left table.
  */
-static void put_into_match_table(unsigned int size, Match_node ** t,
-								 Disjunct * d, Connector * c, int dir )
+static void put_into_match_table(fast_matcher_t *ctxt,
+                                 unsigned int size, Match_node ** t,
+                                 Disjunct * d, unsigned int id,
+                                 Connector * c, int dir )
 {
 	unsigned int h;
 	Match_node * m;
 	h = connector_hash(c) & (size-1);
-	m = (Match_node *) xalloc (sizeof(Match_node));
+	m = get_match_node(ctxt);
 	m->next = NULL;
 	m->d = d;
+	m->id = id;
 	if (dir == 1) {
 		t[h] = add_to_right_table_list(m, t[h]);
 	} else {
@@ -226,77 +183,220 @@ static void put_into_match_table(unsigned int size, Match_node ** t,
 	}
 }
 
-fast_matcher_t* alloc_fast_matcher(const Sentence sent)
+/**
+ * Make room for the tables of nwords words.  The tables of the words
+ * that the arrays can already hold are kept.
+ */
+static void grow_word_arrays(fast_matcher_t *ctxt, size_t nwords)
 {
-	unsigned int size;
+	size_t old = ctxt->alloc_size;
+	unsigned int * sizes;
+	Match_node *** tables;
+
+	sizes = (unsigned int *) xalloc(4 * nwords * sizeof(unsigned int));
+	memset(sizes, 0, 4 * nwords * sizeof(unsigned int));
+	tables = (Match_node ***) xalloc(2 * nwords * sizeof(Match_node **));
+	memset(tables, 0, 2 * nwords * sizeof(Match_node **));
+
+	if (0 < old)
+	{
+		memcpy(sizes, ctxt->l_table_size, old * sizeof(unsigned int));
+		memcpy(sizes + nwords, ctxt->r_table_size, old * sizeof(unsigned int));
+		memcpy(sizes + 2 * nwords, ctxt->l_table_alloc, old * sizeof(unsigned int));
+		memcpy(sizes + 3 * nwords, ctxt->r_table_alloc, old * sizeof(unsigned int));
+		memcpy(tables, ctxt->l_table, old * sizeof(Match_node **));
+		memcpy(tables + nwords, ctxt->r_table, old * sizeof(Match_node **));
+	}
+	xfree(ctxt->l_table_size, 4 * old * sizeof(unsigned int));
+	xfree(ctxt->l_table, 2 * old * sizeof(Match_node **));
+
+	ctxt->alloc_size = nwords;
+	ctxt->l_table_size = sizes;
+	ctxt->r_table_size = sizes + nwords;
+	ctxt->l_table_alloc = sizes + 2 * nwords;
+	ctxt->r_table_alloc = sizes + 3 * nwords;
+	ctxt->l_table = tables;
+	ctxt->r_table = tables + nwords;
+}
+
+/**
+ * Return a cleared hash table of the given size, reusing the
+ * previously allocated one if it is large enough.
+ */
+static Match_node ** get_table(Match_node ** t, unsigned int *alloc,
+                               unsigned int size)
+{
+	if (*alloc < size)
+	{
+		xfree((char *)t, *alloc * sizeof(Match_node *));
+		t = (Match_node **) xalloc(size * sizeof(Match_node *));
+		*alloc = size;
+	}
+	memset(t, 0, size * sizeof(Match_node *));
+	return t;
+}
+
+void reset_fast_matcher(fast_matcher_t *ctxt, const Sentence sent)
+{
+	unsigned int size, id;
 	size_t w;
 	int len;
 	Match_node ** t;
 	Disjunct * d;
-	fast_matcher_t *ctxt;
 
-	ctxt = (fast_matcher_t *) xalloc(sizeof(fast_matcher_t));
+	/* Recycle the match nodes of the previous sentence, all at once */
+	pool_reuse(ctxt->Match_node_pool);
+
+	if (ctxt->alloc_size < sent->length)
+		grow_word_arrays(ctxt, sent->length);
 	ctxt->size = sent->length;
-	ctxt->l_table_size = xalloc(2 * sent->length * sizeof(unsigned int));
-	ctxt->r_table_size = ctxt->l_table_size + sent->length;
-	ctxt->l_table = xalloc(2 * sent->length * sizeof(Match_node **));
-	ctxt->r_table = ctxt->l_table + sent->length;
-	memset(ctxt->l_table, 0, 2 * sent->length * sizeof(Match_node **));
 	ctxt->match_cost = 0;
-	ctxt->mn_free_list = NULL;
+	ctxt->match_list_end = 0;
 
 	for (w=0; w<sent->length; w++)
 	{
+		/* The disjuncts of a word are numbered, for form_match_list() */
+		id = 0;
+		for (d = sent->word[w].d; d != NULL; d = d->next) id++;
+		if (ctxt->match_stamp_size < id)
+		{
+			xfree(ctxt->match_stamp, ctxt->match_stamp_size * sizeof(unsigned int));
+			ctxt->match_stamp_size = next_power_of_two_up(id);
+			ctxt->match_stamp = (unsigned int *)
+				xalloc(ctxt->match_stamp_size * sizeof(unsigned int));
+			memset(ctxt->match_stamp, 0, ctxt->match_stamp_size * sizeof(unsigned int));
+			ctxt->match_gen = 0;
+		}
+
 		len = left_disjunct_list_length(sent->word[w].d);
 		size = next_power_of_two_up(len);
 		ctxt->l_table_size[w] = size;
-		t = ctxt->l_table[w] = (Match_node **) xalloc(size * sizeof(Match_node *));
-		memset(t, 0, size * sizeof(Match_node *));
+		t = ctxt->l_table[w] =
+			get_table(ctxt->l_table[w], &ctxt->l_table_alloc[w], size);
 
-		for (d = sent->word[w].d; d != NULL; d = d->next)
+		for (id = 0, d = sent->word[w].d; d != NULL; id++, d = d->next)
 		{
 			if (d->left != NULL)
 			{
-				put_into_match_table(size, t, d, d->left, -1);
+				put_into_match_table(ctxt, size, t, d, id, d->left, -1);
 			}
 		}
 
 		len = right_disjunct_list_length(sent->word[w].d);
 		size = next_power_of_two_up(len);
 		ctxt->r_table_size[w] = size;
-		t = ctxt->r_table[w] = (Match_node **) xalloc(size * sizeof(Match_node *));
-		memset(t, 0, size * sizeof(Match_node *));
+		t = ctxt->r_table[w] =
+			get_table(ctxt->r_table[w], &ctxt->r_table_alloc[w], size);
 
-		for (d = sent->word[w].d; d != NULL; d = d->next)
+		for (id = 0, d = sent->word[w].d; d != NULL; id++, d = d->next)
 		{
 			if (d->right != NULL)
 			{
-				put_into_match_table(size, t, d, d->right, 1);
+				put_into_match_table(ctxt, size, t, d, id, d->right, 1);
 			}
 		}
 	}
+}
+
+fast_matcher_t* alloc_fast_matcher(const Sentence sent)
+{
+	fast_matcher_t *ctxt;
+
+	ctxt = (fast_matcher_t *) xalloc(sizeof(fast_matcher_t));
+	memset(ctxt, 0, sizeof(fast_matcher_t));
+	ctxt->Match_node_pool =
+		pool_new("Match_node", sizeof(Match_node), MATCH_NODE_BLOCK);
+	reset_fast_matcher(ctxt, sent);
 
 	return ctxt;
 }
 
 /**
- * Forms and returns a list of disjuncts coming from word w, that might
- * match lc or rc or both. The lw and rw are the words from which lc
- * and rc came respectively.
+ * Return a matcher that uses the hash tables of ctxt, but has its own
+ * match list stack, so that it can form match lists in another thread
+ * at the same time.  The tables of ctxt must not change while it is
+ * in use.
+ */
+fast_matcher_t * alloc_shared_fast_matcher(const fast_matcher_t *ctxt)
+{
+	fast_matcher_t *sctxt;
+
+	sctxt = (fast_matcher_t *) xalloc(sizeof(fast_matcher_t));
+	*sctxt = *ctxt;
+	sctxt->match_cost = 0;
+	sctxt->Match_node_pool = NULL;
+	sctxt->match_list = NULL;
+	sctxt->match_list_end = 0;
+	sctxt->match_list_size = 0;
+	sctxt->match_stamp = (unsigned int *)
+		xalloc(sctxt->match_stamp_size * sizeof(unsigned int));
+	memset(sctxt->match_stamp, 0, sctxt->match_stamp_size * sizeof(unsigned int));
+	sctxt->match_gen = 0;
+	return sctxt;
+}
+
+/** Free a matcher made by alloc_shared_fast_matcher() */
+void free_shared_fast_matcher(fast_matcher_t *sctxt)
+{
+	xfree(sctxt->match_stamp, sctxt->match_stamp_size * sizeof(unsigned int));
+	xfree(sctxt->match_list, sctxt->match_list_size * sizeof(Disjunct *));
+	xfree(sctxt, sizeof(fast_matcher_t));
+}
+
+/** The memory held by the matcher, for deciding whether to keep it */
+size_t fast_matcher_memory(const fast_matcher_t *ctxt)
+{
+	size_t w, bytes;
+
+	bytes = pool_memory(ctxt->Match_node_pool) +
+	        ctxt->match_stamp_size * sizeof(unsigned int) +
+	        ctxt->match_list_size * sizeof(Disjunct *);
+	for (w = 0; w < ctxt->alloc_size; w++)
+	{
+		bytes += (ctxt->l_table_alloc[w] + ctxt->r_table_alloc[w]) *
+		         sizeof(Match_node *);
+	}
+	return bytes;
+}
+
+/**
+ * Make room for n more elements on the match list stack.
+ */
+static void grow_match_list(fast_matcher_t *ctxt, size_t n)
+{
+	size_t old = ctxt->match_list_size;
+
+	if (ctxt->match_list_end + n <= old) return;
+	ctxt->match_list_size = (0 == old) ? 1024 : 2 * old;
+	while (ctxt->match_list_size < ctxt->match_list_end + n)
+		ctxt->match_list_size *= 2;
+	ctxt->match_list = (Disjunct **) xrealloc(ctxt->match_list,
+		old * sizeof(Disjunct *), ctxt->match_list_size * sizeof(Disjunct *));
+}
+
+/**
+ * Forms a list of disjuncts coming from word w, that might match lc
+ * or rc or both. The lw and rw are the words from which lc and rc came
+ * respectively.  Returns the index of the first element of the list,
+ * which is terminated by a NULL.
  *
- * The list is returned in a linked list of Match_nodes.
- * The list contains no duplicates.  A quadratic algorithm is used to
- * eliminate duplicates.  In practice the match_cost is less than the
- * parse_cost (and the loop is tiny), so there's no reason to bother
- * to fix this.  The number of times through the loop is counted with
- * 'match_cost', if verbosity>1, then it this will be prnted at the end.
+ * The list contains no duplicates.  The disjuncts that might match lc
+ * are marked, by stamping their number with a value unique to this
+ * call, so that those that might also match rc are put only once.
+ * The candidates for rc come first, in table order, and then those for
+ * lc, in reverse table order.  The number of candidates looked at is
+ * counted with 'match_cost', if verbosity>1, then it this will be
+ * printed at the end.
  */
-Match_node *
+size_t
 form_match_list(fast_matcher_t *ctxt, int w,
                 Connector *lc, int lw,
                 Connector *rc, int rw)
 {
-	Match_node *ml, *mr, *mx, *my, *mz, *front, *free_later;
+	Match_node *ml, *mr, *mx;
+	size_t front = ctxt->match_list_end;
+	size_t nl = 0, i;
+	unsigned int gen;
 
 	if (lc != NULL) {
 		ml = ctxt->l_table[w][connector_hash(lc) & (ctxt->l_table_size[w]-1)];
@@ -309,56 +409,41 @@ form_match_list(fast_matcher_t *ctxt, int w,
 		mr = NULL;
 	}
 
-	front = NULL;
+	gen = ++ctxt->match_gen;
+	if (0 == gen)
+	{
+		memset(ctxt->match_stamp, 0, ctxt->match_stamp_size * sizeof(unsigned int));
+		gen = ctxt->match_gen = 1;
+	}
+
+	/* Mark the things that could match the left */
 	for (mx = ml; mx != NULL; mx = mx->next)
 	{
 		if (mx->d->left->word < lw) break;
-		my = get_match_node(ctxt);
-		my->d = mx->d;
-		my->next = front;
-		front = my;
+		ctxt->match_stamp[mx->id] = gen;
+		nl++;
 	}
-	ml = front;   /* ml is now the list of things that could match the left */
+	ctxt->match_cost += nl;
 
-	front = NULL;
+	/* Put the things that could match the right, unless marked */
 	for (mx = mr; mx != NULL; mx = mx->next)
 	{
 		if (mx->d->right->word > rw) break;
-		my = get_match_node(ctxt);
-		my->d = mx->d;
-		my->next = front;
-		front = my;
+		ctxt->match_cost++;
+		if (gen == ctxt->match_stamp[mx->id]) continue;
+		grow_match_list(ctxt, 1);
+		ctxt->match_list[ctxt->match_list_end++] = mx->d;
 	}
-	mr = front;   /* mr is now the list of things that could match the right */
 
-	/* Now we want to eliminate duplicates from the lists */
-	free_later = NULL;
-	front = NULL;
-	for (mx = mr; mx != NULL; mx = mz)
+	/* Then the things that could match the left, and the terminator */
+	grow_match_list(ctxt, nl + 1);
+	i = ctxt->match_list_end + nl;
+	ctxt->match_list[i] = NULL;
+	for (mx = ml; i > ctxt->match_list_end; mx = mx->next)
 	{
-		/* see if mx in first list, put it in if its not */
-		mz = mx->next;
-		ctxt->match_cost++;
-		for (my=ml; my!=NULL; my=my->next) {
-			ctxt->match_cost++;
-			if (mx->d == my->d) break;
-		}
-		if (my != NULL) { /* mx was in the l list */
-			mx->next = free_later;
-			free_later = mx;
-		} else {  /* it was not there */
-			mx->next = front;
-			front = mx;
-		}
+		ctxt->match_list[--i] = mx->d;
 	}
-	mr = front;  /* mr is now the abbreviated right list */
-	put_match_list(ctxt, free_later);
-
-	/* now catenate the two lists */
-	if (mr == NULL) return ml;
-	if (ml == NULL) return mr;
-	for (mx = mr; mx->next != NULL; mx = mx->next)
-	  ;
-	mx->next = ml;
-	return mr;
+	ctxt->match_list_end += nl + 1;
+
+	return front;
 }
@@ -10,12 +10,60 @@
 /*                                                                       */
 /*************************************************************************/
 
+#ifndef _FAST_MATCH_H_
+#define _FAST_MATCH_H_
+
 #include "link-includes.h"
 #include "structures.h"
 
+struct fast_matcher_s
+{
+	size_t size;                 /* number of words in the sentence */
+	size_t alloc_size;           /* number of words the arrays can hold */
+	unsigned int match_cost;     /* used for nothing but debugging ... */
+	unsigned int *l_table_size;  /* the sizes of the hash tables */
+	unsigned int *r_table_size;
+	unsigned int *l_table_alloc; /* their allocated sizes */
+	unsigned int *r_table_alloc;
+
+	/* the beginnings of the hash tables */
+	Match_node *** l_table;
+	Match_node *** r_table;
+
+	/* The match nodes of the tables */
+	Pool_desc * Match_node_pool;
+
+	/* The stack of match lists returned by form_match_list() */
+	Disjunct ** match_list;
+	size_t match_list_end;       /* the first free element */
+	size_t match_list_size;
+
+	/* For removing duplicates, indexed by disjunct number */
+	unsigned int * match_stamp;
+	unsigned int match_stamp_size;
+	unsigned int match_gen;      /* the stamp of the current lookup */
+};
+
 /* See the source file for documentation. */
 fast_matcher_t* alloc_fast_matcher(const Sentence);
+void reset_fast_matcher(fast_matcher_t*, const Sentence);
+size_t fast_matcher_memory(const fast_matcher_t*);
 void free_fast_matcher(fast_matcher_t*);
+fast_matcher_t* alloc_shared_fast_matcher(const fast_matcher_t*);
+void free_shared_fast_matcher(fast_matcher_t*);
+
+size_t form_match_list(fast_matcher_t *, int, Connector *, int, Connector *, int);
+
+/** Return element i of a match list; NULL at its end */
+static inline Disjunct * get_match_list_element(fast_matcher_t *ctxt, size_t i)
+{
+	return ctxt->match_list[i];
+}
+
+/** Release the match list that starts at index mlb, and those above it */
+static inline void pop_match_list(fast_matcher_t *ctxt, size_t mlb)
+{
+	ctxt->match_list_end = mlb;
+}
 
-Match_node * form_match_list(fast_matcher_t *, int, Connector *, int, Connector *, int);
-void put_match_list(fast_matcher_t *, Match_node *);
+#endif /* _FAST_MATCH_H_ */
@@ -183,11 +183,25 @@ static Dict_node * make_idiom_Dict_nodes(Dictionary dict, const char * string)
 	return dn;
 }
 
-static char current_name[] = "AAAAAAAA";
-#define CN_size (sizeof(current_name)-1)
+#define CN_size (IDIOM_LINK_SZ-1)
 
-static void increment_current_name(void)
+/**
+ * The idiom connector names are generated from a per-dictionary
+ * counter, so that dictionaries don't interfere with each other.
+ */
+static char * get_current_name(Dictionary dict)
+{
+	if ('\0' == dict->current_idiom[0])
+	{
+		memset(dict->current_idiom, 'A', CN_size);
+		dict->current_idiom[CN_size] = '\0';
+	}
+	return dict->current_idiom;
+}
+
+static void increment_current_name(Dictionary dict)
 {
+	char * current_name = get_current_name(dict);
 	int i, carry;
 	i = CN_size-1;
 	carry = 1;
@@ -210,6 +224,7 @@ static void increment_current_name(void)
  */
 static const char * generate_id_connector(Dictionary dict)
 {
+	const char * current_name = get_current_name(dict);
 	char buff[2*MAX_WORD];
 	unsigned int i;
 	char * t;
@@ -315,7 +330,7 @@ void insert_idiom(Dictionary dict, Dict_node * dn)
 		nc->cost = 0;
 		elr->e = nc;
 
-		increment_current_name();
+		increment_current_name(dict);
 
 		nc = Exp_create(dict);
 		nc->u.string = generate_id_connector(dict);
@@ -341,7 +356,7 @@ void insert_idiom(Dictionary dict, Dict_node * dn)
 
 	dn_list->exp = nc;
 
-	increment_current_name();
+	increment_current_name(dict);
 
 	/* ---- end of the code alluded to above ---- */
 
@@ -48,6 +48,14 @@ link_public_api(const char *)
  *
  * Functions to manipulate Dictionaries
  *
+ * Thread safety: once created, a file-based Dictionary may be shared
+ * by several threads, each parsing its own Sentences with its own
+ * Parse_Options.  Creating and deleting dictionaries, and changing
+ * their settings, must not be done concurrently with their use.
+ * The verbosity, debug and test options are kept per thread, and are
+ * taken from the latest Parse_Options that were set or used in the
+ * thread.  SQL-based dictionaries cannot be shared.
+ *
  ***********************************************************************/
 
 link_public_api(Dictionary)
@@ -59,12 +67,32 @@ link_public_api(const char *)
 
 link_public_api(void)
      dictionary_delete(Dictionary);
+link_public_api(bool)
+     dictionary_write_binary(Dictionary, const char * filename);
 
 link_public_api(void)
      dictionary_set_data_dir(const char * path);
 link_public_api(char *)
      dictionary_get_data_dir(void);
 
+link_public_api(void)
+     dictionary_set_disjunct_cache_size(Dictionary, size_t max_disjuncts);
+link_public_api(size_t)
+     dictionary_get_disjunct_cache_size(Dictionary);
+link_public_api(size_t)
+     dictionary_get_disjunct_cache_hits(Dictionary);
+link_public_api(size_t)
+     dictionary_get_disjunct_cache_misses(Dictionary);
+
+link_public_api(void)
+     dictionary_set_parse_cache_size(Dictionary, size_t max_sentences);
+link_public_api(size_t)
+     dictionary_get_parse_cache_size(Dictionary);
+link_public_api(size_t)
+     dictionary_get_parse_cache_hits(Dictionary);
+link_public_api(size_t)
+     dictionary_get_parse_cache_misses(Dictionary);
+
 /**********************************************************************
  *
  * Functions to manipulate Parse Options
@@ -77,7 +105,14 @@ typedef enum
 	CORPUS, /* Sort by Corpus cost */
 } Cost_Model_type;
 
+typedef enum
+{
+	THREAD_CPU_TIME=0, /* CPU time used by the parsing thread (default) */
+	WALL_CLOCK_TIME,   /* Elapsed (monotonic) time */
+} Timer_clock_type;
+
 typedef struct Parse_Options_s * Parse_Options;
+typedef struct Parse_Workspace_s * Parse_Workspace;
 
 link_public_api(Parse_Options)
      parse_options_create(void);
@@ -131,6 +166,10 @@ link_public_api(void)
      parse_options_set_max_parse_time(Parse_Options  opts, int secs);
 link_public_api(int)
      parse_options_get_max_parse_time(Parse_Options opts);
+link_public_api(void)
+     parse_options_set_timer_clock(Parse_Options opts, Timer_clock_type clock);
+link_public_api(Timer_clock_type)
+     parse_options_get_timer_clock(Parse_Options opts);
 link_public_api(void)
      parse_options_set_cost_model_type(Parse_Options opts, Cost_Model_type cm);
 link_public_api(Cost_Model_type)
@@ -161,8 +200,39 @@ link_public_api(void)
      parse_options_set_repeatable_rand(Parse_Options opts, bool val);
 link_public_api(bool)
      parse_options_get_repeatable_rand(Parse_Options opts);
+link_public_api(void)
+     parse_options_set_best_first(Parse_Options opts, bool val);
+link_public_api(bool)
+     parse_options_get_best_first(Parse_Options opts);
+link_public_api(void)
+     parse_options_set_count_threads(Parse_Options opts, int val);
+link_public_api(int)
+     parse_options_get_count_threads(Parse_Options opts);
 link_public_api(void)
      parse_options_reset_resources(Parse_Options opts);
+link_public_api(void)
+     parse_options_set_workspace(Parse_Options opts, Parse_Workspace ws);
+link_public_api(Parse_Workspace)
+     parse_options_get_workspace(Parse_Options opts);
+
+/**********************************************************************
+ *
+ * A Parse_Workspace keeps the parser's scratch buffers from one
+ * sentence to the next, instead of allocating and freeing them for
+ * every sentence.  Attach it to the Parse_Options of a thread; it must
+ * not be used by two threads at the same time.  If the buffers grow
+ * above max_memory bytes, they are freed after the sentence.
+ *
+ ***********************************************************************/
+
+link_public_api(Parse_Workspace)
+     parse_workspace_create(void);
+link_public_api(void)
+     parse_workspace_delete(Parse_Workspace ws);
+link_public_api(void)
+     parse_workspace_set_max_memory(Parse_Workspace ws, size_t max_memory);
+link_public_api(size_t)
+     parse_workspace_get_max_memory(Parse_Workspace ws);
 
 
 /**********************************************************************
@@ -199,6 +269,11 @@ link_public_api(int)
 typedef struct Sentence_s * Sentence;
 typedef size_t LinkageIdx;
 
+/* sentence_cancel() may be called from any thread, e.g. by a watchdog,
+ * while another thread is parsing the sentence.  The parse then stops
+ * as soon as possible, as if its resources were exhausted, and finds
+ * no linkages.  A cancelled sentence stays cancelled. */
+
 link_public_api(Sentence)
      sentence_create(const char *input_string, Dictionary dict);
 link_public_api(void)
@@ -207,6 +282,8 @@ link_public_api(int)
      sentence_split(Sentence sent, Parse_Options opts);
 link_public_api(int)
      sentence_parse(Sentence sent, Parse_Options opts);
+link_public_api(void)
+     sentence_cancel(Sentence sent);
 link_public_api(int)
      sentence_length(Sentence sent);
 link_public_api(int)
@@ -224,6 +301,12 @@ link_public_api(double)
 link_public_api(int)
      sentence_link_cost(Sentence sent, LinkageIdx linkage_num);
 
+link_public_api(int)
+     sentence_parse_batch(Dictionary dict, const char * const * input,
+                          size_t num_sentences, Parse_Options opts,
+                          int num_threads, int max_batch_time,
+                          Sentence * result);
+
 /**********************************************************************
  *
  * Functions that create and manipulate Linkages.
@@ -0,0 +1,148 @@
+/*************************************************************************/
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+/**
+ * Memory pools for the small structures that a parse allocates by the
+ * hundred thousand: disjuncts, connectors, match nodes, parse sets and
+ * choices, and so on.
+ *
+ * The elements of a pool all have the same size.  They are taken one
+ * after the other from blocks of a fixed number of elements, so that
+ * an allocation is, most of the time, just the bump of a pointer, and
+ * elements allocated together lie together in memory.  An element that
+ * is no longer needed may be given back with pool_free(); it goes to a
+ * free list, from which it is allocated again.  But usually they are
+ * not given back one by one: pool_reuse() forgets all of them at once,
+ * keeping the blocks for the next use, and pool_delete() frees the
+ * blocks.  Both cost one step per block, not per element.
+ *
+ * The blocks are allocated with xalloc(), so that the memory of a pool
+ * is accounted for a block at a time, not an element at a time.
+ *
+ * A pool is not thread-safe; it belongs to the sentence (or the parse
+ * structure) whose elements it holds.
+ */
+
+#include "memory-pool.h"
+#include "utilities.h"
+
+/* The elements of a block follow the link to the next block, aligned
+ * as malloc() would align them. */
+#define POOL_ALIGNMENT (2 * sizeof(void *))
+#define POOL_LINK_SIZE POOL_ALIGNMENT
+#define BLOCK_NEXT(b) (*(char **)(b))
+
+static size_t align_up(size_t n, size_t alignment)
+{
+	return (n + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * Create a pool of elements of element_size bytes, allocated
+ * num_elements at a time.
+ */
+Pool_desc * pool_new(const char *name, size_t element_size,
+                     size_t num_elements)
+{
+	Pool_desc *mp = (Pool_desc *) xalloc(sizeof(Pool_desc));
+
+	mp->name = name;
+	/* An element must be able to hold the free list link. */
+	if (element_size < sizeof(void *)) element_size = sizeof(void *);
+	mp->element_size = align_up(element_size, sizeof(void *));
+	mp->num_elements = num_elements;
+	mp->block_size = POOL_LINK_SIZE + mp->element_size * num_elements;
+
+	mp->chain = NULL;
+	mp->block = NULL;
+	mp->alloc_next = NULL;
+	mp->free_list = NULL;
+	mp->num_blocks = 0;
+	mp->curr_elements = 0;
+	return mp;
+}
+
+/** Return an element of the pool.  Its content is undefined. */
+void * pool_alloc(Pool_desc *mp)
+{
+	char *e;
+
+	mp->curr_elements++;
+	if (NULL != mp->free_list)
+	{
+		e = mp->free_list;
+		mp->free_list = *(void **)e;
+		return e;
+	}
+
+	if ((NULL == mp->block) ||
+	    (mp->alloc_next == mp->block + mp->block_size))
+	{
+		/* Go on to the next block, which pool_reuse() may have kept. */
+		char *next = (NULL == mp->block) ? mp->chain : BLOCK_NEXT(mp->block);
+
+		if (NULL == next)
+		{
+			next = (char *) xalloc(mp->block_size);
+			BLOCK_NEXT(next) = NULL;
+			if (NULL == mp->block)
+				mp->chain = next;
+			else
+				BLOCK_NEXT(mp->block) = next;
+			mp->num_blocks++;
+		}
+		mp->block = next;
+		mp->alloc_next = next + POOL_LINK_SIZE;
+	}
+
+	e = mp->alloc_next;
+	mp->alloc_next += mp->element_size;
+	return e;
+}
+
+/** Give the element e back to the pool, for a later pool_alloc(). */
+void pool_free(Pool_desc *mp, void *e)
+{
+	*(void **)e = mp->free_list;
+	mp->free_list = e;
+	mp->curr_elements--;
+}
+
+/**
+ * Forget all the elements of the pool at once.  The blocks are kept,
+ * and the next elements are taken from them again.
+ */
+void pool_reuse(Pool_desc *mp)
+{
+	mp->block = NULL;
+	mp->alloc_next = NULL;
+	mp->free_list = NULL;
+	mp->curr_elements = 0;
+}
+
+/** Free the pool, with all of its elements. */
+void pool_delete(Pool_desc *mp)
+{
+	char *b, *next;
+
+	if (NULL == mp) return;
+	for (b = mp->chain; NULL != b; b = next)
+	{
+		next = BLOCK_NEXT(b);
+		xfree(b, mp->block_size);
+	}
+	xfree(mp, sizeof(Pool_desc));
+}
+
+/** The memory held by the pool, in bytes. */
+size_t pool_memory(const Pool_desc *mp)
+{
+	return sizeof(Pool_desc) + mp->num_blocks * mp->block_size;
+}
@@ -0,0 +1,43 @@
+/*************************************************************************/
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+#ifndef _MEMORY_POOL_H_
+#define _MEMORY_POOL_H_
+
+#include <stddef.h>
+#include "api-types.h"
+
+/* A pool of elements of one size, taken one after the other from
+ * blocks of num_elements elements.  See memory-pool.c. */
+struct Pool_desc_s
+{
+	const char *name;         /* for debugging */
+	size_t element_size;
+	size_t num_elements;      /* per block */
+	size_t block_size;        /* in bytes, with the link to the next block */
+
+	char *chain;              /* the first block */
+	char *block;              /* the block elements are taken from */
+	char *alloc_next;         /* its first unused element */
+	void *free_list;          /* elements given back by pool_free() */
+
+	size_t num_blocks;
+	size_t curr_elements;     /* in use */
+};
+
+Pool_desc * pool_new(const char *name, size_t element_size,
+                     size_t num_elements);
+void * pool_alloc(Pool_desc *);
+void pool_free(Pool_desc *, void *);
+void pool_reuse(Pool_desc *);
+void pool_delete(Pool_desc *);
+size_t pool_memory(const Pool_desc *);
+
+#endif /* _MEMORY_POOL_H_ */
@@ -55,6 +55,7 @@ class Solver {
   lbool    solve        (const vec<Lit>& assumps); // Search for a model that respects a given set of assumptions.
   lbool    solve        ();                        // Search without assumptions.
   bool    okay         () const;                  // FALSE means solver is in a conflicting state
+  void    setInterrupt (const volatile int* flag);  // Make 'solve' return l_Undef soon after '*flag' becomes non-zero.
 
   // Variable mode:
   // 
@@ -142,6 +143,7 @@ class Solver {
   Heap<VarOrderLt>    order_heap;       // A priority queue of variables ordered with respect to the variable activity.
   double              random_seed;      // Used by the random variable selection.
   double              progress_estimate;// Set by 'search()'.
+  const volatile int* interrupt_flag;   // If non-NULL and set, 'search()' gives up.
   bool                remove_satisfied; // Indicates whether possibly inefficient linear scan for satisfied clauses should be performed in 'simplify'.
 
   // Temporaries (to reduce allocation overhead). Each variable is prefixed by the method in which it is
@@ -165,6 +167,7 @@ class Solver {
   void     analyzeFinal     (Lit p, vec<Lit>& out_conflict);                         // COULD THIS BE IMPLEMENTED BY THE ORDINARIY "analyze" BY SOME REASONABLE GENERALIZATION?
   bool     litRedundant     (Lit p, uint32_t abstract_levels);                       // (helper method for 'analyze()')
   lbool    search           (int nof_conflicts, int nof_learnts);                    // Search for a given number of conflicts.
+  bool     interrupted      () const;                                                // Has the interrupt flag been set?
   void     reduceDB         ();                                                      // Reduce the set of learnt clauses.
   void     removeSatisfied  (vec<Clause*>& cs);                                      // Shrink 'cs' to contain only non-satisfied clauses.
 
@@ -312,6 +315,16 @@ inline void     Solver::setPolarity   (Var v, bool b) { polarity    [v] = (char)
 inline void     Solver::setDecisionVar(Var v, bool b) { decision_var[v] = (char)b; if (b) { insertVarOrder(v); } }
 inline void     Solver::setActivity   (Var v, double a) { activity[v] = a;  original_activity[v] = a; if (order_heap.inHeap(v)) order_heap.decrease(v);}
 inline lbool     Solver::solve         ()              { vec<Lit> tmp; return solve(tmp); }
+inline void      Solver::setInterrupt  (const volatile int* flag) { interrupt_flag = flag; }
+inline bool      Solver::interrupted   () const
+{
+    if (interrupt_flag == NULL) return false;
+#if defined(__clang__) || (defined(__GNUC__) && ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+    return __atomic_load_n(interrupt_flag, __ATOMIC_RELAXED) != 0;
+#else
+    return *interrupt_flag != 0;
+#endif
+}
 inline bool     Solver::okay          ()      const   { return ok; }
 
 
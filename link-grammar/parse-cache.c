@@ -0,0 +1,900 @@
+/*************************************************************************/
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+/**
+ * Per-dictionary cache of sentence parse results.
+ *
+ * Text often repeats itself: boilerplate sentences, headers, retries
+ * of the same request.  Each of them used to be pruned, counted,
+ * extracted and post-processed from scratch.  This cache keeps what
+ * sentence_parse() leaves in the sentence - the linkage counts and the
+ * post-processed, sorted linkages - so that parsing the same sentence
+ * again with the same options just copies them back.
+ *
+ * The key is the sentence string, together with the parse options
+ * that change the result: the disjunct cost cutoff, the null counts,
+ * islands_ok, the short link length, the linkage limit, the linkage
+ * selection and the cost model, and the spell-guessing of the
+ * tokenizer.  Sentences parsed with the SAT solver, whose linkages are
+ * made on demand, and parses cut short by a timeout, memory limit or
+ * cancellation are not cached.  Neither are random samples of the
+ * linkages, unless they are repeatable.
+ *
+ * An entry is stored compactly: the linkages, links, chosen disjuncts
+ * and their connectors refer to each other by array indices, and all
+ * the strings are copied in one string table, so that an entry does
+ * not depend on the sentence it came from.  A cache hit rebuilds the
+ * linkages in the sentence, with their disjuncts in the disjunct lists
+ * of the sentence words, as after a real parse.
+ *
+ * The cache is bounded by the number of sentences it holds; the least
+ * recently used ones are discarded first.  It is protected by a mutex,
+ * so that a dictionary may be shared by several threads.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "api-structures.h"
+#include "condesc.h"
+#include "parse-cache.h"
+#include "resources.h"
+#include "string-set.h"
+#include "structures.h"
+#include "utilities.h"
+#include "word-utils.h"
+
+#define NO_INDEX UINT32_MAX  /* No disjunct (null word) or no string */
+
+/* The options that change the result of a parse. */
+typedef struct
+{
+	double disjunct_cost;
+	size_t short_length;
+	size_t linkage_limit;
+	int min_null_count;
+	int max_null_count;
+	Cost_Model_type cost_model;
+	bool islands_ok;
+	bool all_short;
+	bool repeatable_rand;
+	bool best_first;
+	bool use_spell_guess;
+	bool use_cluster_disjuncts;
+} pcache_opts;
+
+typedef struct
+{
+	double disjunct_cost;
+	double corpus_cost;
+	const char * pp_violation_msg;  /* Static, or from the dictionary */
+	uint32_t first_link;            /* In link[] */
+	uint32_t num_links;
+	int index;
+	short N_violations;
+	short unused_word_cost;
+	short link_cost;
+	bool discarded;
+	bool extracted;                 /* Has links and chosen disjuncts */
+} pc_linkage;
+
+typedef struct
+{
+	uint32_t lw, rw;
+	uint32_t lc, rc;                /* In conn[] */
+	uint32_t link_name;             /* In the string table */
+} pc_link;
+
+typedef struct
+{
+	double cost;
+	uint32_t word;
+	uint32_t string;
+	uint32_t first_conn;            /* In conn[]: the left ones, then the right */
+	uint32_t num_left, num_right;
+} pc_disjunct;
+
+typedef struct
+{
+	const condesc_t * desc;         /* From the dictionary */
+	uint32_t string;
+	unsigned char length_limit;
+	bool multi;
+} pc_connector;
+
+typedef struct pcache_entry_s pcache_entry;
+struct pcache_entry_s
+{
+	/* The key */
+	char *         sentence;
+	pcache_opts    opts;
+	unsigned int   hash;
+
+	/* The parse results.  The arrays are all in one block. */
+	int            num_linkages_found;
+	size_t         num_valid_linkages;
+	size_t         null_count;
+	size_t         num_words;
+	size_t         num_linkages;
+	size_t         num_links;
+	size_t         num_disjuncts;
+	size_t         num_conn;
+	size_t         num_strings;
+	size_t         strings_size;
+	pc_linkage *   lkg;
+	pc_link *      link;
+	pc_disjunct *  dj;
+	pc_connector * conn;
+	uint32_t *     chosen;       /* num_linkages x num_words, in dj[] */
+	char *         strings;      /* One after the other, NUL-terminated */
+	void *         block;
+	size_t         block_size;
+
+	pcache_entry * next;         /* Hash chain */
+	pcache_entry * newer;        /* LRU list */
+	pcache_entry * older;
+};
+
+struct parse_cache_s
+{
+	size_t          max_sentences;
+	size_t          num_entries;
+	size_t          table_size;  /* A power of 2 */
+	pcache_entry ** table;
+	pcache_entry *  newest;
+	pcache_entry *  oldest;
+	size_t          hits;
+	size_t          misses;
+#ifdef USE_PTHREADS
+	pthread_mutex_t lock;
+#endif
+};
+
+#define PCACHE_INITIAL_TABLE_SIZE 256
+
+static inline void pcache_lock(parse_cache_t *pc)
+{
+#ifdef USE_PTHREADS
+	pthread_mutex_lock(&pc->lock);
+#endif
+}
+
+static inline void pcache_unlock(parse_cache_t *pc)
+{
+#ifdef USE_PTHREADS
+	pthread_mutex_unlock(&pc->lock);
+#endif
+}
+
+parse_cache_t * parse_cache_create(size_t max_sentences)
+{
+	parse_cache_t *pc;
+
+	pc = (parse_cache_t *) xalloc(sizeof(parse_cache_t));
+	memset(pc, 0, sizeof(parse_cache_t));
+	pc->max_sentences = max_sentences;
+	pc->table_size = PCACHE_INITIAL_TABLE_SIZE;
+	pc->table = (pcache_entry **) xalloc(pc->table_size * sizeof(pcache_entry *));
+	memset(pc->table, 0, pc->table_size * sizeof(pcache_entry *));
+#ifdef USE_PTHREADS
+	pthread_mutex_init(&pc->lock, NULL);
+#endif
+	return pc;
+}
+
+static void entry_delete(pcache_entry *ce)
+{
+	xfree(ce->sentence, strlen(ce->sentence) + 1);
+	xfree(ce->block, ce->block_size);
+	xfree(ce, sizeof(pcache_entry));
+}
+
+void parse_cache_delete(parse_cache_t *pc)
+{
+	pcache_entry *ce, *next;
+
+	if (NULL == pc) return;
+	for (ce = pc->newest; NULL != ce; ce = next)
+	{
+		next = ce->older;
+		entry_delete(ce);
+	}
+#ifdef USE_PTHREADS
+	pthread_mutex_destroy(&pc->lock);
+#endif
+	xfree(pc->table, pc->table_size * sizeof(pcache_entry *));
+	xfree(pc, sizeof(parse_cache_t));
+}
+
+/* ======================================================== */
+/* The key. */
+
+static void get_key_opts(Parse_Options opts, pcache_opts *ko)
+{
+	/* Zero the padding too, so that the keys can be hashed and
+	 * compared as bytes. */
+	memset(ko, 0, sizeof(pcache_opts));
+	ko->disjunct_cost = opts->disjunct_cost;
+	ko->short_length = opts->short_length;
+	ko->linkage_limit = opts->linkage_limit;
+	ko->min_null_count = opts->min_null_count;
+	ko->max_null_count = opts->max_null_count;
+	ko->cost_model = opts->cost_model.type;
+	ko->islands_ok = opts->islands_ok;
+	ko->all_short = opts->all_short;
+	ko->repeatable_rand = opts->repeatable_rand;
+	ko->best_first = opts->best_first;
+	ko->use_spell_guess = opts->use_spell_guess;
+	ko->use_cluster_disjuncts = opts->use_cluster_disjuncts;
+}
+
+/** FNV-1a */
+static unsigned int hash_bytes(unsigned int h, const void *p, size_t n)
+{
+	const unsigned char *s = p;
+	size_t i;
+
+	for (i = 0; i < n; i++)
+	{
+		h ^= s[i];
+		h *= 16777619U;
+	}
+	return h;
+}
+
+static unsigned int key_hash(const char *sentence, const pcache_opts *ko)
+{
+	unsigned int h = 2166136261U;
+
+	h = hash_bytes(h, sentence, strlen(sentence));
+	return hash_bytes(h, ko, sizeof(pcache_opts));
+}
+
+/* ======================================================== */
+/* Table and LRU list maintenance. The cache must be locked. */
+
+static void lru_unlink(parse_cache_t *pc, pcache_entry *ce)
+{
+	if (ce->newer) ce->newer->older = ce->older;
+	else pc->newest = ce->older;
+	if (ce->older) ce->older->newer = ce->newer;
+	else pc->oldest = ce->newer;
+}
+
+static void lru_push(parse_cache_t *pc, pcache_entry *ce)
+{
+	ce->newer = NULL;
+	ce->older = pc->newest;
+	if (pc->newest) pc->newest->newer = ce;
+	else pc->oldest = ce;
+	pc->newest = ce;
+}
+
+static pcache_entry * table_find(parse_cache_t *pc, const char *sentence,
+                                 const pcache_opts *ko, unsigned int hash)
+{
+	pcache_entry *ce;
+
+	for (ce = pc->table[hash & (pc->table_size - 1)]; NULL != ce; ce = ce->next)
+	{
+		if ((ce->hash == hash) &&
+		    (0 == memcmp(&ce->opts, ko, sizeof(pcache_opts))) &&
+		    (0 == strcmp(ce->sentence, sentence)))
+			return ce;
+	}
+	return NULL;
+}
+
+static void table_grow(parse_cache_t *pc)
+{
+	size_t i;
+	size_t new_size = 2 * pc->table_size;
+	pcache_entry **new_table;
+
+	new_table = (pcache_entry **) xalloc(new_size * sizeof(pcache_entry *));
+	memset(new_table, 0, new_size * sizeof(pcache_entry *));
+	for (i = 0; i < pc->table_size; i++)
+	{
+		pcache_entry *ce, *next;
+		for (ce = pc->table[i]; NULL != ce; ce = next)
+		{
+			next = ce->next;
+			ce->next = new_table[ce->hash & (new_size - 1)];
+			new_table[ce->hash & (new_size - 1)] = ce;
+		}
+	}
+	xfree(pc->table, pc->table_size * sizeof(pcache_entry *));
+	pc->table = new_table;
+	pc->table_size = new_size;
+}
+
+static void table_remove(parse_cache_t *pc, pcache_entry *ce)
+{
+	pcache_entry **p;
+
+	p = &pc->table[ce->hash & (pc->table_size - 1)];
+	while (*p != ce) p = &(*p)->next;
+	*p = ce->next;
+}
+
+/** Discard the least recently used entries, until n more sentences fit. */
+static void evict(parse_cache_t *pc, size_t n)
+{
+	while ((NULL != pc->oldest) && (pc->num_entries + n > pc->max_sentences))
+	{
+		pcache_entry *ce = pc->oldest;
+		lru_unlink(pc, ce);
+		table_remove(pc, ce);
+		pc->num_entries--;
+		entry_delete(ce);
+	}
+}
+
+/* ======================================================== */
+/* Storing the parse results of a sentence. */
+
+/* Growable array */
+typedef struct
+{
+	void * a;
+	size_t num;
+	size_t alloced;
+	size_t elsize;
+} pc_array;
+
+static void * array_add(pc_array *ar)
+{
+	if (ar->num == ar->alloced)
+	{
+		size_t old = ar->alloced;
+		ar->alloced = 2 * old + 16;
+		ar->a = xrealloc(ar->a, old * ar->elsize, ar->alloced * ar->elsize);
+	}
+	return (char *) ar->a + (ar->num++ * ar->elsize);
+}
+
+static void array_free(pc_array *ar)
+{
+	xfree(ar->a, ar->alloced * ar->elsize);
+}
+
+/* Map from pointers (to disjuncts, or to strings) to array indices */
+typedef struct
+{
+	const void ** key;
+	uint32_t * val;
+	size_t size;       /* A power of 2 */
+	size_t num;
+} ptr_map;
+
+static void ptr_map_init(ptr_map *m)
+{
+	m->size = 64;
+	m->num = 0;
+	m->key = (const void **) xalloc(m->size * sizeof(const void *));
+	m->val = (uint32_t *) xalloc(m->size * sizeof(uint32_t));
+	memset(m->key, 0, m->size * sizeof(const void *));
+}
+
+static void ptr_map_free(ptr_map *m)
+{
+	xfree(m->key, m->size * sizeof(const void *));
+	xfree(m->val, m->size * sizeof(uint32_t));
+}
+
+static inline size_t ptr_hash(const void *p, size_t size)
+{
+	return (((uintptr_t) p >> 3) * 2654435761U) & (size - 1);
+}
+
+/** Return the index of p, or NO_INDEX if it is not in the map. */
+static uint32_t ptr_map_find(const ptr_map *m, const void *p)
+{
+	size_t h;
+
+	for (h = ptr_hash(p, m->size); NULL != m->key[h]; h = (h + 1) & (m->size - 1))
+		if (m->key[h] == p) return m->val[h];
+	return NO_INDEX;
+}
+
+static void ptr_map_add(ptr_map *m, const void *p, uint32_t val)
+{
+	size_t h;
+
+	if (2 * (m->num + 1) > m->size)
+	{
+		ptr_map old = *m;
+		size_t i;
+
+		m->size *= 2;
+		m->num = 0;
+		m->key = (const void **) xalloc(m->size * sizeof(const void *));
+		m->val = (uint32_t *) xalloc(m->size * sizeof(uint32_t));
+		memset(m->key, 0, m->size * sizeof(const void *));
+		for (i = 0; i < old.size; i++)
+			if (NULL != old.key[i]) ptr_map_add(m, old.key[i], old.val[i]);
+		ptr_map_free(&old);
+	}
+
+	for (h = ptr_hash(p, m->size); NULL != m->key[h]; h = (h + 1) & (m->size - 1))
+		;
+	m->key[h] = p;
+	m->val[h] = val;
+	m->num++;
+}
+
+typedef struct
+{
+	pc_array lkg, link, dj, conn, chosen, strings;
+	pc_array djp;              /* The disjuncts of dj[] */
+	ptr_map dj_map, str_map;
+	size_t num_strings;
+} pc_builder;
+
+static uint32_t add_string(pc_builder *b, const char *s)
+{
+	uint32_t i;
+	size_t len;
+
+	if (NULL == s) return NO_INDEX;
+	i = ptr_map_find(&b->str_map, s);
+	if (NO_INDEX != i) return i;
+
+	len = strlen(s) + 1;
+	if (b->strings.alloced < b->strings.num + len)
+	{
+		size_t old = b->strings.alloced;
+		b->strings.alloced = 2 * (old + len) + 256;
+		b->strings.a = xrealloc(b->strings.a, old, b->strings.alloced);
+	}
+	memcpy((char *) b->strings.a + b->strings.num, s, len);
+	b->strings.num += len;
+
+	i = b->num_strings++;
+	ptr_map_add(&b->str_map, s, i);
+	return i;
+}
+
+static void add_connectors(pc_builder *b, Connector *c, uint32_t *num)
+{
+	for (*num = 0; NULL != c; c = c->next, (*num)++)
+	{
+		pc_connector *pcc = array_add(&b->conn);
+		pcc->desc = c->desc;
+		pcc->string = add_string(b, c->string);
+		pcc->length_limit = c->length_limit;
+		pcc->multi = c->multi;
+	}
+}
+
+static uint32_t add_disjunct(pc_builder *b, Disjunct *d, size_t w)
+{
+	pc_disjunct *pcd;
+	uint32_t i;
+
+	if (NULL == d) return NO_INDEX;
+	i = ptr_map_find(&b->dj_map, d);
+	if (NO_INDEX != i) return i;
+
+	i = b->dj.num;
+	pcd = array_add(&b->dj);
+	pcd->cost = d->cost;
+	pcd->word = w;
+	pcd->string = add_string(b, d->string);
+	pcd->first_conn = b->conn.num;
+	add_connectors(b, d->left, &pcd->num_left);
+	add_connectors(b, d->right, &pcd->num_right);
+	*(Disjunct **) array_add(&b->djp) = d;
+	ptr_map_add(&b->dj_map, d, i);
+	return i;
+}
+
+/** Return the index of connector c of disjunct di, or NO_INDEX. */
+static uint32_t find_connector(pc_builder *b, uint32_t di, Connector *c, bool right)
+{
+	const pc_disjunct *pcd;
+	const Disjunct *d;
+	Connector *e;
+	uint32_t k;
+
+	if (NO_INDEX == di) return NO_INDEX;
+	pcd = (pc_disjunct *) b->dj.a + di;
+	d = ((Disjunct **) b->djp.a)[di];
+	e = right ? d->right : d->left;
+
+	for (k = 0; NULL != e; e = e->next, k++)
+		if (e == c) return pcd->first_conn + (right ? pcd->num_left : 0) + k;
+	return NO_INDEX;
+}
+
+static bool add_linkage(pc_builder *b, Linkage lkg, size_t num_words)
+{
+	pc_linkage *pcl = array_add(&b->lkg);
+	uint32_t *chosen;
+	size_t w, j;
+
+	pcl->disjunct_cost = lkg->lifo.disjunct_cost;
+	pcl->corpus_cost = lkg->lifo.corpus_cost;
+	pcl->pp_violation_msg = lkg->lifo.pp_violation_msg;
+	pcl->index = lkg->lifo.index;
+	pcl->N_violations = lkg->lifo.N_violations;
+	pcl->unused_word_cost = lkg->lifo.unused_word_cost;
+	pcl->link_cost = lkg->lifo.link_cost;
+	pcl->discarded = lkg->lifo.discarded;
+	pcl->extracted = (NULL != lkg->chosen_disjuncts);
+	pcl->first_link = b->link.num;
+	pcl->num_links = lkg->num_links;
+
+	for (w = 0; w < num_words; w++)
+		*(uint32_t *) array_add(&b->chosen) = NO_INDEX;
+	if (!pcl->extracted) return true;
+	if (lkg->num_words != num_words) return false;
+
+	for (w = 0; w < num_words; w++)
+	{
+		uint32_t di = add_disjunct(b, lkg->chosen_disjuncts[w], w);
+		chosen = (uint32_t *) b->chosen.a + b->chosen.num - num_words;
+		chosen[w] = di;
+	}
+
+	chosen = (uint32_t *) b->chosen.a + b->chosen.num - num_words;
+	for (j = 0; j < lkg->num_links; j++)
+	{
+		Link *lnk = &lkg->link_array[j];
+		pc_link *pck = array_add(&b->link);
+
+		pck->lw = lnk->lw;
+		pck->rw = lnk->rw;
+		pck->link_name = add_string(b, lnk->link_name);
+		if ((lnk->lw >= num_words) || (lnk->rw >= num_words)) return false;
+		pck->lc = find_connector(b, chosen[lnk->lw], lnk->lc, true);
+		pck->rc = find_connector(b, chosen[lnk->rw], lnk->rc, false);
+		if ((NO_INDEX == pck->lc) || (NO_INDEX == pck->rc)) return false;
+	}
+	return true;
+}
+
+static size_t align8(size_t n)
+{
+	return (n + 7) & ~(size_t) 7;
+}
+
+/** Pack the arrays of the builder into one block of the entry. */
+static void pack_entry(pcache_entry *ce, pc_builder *b)
+{
+	size_t sz_lkg = align8(b->lkg.num * sizeof(pc_linkage));
+	size_t sz_link = align8(b->link.num * sizeof(pc_link));
+	size_t sz_dj = align8(b->dj.num * sizeof(pc_disjunct));
+	size_t sz_conn = align8(b->conn.num * sizeof(pc_connector));
+	size_t sz_chosen = align8(b->chosen.num * sizeof(uint32_t));
+	char *p;
+
+	ce->block_size = sz_lkg + sz_link + sz_dj + sz_conn + sz_chosen +
+	                 b->strings.num + 1;
+	ce->block = xalloc(ce->block_size);
+	p = ce->block;
+
+	ce->lkg = (pc_linkage *) p;
+	memcpy(p, b->lkg.a, b->lkg.num * sizeof(pc_linkage));
+	p += sz_lkg;
+	ce->link = (pc_link *) p;
+	memcpy(p, b->link.a, b->link.num * sizeof(pc_link));
+	p += sz_link;
+	ce->dj = (pc_disjunct *) p;
+	memcpy(p, b->dj.a, b->dj.num * sizeof(pc_disjunct));
+	p += sz_dj;
+	ce->conn = (pc_connector *) p;
+	memcpy(p, b->conn.a, b->conn.num * sizeof(pc_connector));
+	p += sz_conn;
+	ce->chosen = (uint32_t *) p;
+	memcpy(p, b->chosen.a, b->chosen.num * sizeof(uint32_t));
+	p += sz_chosen;
+	ce->strings = p;
+	if (0 != b->strings.num) memcpy(p, b->strings.a, b->strings.num);
+
+	ce->num_linkages = b->lkg.num;
+	ce->num_links = b->link.num;
+	ce->num_disjuncts = b->dj.num;
+	ce->num_conn = b->conn.num;
+	ce->num_strings = b->num_strings;
+	ce->strings_size = b->strings.num;
+}
+
+/**
+ * Return true if sentence_parse() left a result in the sentence that
+ * would be the same if it was parsed again.
+ */
+static bool is_cacheable(Sentence sent, Parse_Options opts)
+{
+	if (opts->use_sat_solver) return false;
+	if (flag_is_set(&sent->cancelled)) return false;
+	if (resources_exhausted(opts->resources)) return false;
+
+	/* A random sample of the linkages.  It is reproducible with
+	 * repeatable_rand, unless the count overflowed, in which case
+	 * the linkages are picked in extract_links() from the random
+	 * state of the sentence. */
+	if ((sent->num_linkages_found > 0) &&
+	    ((size_t) sent->num_linkages_found > opts->linkage_limit) &&
+	    !opts->best_first)
+	{
+		if (!opts->repeatable_rand) return false;
+		if (PARSE_NUM_OVERFLOW < sent->num_linkages_found) return false;
+	}
+	return true;
+}
+
+/**
+ * Add the result of parsing the sentence to the cache.  To be called
+ * at the end of sentence_parse(), before any linkage_create(), which
+ * changes the linkages.
+ */
+void parse_cache_put(parse_cache_t *pc, Sentence sent, Parse_Options opts)
+{
+	pcache_opts ko;
+	unsigned int hash;
+	pc_builder b;
+	pcache_entry *ce;
+	size_t i;
+	bool ok = true;
+
+	if (0 == pc->max_sentences) return;
+	if (!is_cacheable(sent, opts)) return;
+
+	get_key_opts(opts, &ko);
+	hash = key_hash(sent->orig_sentence, &ko);
+
+	memset(&b, 0, sizeof(b));
+	b.lkg.elsize = sizeof(pc_linkage);
+	b.link.elsize = sizeof(pc_link);
+	b.dj.elsize = sizeof(pc_disjunct);
+	b.conn.elsize = sizeof(pc_connector);
+	b.chosen.elsize = sizeof(uint32_t);
+	b.strings.elsize = 1;
+	b.djp.elsize = sizeof(Disjunct *);
+	ptr_map_init(&b.dj_map);
+	ptr_map_init(&b.str_map);
+
+	/* Only the post-processed linkages can be accessed. */
+	for (i = 0; ok && (i < sent->num_linkages_post_processed); i++)
+		ok = add_linkage(&b, &sent->lnkages[i], sent->length);
+
+	ce = NULL;
+	if (ok)
+	{
+		ce = (pcache_entry *) xalloc(sizeof(pcache_entry));
+		memset(ce, 0, sizeof(pcache_entry));
+		ce->sentence = (char *) xalloc(strlen(sent->orig_sentence) + 1);
+		strcpy(ce->sentence, sent->orig_sentence);
+		ce->opts = ko;
+		ce->hash = hash;
+		ce->num_linkages_found = sent->num_linkages_found;
+		ce->num_valid_linkages = sent->num_valid_linkages;
+		ce->null_count = sent->null_count;
+		ce->num_words = sent->length;
+		pack_entry(ce, &b);
+	}
+
+	array_free(&b.lkg);
+	array_free(&b.link);
+	array_free(&b.dj);
+	array_free(&b.conn);
+	array_free(&b.chosen);
+	array_free(&b.strings);
+	array_free(&b.djp);
+	ptr_map_free(&b.dj_map);
+	ptr_map_free(&b.str_map);
+	if (NULL == ce) return;
+
+	pcache_lock(pc);
+	if ((0 == pc->max_sentences) ||
+	    (NULL != table_find(pc, ce->sentence, &ko, hash)))
+	{
+		/* Disabled meanwhile, or another thread was faster. */
+		pcache_unlock(pc);
+		entry_delete(ce);
+		return;
+	}
+	evict(pc, 1);
+	if (pc->num_entries >= pc->table_size) table_grow(pc);
+	ce->next = pc->table[hash & (pc->table_size - 1)];
+	pc->table[hash & (pc->table_size - 1)] = ce;
+	lru_push(pc, ce);
+	pc->num_entries++;
+	pcache_unlock(pc);
+}
+
+/* ======================================================== */
+/* Reusing them. */
+
+static Connector * link_connectors(Connector **c, size_t n)
+{
+	size_t k;
+
+	if (0 == n) return NULL;
+	for (k = 0; k+1 < n; k++)
+		c[k]->next = c[k+1];
+	c[n-1]->next = NULL;
+	return c[0];
+}
+
+/** Build the linkages of the entry in the sentence. */
+static void restore_entry(const pcache_entry *ce, Sentence sent)
+{
+	const char **str;
+	Connector **conn;
+	Disjunct **dj;
+	const char *s;
+	size_t i, j, w;
+
+	str = (const char **) xalloc((ce->num_strings + 1) * sizeof(const char *));
+	for (i = 0, s = ce->strings; i < ce->num_strings; i++, s += strlen(s) + 1)
+		str[i] = string_set_add(s, sent->string_set);
+
+	conn = (Connector **) xalloc((ce->num_conn + 1) * sizeof(Connector *));
+	for (i = 0; i < ce->num_conn; i++)
+	{
+		const pc_connector *pcc = &ce->conn[i];
+		Connector *c = connector_new(NULL);
+		c->string = str[pcc->string];
+		c->desc = pcc->desc;
+		if (NULL != c->desc) c->hash = c->desc->hash;
+		c->length_limit = pcc->length_limit;
+		c->multi = pcc->multi;
+		c->word = 0;
+		conn[i] = c;
+	}
+
+	/* The chosen disjuncts go to the disjunct lists of the words,
+	 * from which they are freed with the sentence. */
+	dj = (Disjunct **) xalloc((ce->num_disjuncts + 1) * sizeof(Disjunct *));
+	for (i = 0; i < ce->num_disjuncts; i++)
+	{
+		const pc_disjunct *pcd = &ce->dj[i];
+		Disjunct *d = (Disjunct *) xalloc(sizeof(Disjunct));
+
+		d->string = str[pcd->string];
+		d->cost = pcd->cost;
+		d->marked = false;
+		d->pooled = false;
+		d->left = link_connectors(&conn[pcd->first_conn], pcd->num_left);
+		d->right = link_connectors(&conn[pcd->first_conn + pcd->num_left],
+		                           pcd->num_right);
+		d->next = sent->word[pcd->word].d;
+		sent->word[pcd->word].d = d;
+		dj[i] = d;
+	}
+
+	if (0 == ce->num_linkages)
+	{
+		sent->lnkages = NULL;
+	}
+	else
+	{
+		sent->lnkages =
+			(Linkage) exalloc(ce->num_linkages * sizeof(struct Linkage_s));
+		memset(sent->lnkages, 0, ce->num_linkages * sizeof(struct Linkage_s));
+	}
+
+	for (i = 0; i < ce->num_linkages; i++)
+	{
+		const pc_linkage *pcl = &ce->lkg[i];
+		const uint32_t *chosen = &ce->chosen[i * ce->num_words];
+		Linkage lkg = &sent->lnkages[i];
+
+		lkg->lifo.disjunct_cost = pcl->disjunct_cost;
+		lkg->lifo.corpus_cost = pcl->corpus_cost;
+		lkg->lifo.pp_violation_msg = pcl->pp_violation_msg;
+		lkg->lifo.index = pcl->index;
+		lkg->lifo.N_violations = pcl->N_violations;
+		lkg->lifo.unused_word_cost = pcl->unused_word_cost;
+		lkg->lifo.link_cost = pcl->link_cost;
+		lkg->lifo.discarded = pcl->discarded;
+		if (!pcl->extracted) continue;
+
+		/* As partial_init_linkage() and extract_links() leave them */
+		lkg->num_words = ce->num_words;
+		lkg->chosen_disjuncts =
+			(Disjunct **) exalloc(ce->num_words * sizeof(Disjunct *));
+		for (w = 0; w < ce->num_words; w++)
+			lkg->chosen_disjuncts[w] = (NO_INDEX == chosen[w]) ? NULL : dj[chosen[w]];
+
+		lkg->lasz = MAX(2 * ce->num_words, pcl->num_links);
+		lkg->link_array = (Link *) exalloc(lkg->lasz * sizeof(Link));
+		memset(lkg->link_array, 0, lkg->lasz * sizeof(Link));
+		lkg->num_links = pcl->num_links;
+		for (j = 0; j < pcl->num_links; j++)
+		{
+			const pc_link *pck = &ce->link[pcl->first_link + j];
+			Link *lnk = &lkg->link_array[j];
+
+			lnk->lw = pck->lw;
+			lnk->rw = pck->rw;
+			lnk->lc = conn[pck->lc];
+			lnk->rc = conn[pck->rc];
+			lnk->link_name = (NO_INDEX == pck->link_name) ? NULL : str[pck->link_name];
+		}
+	}
+
+	sent->num_linkages_found = ce->num_linkages_found;
+	sent->num_linkages_alloced = ce->num_linkages;
+	sent->num_linkages_post_processed = ce->num_linkages;
+	sent->num_valid_linkages = ce->num_valid_linkages;
+	sent->null_count = ce->null_count;
+
+	xfree(dj, (ce->num_disjuncts + 1) * sizeof(Disjunct *));
+	xfree(conn, (ce->num_conn + 1) * sizeof(Connector *));
+	xfree(str, (ce->num_strings + 1) * sizeof(const char *));
+}
+
+/**
+ * If the sentence has been parsed before with the same options, put
+ * the result in it, as sentence_parse() would, and return true.
+ * The sentence must have no linkages and no disjuncts.
+ */
+bool parse_cache_get(parse_cache_t *pc, Sentence sent, Parse_Options opts)
+{
+	pcache_opts ko;
+	unsigned int hash;
+	pcache_entry *ce;
+
+	if (0 == pc->max_sentences) return false;
+	if (opts->use_sat_solver) return false;
+
+	get_key_opts(opts, &ko);
+	hash = key_hash(sent->orig_sentence, &ko);
+
+	pcache_lock(pc);
+	ce = table_find(pc, sent->orig_sentence, &ko, hash);
+	/* Check the number of words too, in case the sentence was
+	 * split in some other way than it was then. */
+	if ((NULL == ce) || (ce->num_words != sent->length))
+	{
+		pc->misses++;
+		pcache_unlock(pc);
+		return false;
+	}
+	pc->hits++;
+	lru_unlink(pc, ce);
+	lru_push(pc, ce);
+	restore_entry(ce, sent);
+	pcache_unlock(pc);
+	return true;
+}
+
+/* ======================================================== */
+
+/**
+ * Set the maximal number of sentences the cache may hold.
+ * Zero disables the cache, and discards its current content.
+ */
+void parse_cache_set_size(parse_cache_t *pc, size_t max_sentences)
+{
+	pcache_lock(pc);
+	pc->max_sentences = max_sentences;
+	evict(pc, 0);
+	pcache_unlock(pc);
+}
+
+size_t parse_cache_get_size(parse_cache_t *pc)
+{
+	return pc->max_sentences;
+}
+
+void parse_cache_get_stats(parse_cache_t *pc, size_t *hits, size_t *misses)
+{
+	pcache_lock(pc);
+	if (hits) *hits = pc->hits;
+	if (misses) *misses = pc->misses;
+	pcache_unlock(pc);
+}
@@ -0,0 +1,32 @@
+/*************************************************************************/
+/* All rights reserved                                                   */
+/*                                                                       */
+/* Use of the link grammar parsing system is subject to the terms of the */
+/* license set forth in the LICENSE file included with this software.    */
+/* This license allows free redistribution and use in source and binary  */
+/* forms, with or without modification, subject to certain conditions.   */
+/*                                                                       */
+/*************************************************************************/
+
+#ifndef _PARSE_CACHE_H_
+#define _PARSE_CACHE_H_
+
+#include "api-types.h"
+#include "link-includes.h"
+
+/* Default upper bound on the number of sentences held by a cache.
+ * The cache is disabled by default: it pays off only when the same
+ * sentences are parsed again and again (boilerplate text, retries).
+ * Use dictionary_set_parse_cache_size() to enable it. */
+#define PARSE_CACHE_DEFAULT_SIZE 0
+
+parse_cache_t * parse_cache_create(size_t max_sentences);
+void parse_cache_delete(parse_cache_t *);
+void parse_cache_set_size(parse_cache_t *, size_t max_sentences);
+size_t parse_cache_get_size(parse_cache_t *);
+void parse_cache_get_stats(parse_cache_t *, size_t *hits, size_t *misses);
+
+bool parse_cache_get(parse_cache_t *, Sentence, Parse_Options);
+void parse_cache_put(parse_cache_t *, Sentence, Parse_Options);
+
+#endif /* _PARSE_CACHE_H_ */
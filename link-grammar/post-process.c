@@ -312,7 +312,10 @@ static bool apply_rules(Postprocessor *pp,
 	{
 		if (!applyfn(pp, sublinkage, &(rule_array[i])))
 		{
-			rule_array[i].use_count ++;
+			/* The rules are shared by all the threads that use the
+			 * dictionary; keep their statistics only when they are
+			 * going to be reported (see report_pp_stats()). */
+			if (verbosity > 2) rule_array[i].use_count ++;
 			return false;
 		}
 	}
@@ -59,9 +59,10 @@ set_connector_length_limits(Sentence sent, Parse_Options opts)
 }
 
 /**
- * Assumes that the sentence expression lists have been generated.
+ * Build the lists of disjuncts of the words, without duplicates.
+ * Returns FALSE if the resources got exhausted.
  */
-void prepare_to_parse(Sentence sent, Parse_Options opts)
+static bool build_disjuncts(Sentence sent, Parse_Options opts)
 {
 	size_t i;
 
@@ -77,7 +78,7 @@ void prepare_to_parse(Sentence sent, Parse_Options opts)
 
 		/* Some long Russian sentences can really blow up, here. */
 		if (resources_exhausted(opts->resources))
-			return;
+			return false;
 	}
 	print_time(opts, "Eliminated duplicate disjuncts");
 
@@ -87,6 +88,64 @@ void prepare_to_parse(Sentence sent, Parse_Options opts)
 	}
 
 	set_connector_length_limits(sent, opts);
-	pp_and_power_prune(sent, opts);
+	return true;
 }
 
+/**
+ * Assumes that the sentence expression lists have been generated.
+ * The disjuncts are pruned for the smallest null count to be tried.
+ */
+void prepare_to_parse(Sentence sent, Parse_Options opts)
+{
+	if (!build_disjuncts(sent, opts)) return;
+	pp_and_power_prune(sent, opts, (opts->min_null_count > 0));
+	pack_sentence_disjuncts(sent);
+	print_time(opts, "Packed disjuncts");
+}
+
+/**
+ * The disjuncts of a sentence that was prepared for a parse without
+ * null links lack those that can only be used in a linkage with null
+ * links.  Restore them, by building the disjuncts again and pruning
+ * them with null links allowed.  The disjuncts that survived the first
+ * pruning are kept, so that what was memoized about them remains valid,
+ * unless a word in its span has changed.
+ *
+ * changed[w] is set to TRUE for the words whose disjuncts (or their
+ * connectors) have changed.  Returns TRUE if any of them has changed.
+ */
+bool relax_null_pruning(Sentence sent, Parse_Options opts, bool * changed)
+{
+	size_t i;
+	bool any_changed = false;
+	Disjunct ** pruned;
+
+	pruned = (Disjunct **) xalloc(sent->length * sizeof(Disjunct *));
+	for (i=0; i<sent->length; i++)
+		pruned[i] = sent->word[i].d;
+
+	if (!build_disjuncts(sent, opts))
+	{
+		for (i=0; i<sent->length; i++) {
+			free_disjuncts(sent->word[i].d);
+			sent->word[i].d = pruned[i];
+		}
+		xfree(pruned, sent->length * sizeof(Disjunct *));
+		return false;
+	}
+	pp_and_power_prune(sent, opts, true);
+
+	for (i=0; i<sent->length; i++) {
+		changed[i] = false;
+		sent->word[i].d = restore_disjuncts(pruned[i], sent->word[i].d,
+		                                    &changed[i]);
+		any_changed = any_changed || changed[i];
+	}
+	xfree(pruned, sent->length * sizeof(Disjunct *));
+
+	if (verbosity > 2) {
+		printf("\nAfter restoring the disjuncts for null links:\n");
+		print_disjunct_counts(sent);
+	}
+	return any_changed;
+}
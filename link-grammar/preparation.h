@@ -14,4 +14,5 @@
 #include "link-includes.h"
 
 void prepare_to_parse(Sentence, Parse_Options);
+bool relax_null_pruning(Sentence, Parse_Options, bool *changed);
 
@@ -12,10 +12,12 @@
 /*************************************************************************/
 
 #include "api-structures.h"
+#include "condesc.h"
 #include "count.h"
 #include "dict-api.h"  /* for print_expression when debugging */
 #include "disjunct-utils.h"
 #include "externs.h"
+#include "memory-pool.h"
 #include "post-process.h"
 #include "print.h"
 #include "prune.h"
@@ -51,6 +53,7 @@ struct power_table_s
 	unsigned int *r_table_size;
 	C_list *** l_table;
 	C_list *** r_table;
+	Pool_desc * C_list_pool;     /* the entries of the tables */
 };
 
 typedef struct cms_struct Cms;
@@ -143,7 +146,7 @@ static inline unsigned int hash_S(Connector * c)
  */
 static inline bool prune_match(Connector *a, Connector *b)
 {
-	return easy_match(a->string, b->string);
+	return easy_match_connectors(a, b);
 }
 
 static void zero_connector_table(connector_table *ct)
@@ -571,7 +574,8 @@ static inline bool matches_S(connector_table *ct, Connector * c, char dir)
  * in e that are not matched by anything in the current set.
  * Returns the number of connectors so marked.
  */
-static int mark_dead_connectors(connector_table *ct, Exp * e, char dir)
+static int mark_dead_connectors(connector_table *ct,
+                                const condesc_table_t *cdt, Exp * e, char dir)
 {
 	int count;
 	count = 0;
@@ -582,6 +586,8 @@ static int mark_dead_connectors(connector_table *ct, Exp * e, char dir)
 			Connector dummy;
 			init_connector(&dummy);
 			dummy.string = e->u.string;
+			dummy.desc = condesc_lookup(cdt, dummy.string);
+			if (NULL != dummy.desc) dummy.hash = dummy.desc->hash;
 			if (!matches_S(ct, &dummy, dir))
 			{
 				e->u.string = NULL;
@@ -594,7 +600,7 @@ static int mark_dead_connectors(connector_table *ct, Exp * e, char dir)
 		E_list *l;
 		for (l = e->u.l; l != NULL; l = l->next)
 		{
-			count += mark_dead_connectors(ct, l->e, dir);
+			count += mark_dead_connectors(ct, cdt, l->e, dir);
 		}
 	}
 	return count;
@@ -605,15 +611,18 @@ static int mark_dead_connectors(connector_table *ct, Exp * e, char dir)
  * Return a list of allocated dummy connectors; these will need to be
  * freed.
  */
-static Connector * insert_connectors(connector_table *ct, Exp * e,
+static Connector * insert_connectors(connector_table *ct,
+                                     const condesc_table_t *cdt, Exp * e,
                                      Connector *alloc_list, int dir)
 {
 	if (e->type == CONNECTOR_type)
 	{
 		if (e->dir == dir)
 		{
-			Connector *dummy = connector_new();
+			Connector *dummy = connector_new(NULL);
 			dummy->string = e->u.string;
+			dummy->desc = condesc_lookup(cdt, dummy->string);
+			if (NULL != dummy->desc) dummy->hash = dummy->desc->hash;
 			insert_connector(ct, dummy);
 			dummy->next = alloc_list;
 			alloc_list = dummy;
@@ -624,7 +633,7 @@ static Connector * insert_connectors(connector_table *ct, Exp * e,
 		E_list *l;
 		for (l=e->u.l; l!=NULL; l=l->next)
 		{
-			alloc_list = insert_connectors(ct, l->e, alloc_list, dir);
+			alloc_list = insert_connectors(ct, cdt, l->e, alloc_list, dir);
 		}
 	}
 	return alloc_list;
@@ -665,6 +674,7 @@ void expression_prune(Sentence sent)
 	size_t w;
 	Connector *ct[CONTABSZ];
 	Connector *dummy_list = NULL;
+	const condesc_table_t *cdt = sent->dict->condesc_table;
 
 	zero_connector_table(ct);
 
@@ -680,7 +690,7 @@ void expression_prune(Sentence sent)
 			for (x = sent->word[w].x; x != NULL; x = x->next)
 			{
 DBG(printf("before marking: "); print_expression(x->exp); printf("\n"););
-				N_deleted += mark_dead_connectors(ct, x->exp, '-');
+				N_deleted += mark_dead_connectors(ct, cdt, x->exp, '-');
 DBG(printf(" after marking: "); print_expression(x->exp); printf("\n"););
 			}
 			for (x = sent->word[w].x; x != NULL; x = x->next)
@@ -694,7 +704,7 @@ DBG(printf("after purging: "); print_expression(x->exp); printf("\n"););
 			clean_up_expressions(sent, w);
 			for (x = sent->word[w].x; x != NULL; x = x->next)
 			{
-				dummy_list = insert_connectors(ct, x->exp, dummy_list, '+');
+				dummy_list = insert_connectors(ct, cdt, x->exp, dummy_list, '+');
 			}
 		}
 
@@ -718,7 +728,7 @@ DBG(printf("after purging: "); print_expression(x->exp); printf("\n"););
 			for (x = sent->word[w].x; x != NULL; x = x->next)
 			{
 /*	 printf("before marking: "); print_expression(x->exp); printf("\n"); */
-				N_deleted += mark_dead_connectors(ct, x->exp, '+');
+				N_deleted += mark_dead_connectors(ct, cdt, x->exp, '+');
 /*	 printf("after marking: "); print_expression(x->exp); printf("\n"); */
 			}
 			for (x = sent->word[w].x; x != NULL; x = x->next)
@@ -730,7 +740,7 @@ DBG(printf("after purging: "); print_expression(x->exp); printf("\n"););
 			clean_up_expressions(sent, w);  /* gets rid of X_nodes with NULL exp */
 			for (x = sent->word[w].x; x != NULL; x = x->next)
 			{
-				dummy_list = insert_connectors(ct, x->exp, dummy_list, '-');
+				dummy_list = insert_connectors(ct, cdt, x->exp, dummy_list, '-');
 			}
 		}
 
@@ -824,14 +834,8 @@ static int right_connector_count(Disjunct * d)
 	return i;
 }
 
-static void free_C_list(C_list * t)
-{
-	C_list *xt;
-	for (; t!=NULL; t=xt) {
-		xt = t->next;
-		xfree((char *)t, sizeof(C_list));
-	}
-}
+/* Number of C_lists per block of the pool */
+#define C_LIST_BLOCK 4096
 
 /**
  * free all of the hash tables and C_lists
@@ -839,22 +843,13 @@ static void free_C_list(C_list * t)
 static void power_table_delete(power_table *pt)
 {
 	unsigned int w;
-	unsigned int i;
 
 	for (w = 0; w < pt->power_table_size; w++)
 	{
-		for (i = 0; i < pt->l_table_size[w]; i++)
-		{
-			free_C_list(pt->l_table[w][i]);
-		}
 		xfree((char *)pt->l_table[w], pt->l_table_size[w] * sizeof (C_list *));
-
-		for (i = 0; i < pt->r_table_size[w]; i++)
-		{
-			free_C_list(pt->r_table[w][i]);
-		}
 		xfree((char *)pt->r_table[w], pt->r_table_size[w] * sizeof (C_list *));
 	}
+	pool_delete(pt->C_list_pool);
 	xfree(pt->l_table_size, 2 * pt->power_table_size * sizeof(unsigned int));
 	xfree(pt->l_table, 2 * pt->power_table_size * sizeof(C_list **));
 	xfree(pt, sizeof(power_table));
@@ -864,12 +859,13 @@ static void power_table_delete(power_table *pt)
  * The disjunct d (whose left or right pointer points to c) is put
  * into the appropriate hash table
  */
-static void put_into_power_table(unsigned int size, C_list ** t, Connector * c, bool shal)
+static void put_into_power_table(Pool_desc *mp, unsigned int size, C_list ** t,
+                                 Connector * c, bool shal)
 {
 	unsigned int h;
 	C_list * m;
 	h = connector_hash(c) & (size-1);
-	m = (C_list *) xalloc (sizeof(C_list));
+	m = (C_list *) pool_alloc(mp);
 	m->next = t[h];
 	t[h] = m;
 	m->c = c;
@@ -903,6 +899,7 @@ static power_table * power_table_new(Sentence sent)
 	pt->r_table_size = pt->l_table_size + sent->length;
 	pt->l_table = xalloc (2 * sent->length * sizeof(C_list **));
 	pt->r_table = pt->l_table + sent->length;
+	pt->C_list_pool = pool_new("C_list", sizeof(C_list), C_LIST_BLOCK);
 
    /* First, we initialize the word fields of the connectors, and
 	  eliminate those disjuncts with illegal connectors */
@@ -951,9 +948,9 @@ static power_table * power_table_new(Sentence sent)
 		for (d=sent->word[w].d; d!=NULL; d=d->next) {
 			c = d->left;
 			if (c != NULL) {
-				put_into_power_table(size, t, c, true);
+				put_into_power_table(pt->C_list_pool, size, t, c, true);
 				for (c=c->next; c!=NULL; c=c->next){
-					put_into_power_table(size, t, c, false);
+					put_into_power_table(pt->C_list_pool, size, t, c, false);
 				}
 			}
 		}
@@ -968,9 +965,9 @@ static power_table * power_table_new(Sentence sent)
 		for (d=sent->word[w].d; d!=NULL; d=d->next) {
 			c = d->right;
 			if (c != NULL) {
-				put_into_power_table(size, t, c, true);
+				put_into_power_table(pt->C_list_pool, size, t, c, true);
 				for (c=c->next; c!=NULL; c=c->next){
-					put_into_power_table(size, t, c, false);
+					put_into_power_table(pt->C_list_pool, size, t, c, false);
 				}
 			}
 		}
@@ -984,7 +981,7 @@ static power_table * power_table_new(Sentence sent)
  * who are obsolete.  The word fields of an obsolete one has been set to
  * BAD_WORD.
  */
-static void clean_table(unsigned int size, C_list ** t)
+static void clean_table(Pool_desc *mp, unsigned int size, C_list ** t)
 {
 	unsigned int i;
 	C_list * m, * xm, * head;
@@ -996,7 +993,7 @@ static void clean_table(unsigned int size, C_list ** t)
 				m->next = head;
 				head = m;
 			} else {
-				xfree((char *) m, sizeof(C_list));
+				pool_free(mp, m);
 			}
 		}
 		t[i] = head;
@@ -1036,7 +1033,7 @@ static bool possible_connection(prune_context *pc,
 	dist = rword - lword;
 	if (dist > lc->length_limit || dist > rc->length_limit) return false;
 
-	return easy_match(lc->string, rc->string);
+	return easy_match_connectors(lc, rc);
 }
 
 /**
@@ -1162,8 +1159,12 @@ right_connector_list_update(prune_context *pc, Sentence sent, Connector *c,
 	return (foundmatch ? n : sent->length);
 }
 
-/** The return value is the number of disjuncts deleted */
-int power_prune(Sentence sent, Parse_Options opts)
+/**
+ * The return value is the number of disjuncts deleted.
+ * Unless null_links is TRUE, the disjuncts that can only be used in
+ * a linkage with null links are deleted too.
+ */
+int power_prune(Sentence sent, Parse_Options opts, bool null_links)
 {
 	power_table *pt;
 	prune_context *pc;
@@ -1173,7 +1174,7 @@ int power_prune(Sentence sent, Parse_Options opts)
 
 	pc = (prune_context *) xalloc (sizeof(prune_context));
 	pc->power_cost = 0;
-	pc->null_links = (opts->min_null_count > 0);
+	pc->null_links = null_links;
 	pc->N_changed = 1;  /* forces it always to make at least two passes */
 
 	pc->sent = sent;
@@ -1201,7 +1202,7 @@ int power_prune(Sentence sent, Parse_Options opts)
 				}
 			}
 
-			clean_table(pt->r_table_size[w], pt->r_table[w]);
+			clean_table(pt->C_list_pool, pt->r_table_size[w], pt->r_table[w]);
 			nd = NULL;
 			for (d = sent->word[w].d; d != NULL; d = dx) {
 				dx = d->next;
@@ -1235,7 +1236,7 @@ int power_prune(Sentence sent, Parse_Options opts)
 					total_deleted++;
 				}
 			}
-			clean_table(pt->l_table_size[w], pt->l_table[w]);
+			clean_table(pt->C_list_pool, pt->l_table_size[w], pt->l_table[w]);
 			nd = NULL;
 			for (d = sent->word[w].d; d != NULL; d = dx) {
 				dx = d->next;
@@ -1579,7 +1580,8 @@ static int pp_prune(Sentence sent, Parse_Options opts)
 							if (!rule_satisfiable(cmt, link_set))
 							{
 								deleteme = true;
-								rule->use_count++;
+								/* Shared; see apply_rules() */
+								if (verbosity > 2) rule->use_count++;
 							}
 							if (deleteme) break;
 						}
@@ -1631,14 +1633,14 @@ static int pp_prune(Sentence sent, Parse_Options opts)
  * power pp power pp power pp....
  * Make sure you do them both at least once.
  */
-void pp_and_power_prune(Sentence sent, Parse_Options opts)
+void pp_and_power_prune(Sentence sent, Parse_Options opts, bool null_links)
 {
-	power_prune(sent, opts);
+	power_prune(sent, opts, null_links);
 
 	for (;;) {
 		if (parse_options_resources_exhausted(opts)) break;
 		if (pp_prune(sent, opts) == 0) break;
 		if (parse_options_resources_exhausted(opts)) break;
-		if (power_prune(sent, opts) == 0) break;
+		if (power_prune(sent, opts, null_links) == 0) break;
 	}
 }
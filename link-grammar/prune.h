@@ -13,6 +13,6 @@
 #include "api-types.h"
 #include "link-includes.h"
 
-int        power_prune(Sentence, Parse_Options);
-void       pp_and_power_prune(Sentence, Parse_Options);
+int        power_prune(Sentence, Parse_Options, bool null_links);
+void       pp_and_power_prune(Sentence, Parse_Options, bool null_links);
 void       expression_prune(Sentence);
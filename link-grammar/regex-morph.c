@@ -14,15 +14,37 @@
  * including <stddef.h> before <regex.h> (<sys/types.h> is not enough) */
 #include <stddef.h>
 #include <regex.h>
+#include <ctype.h>
+#include <string.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
 #include "api-structures.h"
 #include "dict-api.h"
 #include "link-includes.h"
 #include "regex-morph.h"
 #include "structures.h"
+#include "word-utils.h"
 
 /**
  * Support for the regular-expression based token matching system
  * using standard POSIX regex.
+ *
+ * The regexs of a list are tried in order, and the first one that
+ * matches wins.  Most tokens match none of them, or only one of the
+ * last ones, so trying each regex in turn with regexec() is slow.
+ * When a list is compiled, each pattern is analyzed for two cheap
+ * necessary conditions of a match: the set of bytes the token may
+ * start with (for patterns anchored by ^), and a literal suffix the
+ * token must end with (for patterns ending with a literal string and
+ * $).  The regexs of the list are then indexed by their possible first
+ * bytes, so that a token is only run through regexec() for the regexs
+ * that can start with its first byte and whose suffix it has, still in
+ * the order of the list.  The conditions are conservative: whatever
+ * construct the analysis doesn't understand makes it allow everything.
+ *
+ * The result for a token is also kept in a small direct-mapped memo,
+ * since the same unknown tokens tend to be matched again and again.
  */
 
 /**
@@ -42,15 +64,568 @@ static void prt_regerror(const char *msg, Regex_node *re, int rc)
 	free(errbuf);
 }
 
+/* ======================================================== */
+/* Pattern analysis. */
+
+#define BYTESET_SIZE (256/8)
+typedef unsigned char byteset[BYTESET_SIZE];
+
+static inline void byteset_add(byteset set, unsigned char c)
+{
+	set[c >> 3] |= 1 << (c & 7);
+}
+
+static inline bool byteset_has(const byteset set, unsigned char c)
+{
+	return 0 != (set[c >> 3] & (1 << (c & 7)));
+}
+
+static void byteset_add_all(byteset set)
+{
+	memset(set, 0xff, BYTESET_SIZE);
+}
+
+/** Add the bytes that may start a multi-byte character. */
+static void byteset_add_high(byteset set)
+{
+	int c;
+	for (c = 0x80; c < 0x100; c++) byteset_add(set, c);
+}
+
+static void byteset_union(byteset set, const byteset other)
+{
+	int i;
+	for (i = 0; i < BYTESET_SIZE; i++) set[i] |= other[i];
+}
+
+/* The longest literal suffix that is kept. */
+#define MAX_SUFFIX 32
+
+typedef struct
+{
+	const char * p;          /* Parse position in the pattern */
+	bool unknown;            /* Found a construct that isn't supported */
+	bool end_anchored;       /* The top level ended with '$' */
+	char suffix[MAX_SUFFIX]; /* The literal run at the end of the top level */
+	size_t suffix_len;
+} pattern_parse;
+
+static const struct
+{
+	const char * name;
+	int (*is)(int);
+} char_classes[] =
+{
+	{ "alnum", isalnum }, { "alpha", isalpha }, { "blank", isblank },
+	{ "cntrl", iscntrl }, { "digit", isdigit }, { "graph", isgraph },
+	{ "lower", islower }, { "print", isprint }, { "punct", ispunct },
+	{ "space", isspace }, { "upper", isupper }, { "xdigit", isxdigit },
+};
+
+/**
+ * Add the ASCII members of the character class of the given name,
+ * and any multi-byte character.  Returns false if the class is not
+ * known.
+ */
+static bool byteset_add_class(byteset set, const char *name, size_t len)
+{
+	size_t i;
+	int c;
+
+	for (i = 0; i < sizeof(char_classes)/sizeof(char_classes[0]); i++)
+	{
+		if ((strlen(char_classes[i].name) != len) ||
+		    (0 != strncmp(char_classes[i].name, name, len))) continue;
+
+		for (c = 1; c < 0x80; c++)
+			if (char_classes[i].is(c)) byteset_add(set, c);
+		byteset_add_high(set);
+		return true;
+	}
+	return false;
+}
+
+/** The length of the (UTF-8) character at p. */
+static size_t char_length(const char *p)
+{
+	size_t n = 1;
+	if (0 == (*p & 0x80)) return 1;
+	while ((0x80 == (p[n] & 0xc0)) && (n < 4)) n++;
+	return n;
+}
+
+/**
+ * Parse the bracket expression at ps->p (just after the '['), and add
+ * the bytes its characters may start with to set.
+ * Ranges are sorted according to the locale, so a range of letters
+ * adds all the letters (and any multi-byte character), and a range of
+ * anything else but digits adds everything.
+ */
+static void parse_bracket(pattern_parse *ps, byteset set)
+{
+	const char *p = ps->p;
+	bool negated = false;
+
+	if ('^' == *p)
+	{
+		negated = true;
+		p++;
+	}
+	if (']' == *p)
+	{
+		byteset_add(set, ']');
+		p++;
+	}
+
+	while (']' != *p)
+	{
+		unsigned char c = *p;
+
+		if ('\0' == c)
+		{
+			ps->unknown = true;
+			ps->p = p;
+			return;
+		}
+		if (('[' == c) && ((':' == p[1]) || ('=' == p[1]) || ('.' == p[1])))
+		{
+			char kind = p[1];
+			const char *name = p + 2;
+			const char *end = name;
+
+			while (('\0' != *end) && !((kind == end[0]) && (']' == end[1])))
+				end++;
+			if ('\0' == *end)
+			{
+				ps->unknown = true;
+				ps->p = end;
+				return;
+			}
+			if ((':' != kind) || !byteset_add_class(set, name, end - name))
+				byteset_add_all(set);
+			p = end + 2;
+			continue;
+		}
+		if (c >= 0x80)
+		{
+			byteset_add_high(set);
+			p += char_length(p);
+			continue;
+		}
+		if (('-' == p[1]) && (']' != p[2]) && ('\0' != p[2]))
+		{
+			unsigned char d = p[2];
+			int i;
+
+			if (isdigit(c) && isdigit(d))
+			{
+				for (i = c; i <= d; i++) byteset_add(set, i);
+			}
+			else if (isalpha(c) && isalpha(d))
+			{
+				for (i = 1; i < 0x80; i++)
+					if (isalpha(i)) byteset_add(set, i);
+				byteset_add_high(set);
+			}
+			else
+			{
+				byteset_add_all(set);
+			}
+			p += 2 + char_length(p + 2);
+			continue;
+		}
+		byteset_add(set, c);
+		p++;
+	}
+
+	if (negated) byteset_add_all(set);
+	ps->p = p + 1;
+}
+
+static void parse_alternatives(pattern_parse *, byteset, bool *);
+
+/**
+ * Parse a sequence of atoms, up to a '|', a ')' or the end of the
+ * pattern.  Add to first the bytes the sequence may start with, and set
+ * *nullable if it may match the empty string.  At the top level, also
+ * keep the run of literal characters that ends the sequence.
+ */
+static void parse_sequence(pattern_parse *ps, byteset first, bool *nullable,
+                           bool top)
+{
+	bool seq_nullable = true;
+
+	if (top)
+	{
+		ps->end_anchored = false;
+		ps->suffix_len = 0;
+	}
+
+	while (('\0' != *ps->p) && ('|' != *ps->p) && (')' != *ps->p))
+	{
+		byteset atom_first;
+		bool atom_nullable = false;
+		bool is_literal = false;
+		bool is_anchor = false;
+		const char *atom = ps->p;
+		size_t atom_len = 0;
+
+		memset(atom_first, 0, BYTESET_SIZE);
+		switch (*ps->p)
+		{
+			case '^':
+			case '$':
+				atom_nullable = true;
+				is_anchor = true;
+				ps->p++;
+				break;
+			case '.':
+				byteset_add_all(atom_first);
+				ps->p++;
+				break;
+			case '[':
+				ps->p++;
+				parse_bracket(ps, atom_first);
+				break;
+			case '(':
+				ps->p++;
+				parse_alternatives(ps, atom_first, &atom_nullable);
+				if (ps->unknown) return;
+				if (')' != *ps->p)
+				{
+					ps->unknown = true;
+					return;
+				}
+				ps->p++;
+				break;
+			case '\\':
+				ps->p++;
+				if ('w' == *ps->p)
+				{
+					int c;
+					for (c = 1; c < 0x80; c++)
+						if (isalnum(c)) byteset_add(atom_first, c);
+					byteset_add(atom_first, '_');
+					byteset_add_high(atom_first);
+					ps->p++;
+				}
+				else if (('\0' == *ps->p) || isalnum((unsigned char)*ps->p))
+				{
+					/* Back-references, and the other GNU escapes */
+					ps->unknown = true;
+					return;
+				}
+				else
+				{
+					atom = ps->p;
+					atom_len = char_length(ps->p);
+					byteset_add(atom_first, *ps->p);
+					ps->p += atom_len;
+					is_literal = true;
+				}
+				break;
+			case '*':
+			case '+':
+			case '?':
+			case '{':
+				ps->unknown = true;
+				return;
+			default:
+				atom_len = char_length(ps->p);
+				byteset_add(atom_first, *ps->p);
+				ps->p += atom_len;
+				is_literal = true;
+				break;
+		}
+		if (ps->unknown) return;
+
+		/* Quantifiers */
+		while (('*' == *ps->p) || ('+' == *ps->p) ||
+		       ('?' == *ps->p) || ('{' == *ps->p))
+		{
+			is_literal = false;
+			if ('{' == *ps->p)
+			{
+				if ((',' != ps->p[1]) && !isdigit((unsigned char)ps->p[1]))
+				{
+					ps->unknown = true;
+					return;
+				}
+				if (('0' == ps->p[1]) || (',' == ps->p[1])) atom_nullable = true;
+				while (('\0' != *ps->p) && ('}' != *ps->p)) ps->p++;
+				if ('\0' == *ps->p)
+				{
+					ps->unknown = true;
+					return;
+				}
+			}
+			else if ('+' != *ps->p)
+			{
+				atom_nullable = true;
+			}
+			ps->p++;
+		}
+
+		if (top)
+		{
+			if (is_anchor && ('$' == *atom))
+			{
+				ps->end_anchored = ('\0' == *ps->p);
+			}
+			else if (!is_literal)
+			{
+				ps->suffix_len = 0;
+			}
+			else
+			{
+				/* Any end of a literal run is still a required suffix. */
+				if (ps->suffix_len + atom_len > MAX_SUFFIX) ps->suffix_len = 0;
+				memcpy(ps->suffix + ps->suffix_len, atom, atom_len);
+				ps->suffix_len += atom_len;
+			}
+		}
+
+		if (seq_nullable) byteset_union(first, atom_first);
+		if (!atom_nullable) seq_nullable = false;
+	}
+
+	if (seq_nullable) *nullable = true;
+}
+
+static void parse_alternatives(pattern_parse *ps, byteset first, bool *nullable)
+{
+	parse_sequence(ps, first, nullable, false);
+	while (!ps->unknown && ('|' == *ps->p))
+	{
+		ps->p++;
+		parse_sequence(ps, first, nullable, false);
+	}
+}
+
+/**
+ * Find the bytes a string matching the pattern may start with, and
+ * a literal suffix it must end with (of length *suffix_len, possibly
+ * zero).  If the pattern may match other than at the start of the
+ * string, or is not understood, the string may start with any byte.
+ */
+static void analyze_pattern(const char *pattern, byteset first,
+                            char *suffix, size_t *suffix_len)
+{
+	pattern_parse ps;
+	bool nullable = false;
+	bool anchored = true;
+	int num_alternatives = 0;
+
+	memset(&ps, 0, sizeof(ps));
+	memset(first, 0, BYTESET_SIZE);
+	*suffix_len = 0;
+
+	ps.p = pattern;
+	do
+	{
+		if (0 < num_alternatives) ps.p++;
+		if ('^' != *ps.p) anchored = false;
+		parse_sequence(&ps, first, &nullable, true);
+		num_alternatives++;
+	}
+	while (!ps.unknown && ('|' == *ps.p));
+
+	if (ps.unknown || ('\0' != *ps.p))
+	{
+		byteset_add_all(first);
+		return;
+	}
+	if (!anchored || nullable) byteset_add_all(first);
+
+	/* The suffix is that of the only alternative. */
+	if ((1 == num_alternatives) && ps.end_anchored)
+	{
+		memcpy(suffix, ps.suffix, ps.suffix_len);
+		*suffix_len = ps.suffix_len;
+	}
+}
+
+/* ======================================================== */
+/* The matcher of a list of regexs. */
+
+#define REGEX_MEMO_SIZE 1024 /* A power of 2 */
+
+typedef struct
+{
+	Regex_node * rn;
+	char * suffix;            /* Literal suffix of any match */
+	size_t suffix_len;
+} regex_entry;
+
+typedef struct
+{
+	char * word;
+	const char * name;        /* NULL if no regex matches word */
+} regex_memo_entry;
+
+typedef struct
+{
+	regex_entry * entry;      /* The regexs of the list, in order */
+	size_t num_entries;
+	unsigned int * candidates; /* Entry numbers, by first byte */
+	size_t num_candidates;
+	size_t start[257];        /* The entries that may match a string
+	                           * starting with byte b are candidates
+	                           * start[b] .. start[b+1]-1 */
+	regex_memo_entry memo[REGEX_MEMO_SIZE];
+#ifdef USE_PTHREADS
+	pthread_mutex_t memo_lock;
+#endif
+} regex_matcher;
+
+static regex_matcher * matcher_create(Regex_node *re)
+{
+	regex_matcher *m;
+	byteset *first;
+	Regex_node *rn;
+	size_t i, n;
+	int b;
+
+	m = (regex_matcher *) malloc(sizeof(regex_matcher));
+	memset(m, 0, sizeof(regex_matcher));
+	for (rn = re; NULL != rn; rn = rn->next) m->num_entries++;
+	m->entry = (regex_entry *) malloc(m->num_entries * sizeof(regex_entry));
+	first = (byteset *) malloc(m->num_entries * sizeof(byteset));
+
+	for (i = 0, rn = re; NULL != rn; i++, rn = rn->next)
+	{
+		regex_entry *e = &m->entry[i];
+		char suffix[MAX_SUFFIX];
+
+		e->rn = rn;
+		analyze_pattern(rn->pattern, first[i], suffix, &e->suffix_len);
+		e->suffix = NULL;
+		if (0 < e->suffix_len)
+		{
+			e->suffix = (char *) malloc(e->suffix_len);
+			memcpy(e->suffix, suffix, e->suffix_len);
+		}
+	}
+
+	/* The empty string is tried with all the regexs. */
+	n = m->num_entries;
+	for (b = 1; b < 256; b++)
+		for (i = 0; i < m->num_entries; i++)
+			if (byteset_has(first[i], b)) n++;
+	m->num_candidates = n;
+	m->candidates = (unsigned int *) malloc(n * sizeof(unsigned int));
+
+	n = 0;
+	for (b = 0; b < 256; b++)
+	{
+		m->start[b] = n;
+		for (i = 0; i < m->num_entries; i++)
+			if ((0 == b) || byteset_has(first[i], b)) m->candidates[n++] = i;
+	}
+	m->start[256] = n;
+	free(first);
+
+#ifdef USE_PTHREADS
+	pthread_mutex_init(&m->memo_lock, NULL);
+#endif
+	return m;
+}
+
+static void matcher_delete(regex_matcher *m)
+{
+	size_t i;
+
+	if (NULL == m) return;
+	for (i = 0; i < m->num_entries; i++) free(m->entry[i].suffix);
+	for (i = 0; i < REGEX_MEMO_SIZE; i++) free(m->memo[i].word);
+#ifdef USE_PTHREADS
+	pthread_mutex_destroy(&m->memo_lock);
+#endif
+	free(m->candidates);
+	free(m->entry);
+	free(m);
+}
+
+/**
+ * Return the name of the first regex of the list that matches s,
+ * trying only those that pass the cheap checks.
+ */
+static const char * matcher_match(const regex_matcher *m, const char *s)
+{
+	unsigned char b = s[0];
+	size_t len = strlen(s);
+	size_t k;
+
+	for (k = m->start[b]; k < m->start[b+1]; k++)
+	{
+		const regex_entry *e = &m->entry[m->candidates[k]];
+		int rc;
+
+		if ((e->suffix_len > len) ||
+		    (0 != memcmp(s + len - e->suffix_len, e->suffix, e->suffix_len)))
+			continue;
+
+		rc = regexec((regex_t*) e->rn->re, s, 0, NULL, 0);
+		if (0 == rc) return e->rn->name;
+		if (rc != REG_NOMATCH)
+			prt_regerror("Regex matching error", e->rn, rc);
+	}
+	return NULL;
+}
+
+static inline void memo_lock(regex_matcher *m)
+{
+#ifdef USE_PTHREADS
+	pthread_mutex_lock(&m->memo_lock);
+#endif
+}
+
+static inline void memo_unlock(regex_matcher *m)
+{
+#ifdef USE_PTHREADS
+	pthread_mutex_unlock(&m->memo_lock);
+#endif
+}
+
+static const char * matcher_lookup(regex_matcher *m, const char *s)
+{
+	regex_memo_entry *me;
+	const char *name;
+	char *word;
+
+	me = &m->memo[(unsigned int) string_hash(s) & (REGEX_MEMO_SIZE - 1)];
+	memo_lock(m);
+	if ((NULL != me->word) && (0 == strcmp(me->word, s)))
+	{
+		name = me->name;
+		memo_unlock(m);
+		return name;
+	}
+	memo_unlock(m);
+
+	name = matcher_match(m, s);
+
+	word = strdup(s);
+	memo_lock(m);
+	free(me->word);
+	me->word = word;
+	me->name = name;
+	memo_unlock(m);
+	return name;
+}
+
 /**
  * Compiles all the given regexs. Returns 0 on success,
  * else an error code.
  */
 int compile_regexs(Regex_node *re, Dictionary dict)
 {
+	Regex_node *head = re;
 	regex_t *preg;
 	int rc;
 
+	if (NULL == re) return 0;
+
 	while (re != NULL)
 	{
 		/* If re->re non-null, assume compiled already. */
@@ -78,6 +653,9 @@ int compile_regexs(Regex_node *re, Dictionary dict)
 		}
 		re = re->next;
 	}
+
+	matcher_delete((regex_matcher *) head->matcher);
+	head->matcher = matcher_create(head);
 	return 0;
 }
 
@@ -90,12 +668,16 @@ const char *match_regex(Regex_node *re, const char *s)
 {
 	int rc;
 
+	if ((NULL != re) && (NULL != re->matcher))
+		return matcher_lookup((regex_matcher *) re->matcher, s);
+
 	while (re != NULL)
 	{
 		if (re->re == NULL)
 		{
 			/* Re not compiled; if this happens, it's likely an
 			 *  internal error, but nevermind for now.  */
+			re = re->next;
 			continue;
 		}
 		/* Try to match with no extra data (NULL), whole str (0 to strlen(s)),
@@ -126,6 +708,7 @@ void free_regexs(Regex_node *re)
 	while (re != NULL)
 	{
 		Regex_node *next = re->next;
+		matcher_delete((regex_matcher *) re->matcher);
 		regfree((regex_t *)re->re);
 		free(re->re);
 		free(re->name);
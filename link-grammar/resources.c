@@ -42,18 +42,52 @@ int getrusage(int who, struct rusage *rusage);
 #define MAX_PARSE_TIME_UNLIMITED -1
 #define MAX_MEMORY_UNLIMITED ((size_t) -1)
 
-/** returns the current usage time clock in seconds */
-static double current_usage_time(void)
+/** returns the current monotonic wall-clock time in seconds */
+static double current_wall_time(void)
 {
-#if !defined(_WIN32)
+#if defined(_WIN32)
+	/* On Windows, clock() is the elapsed time anyway. */
+	return ((double) clock())/CLOCKS_PER_SEC;
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ((double) ts.tv_nsec) / 1000000000.0);
+#else
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (tv.tv_sec + ((double) tv.tv_usec) / 1000000.0);
+#endif
+}
+
+/** returns the CPU time used by the calling thread, in seconds */
+static double current_cpu_time(void)
+{
+#if defined(_WIN32)
+	return ((double) clock())/CLOCKS_PER_SEC;
+#elif defined(RUSAGE_THREAD)
+	/* Time only the calling thread, so that parses running
+	 * concurrently in other threads don't use up its time limit. */
 	struct rusage u;
-	getrusage (RUSAGE_SELF, &u);
+	getrusage (RUSAGE_THREAD, &u);
 	return (u.ru_utime.tv_sec + ((double) u.ru_utime.tv_usec) / 1000000.0);
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (ts.tv_sec + ((double) ts.tv_nsec) / 1000000000.0);
 #else
-	return ((double) clock())/CLOCKS_PER_SEC;
+	struct rusage u;
+	getrusage (RUSAGE_SELF, &u);
+	return (u.ru_utime.tv_sec + ((double) u.ru_utime.tv_usec) / 1000000.0);
 #endif
 }
 
+/** returns the current usage time clock in seconds */
+static double current_usage_time(Timer_clock_type clock)
+{
+	if (WALL_CLOCK_TIME == clock) return current_wall_time();
+	return current_cpu_time();
+}
+
 Resources resources_create(void)
 {
 	Resources r;
@@ -61,7 +95,9 @@ Resources resources_create(void)
 
 	r = (Resources) xalloc(sizeof(struct Resources_s));
 	r->max_parse_time = MAX_PARSE_TIME_UNLIMITED;
-	now = current_usage_time();
+	r->clock = THREAD_CPU_TIME;
+	r->cancelled = NULL;
+	now = current_usage_time(r->clock);
 	r->when_created = now;
 	r->when_last_called = now;
 	r->time_when_parse_started = now;
@@ -81,7 +117,7 @@ void resources_delete(Resources r)
 
 void resources_reset(Resources r)
 {
-	r->when_last_called = r->time_when_parse_started = current_usage_time();
+	r->when_last_called = r->time_when_parse_started = current_usage_time(r->clock);
 	r->space_when_parse_started = get_space_in_use();
 	r->timer_expired = false;
 	r->memory_exhausted = false;
@@ -90,7 +126,7 @@ void resources_reset(Resources r)
 #if 0
 static void resources_reset_time(Resources r)
 {
-	r->when_last_called = r->time_when_parse_started = current_usage_time();
+	r->when_last_called = r->time_when_parse_started = current_usage_time(r->clock);
 }
 #endif
 
@@ -99,11 +135,33 @@ void resources_reset_space(Resources r)
 	r->space_when_parse_started = get_space_in_use();
 }
 
+/**
+ * Select the clock that the parse time is measured with.  The start
+ * of the parse is taken again, since the clocks count from different
+ * origins.
+ */
+void resources_set_clock(Resources r, Timer_clock_type clock)
+{
+	if (clock == r->clock) return;
+	r->clock = clock;
+	r->when_created = current_usage_time(clock);
+	r->when_last_called = r->time_when_parse_started = r->when_created;
+}
+
+/** Returns true if the sentence being parsed has been cancelled. */
+bool resources_cancelled(Resources r)
+{
+	return (NULL != r->cancelled) && flag_is_set(r->cancelled);
+}
+
 bool resources_exhausted(Resources r)
 {
 	if (r->timer_expired || r->memory_exhausted)
 		return true;
 
+	if (resources_cancelled(r))
+		return true;
+
 	if (resources_timer_expired(r))
 		r->timer_expired = true;
 
@@ -117,7 +175,7 @@ bool resources_timer_expired(Resources r)
 {
 	if (r->max_parse_time == MAX_PARSE_TIME_UNLIMITED) return false;
 	else return (r->timer_expired || 
-	     (current_usage_time() - r->time_when_parse_started > r->max_parse_time));
+	     (current_usage_time(r->clock) - r->time_when_parse_started > r->max_parse_time));
 }
 
 bool resources_memory_exhausted(Resources r)
@@ -130,7 +188,7 @@ bool resources_memory_exhausted(Resources r)
 static void resources_print_time(int verbosity, Resources r, const char * s)
 {
 	double now;
-	now = current_usage_time();
+	now = current_usage_time(r->clock);
 	if (verbosity > 1) {
 		printf("++++");
 		left_print_string(stdout, s,
@@ -144,7 +202,7 @@ static void resources_print_time(int verbosity, Resources r, const char * s)
 static void resources_print_total_time(int verbosity, Resources r)
 {
 	double now;
-	now = current_usage_time();
+	now = current_usage_time(r->clock);
 	r->cumulative_time += (now - r->time_when_parse_started) ;
 	if (verbosity > 0) {
 		printf("++++");
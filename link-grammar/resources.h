@@ -20,5 +20,7 @@ void      resources_reset_space(Resources r);
 bool      resources_timer_expired(Resources r);
 bool      resources_memory_exhausted(Resources r);
 bool      resources_exhausted(Resources r);
+bool      resources_cancelled(Resources r);
+void      resources_set_clock(Resources r, Timer_clock_type clock);
 Resources resources_create(void); 
 void      resources_delete(Resources ti);
@@ -1269,7 +1269,8 @@ void SATEncoder::generate_linkage_prohibiting()
 
 Linkage SATEncoder::get_next_linkage()
 {
-  if (l_False == _solver->solve()) return NULL;
+  if (flag_is_set(&_sent->cancelled)) return NULL;
+  if (l_True != _solver->solve()) return NULL;
   Linkage linkage = create_linkage();
 
   std::vector<int> components;
@@ -1497,11 +1498,11 @@ bool SATEncoderConjunctionFreeSentences::sat_extract_links(Linkage lkg)
 
     Connector* connector;
 
-    connector = connector_new();
+    connector = connector_new(NULL);
     connector->string = var->left_connector;
     clink.lc = connector;
 
-    connector = connector_new();
+    connector = connector_new(NULL);
     connector->string = var->right_connector;
     clink.rc = connector;
 
@@ -1529,6 +1530,8 @@ extern "C" int sat_parse(Sentence sent, Parse_Options  opts)
 {
   SATEncoder* encoder = (SATEncoder*) sent->hook;
   if (encoder) delete encoder;
+  sent->hook = NULL;
+  if (flag_is_set(&sent->cancelled)) return 0;
 
   // Prepare for parsing - extracted for "preparation.c"
   encoder = new SATEncoderConjunctionFreeSentences(sent, opts);
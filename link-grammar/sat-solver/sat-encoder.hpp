@@ -17,6 +17,9 @@ public:
   SATEncoder(Sentence sent, Parse_Options  opts)
     : _variables(new Variables(sent)), _solver(new Solver()), _sent(sent), _opts(opts)
   {
+    // Stop solving when the sentence is cancelled
+    _solver->setInterrupt(&sent->cancelled);
+
     // Preprocess word tags of the sentence
     build_word_tags();
   }
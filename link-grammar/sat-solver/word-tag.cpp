@@ -13,9 +13,10 @@ void WordTag::insert_connectors(Exp* exp, int& dfs_position,
 
     const char* name = exp->u.string;
 
-    Connector* connector = connector_new();
+    Connector* connector = connector_new(NULL);
     connector->multi = exp->multi;
     connector->string = name;
+    connector->desc = condesc_lookup(_sent->dict->condesc_table, name);
     set_connector_length_limit(connector);
 
 
@@ -120,6 +121,7 @@ void WordTag::find_matches(int w, const char* C, char dir, std::vector<PositionC
   Connector search_cntr;
   init_connector(&search_cntr);
   search_cntr.string = C;
+  search_cntr.desc = condesc_lookup(_sent->dict->condesc_table, C);
   set_connector_length_limit(&search_cntr);
 
   std::vector<PositionConnector>* connectors;
@@ -8,6 +8,7 @@
 #include "link-includes.h"
 
 extern "C" {
+#include "condesc.h"
 #include "count.h"
 #include "prune.h"
 #include "word-utils.h"
@@ -132,7 +133,7 @@ public:
       int dist = w2 - w1;
       assert(0 < dist, "match() did not receive words in the natural order.");
       if (dist > cntr1.length_limit || dist > cntr2.length_limit) return false;
-      return easy_match(cntr1.string, cntr2.string);
+      return easy_match_connectors(&cntr1, &cntr2);
   }
 
   void insert_connectors(Exp* exp, int& dfs_position,
@@ -16,6 +16,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <aspell.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+#endif
 
 #include "link-includes.h"
 #include "spellcheck.h"
@@ -29,8 +32,27 @@ static const char *spellcheck_lang_mapping[] = {
 struct linkgrammar_aspell {
 	AspellConfig *config;
 	AspellSpeller *speller;
+#ifdef USE_PTHREADS
+	/* The speller is not thread-safe, and it may be shared by all
+	 * the threads that use the same dictionary. */
+	pthread_mutex_t lock;
+#endif
 };
 
+static inline void aspell_lock(struct linkgrammar_aspell *aspell)
+{
+#ifdef USE_PTHREADS
+	pthread_mutex_lock(&aspell->lock);
+#endif
+}
+
+static inline void aspell_unlock(struct linkgrammar_aspell *aspell)
+{
+#ifdef USE_PTHREADS
+	pthread_mutex_unlock(&aspell->lock);
+#endif
+}
+
 /**
  * create a neew spell-checker for the language 'lang'
  */
@@ -70,6 +92,9 @@ void * spellcheck_create(const char * lang)
 			break;
 		}
 		aspell->speller = to_aspell_speller(spell_err);
+#ifdef USE_PTHREADS
+		pthread_mutex_init(&aspell->lock, NULL);
+#endif
 		break;
 	}
 	return aspell;
@@ -84,6 +109,9 @@ void spellcheck_destroy(void * chk)
 	if (aspell) {
 		delete_aspell_speller(aspell->speller);
 		delete_aspell_config(aspell->config);
+#ifdef USE_PTHREADS
+		pthread_mutex_destroy(&aspell->lock);
+#endif
 		free(aspell);
 		aspell = NULL;
 	}
@@ -99,7 +127,9 @@ bool spellcheck_test(void * chk, const char * word)
 	struct linkgrammar_aspell *aspell = (struct linkgrammar_aspell *)chk;
 	if (aspell && aspell->speller)  {
 		/* this can return -1 on failure */
+		aspell_lock(aspell);
 		val = aspell_speller_check(aspell->speller, word, -1);
+		aspell_unlock(aspell);
 	}
 	return (val == 1);
 }
@@ -118,6 +148,7 @@ int spellcheck_suggest(void * chk, char ***sug, const char * word)
 		unsigned int size, i;
 		char **array = NULL;
 
+		aspell_lock(aspell);
 		list = aspell_speller_suggest(aspell->speller, word, -1);
 		elem = aspell_word_list_elements(list);
 		size = aspell_word_list_size(list);
@@ -127,6 +158,7 @@ int spellcheck_suggest(void * chk, char ***sug, const char * word)
 		if (!array) {
 			prt_error("Error: Aspell. Out of memory.\n");
 			delete_aspell_string_enumeration(elem);
+			aspell_unlock(aspell);
 			return 0;
 		}
 		i = 0;
@@ -134,6 +166,7 @@ int spellcheck_suggest(void * chk, char ***sug, const char * word)
 			array[i++] = strdup(aword);
 		}
 		delete_aspell_string_enumeration(elem);
+		aspell_unlock(aspell);
 		*sug = array;
 		return size;
 	}
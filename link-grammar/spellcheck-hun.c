@@ -40,16 +40,28 @@ static const char *spellcheck_lang_mapping[] = {
 };
 
 #define FPATHLEN 256
-static char hunspell_aff_file[FPATHLEN];
-static char hunspell_dic_file[FPATHLEN];
 
 #include <hunspell.h>
 #include <string.h>
+#ifdef USE_PTHREADS
+#include <pthread.h>
+
+/* A Hunspell handle is not thread-safe, and it may be shared by all
+ * the threads that use the same dictionary. */
+static pthread_mutex_t hunspell_lock = PTHREAD_MUTEX_INITIALIZER;
+#define HUNSPELL_LOCK pthread_mutex_lock(&hunspell_lock)
+#define HUNSPELL_UNLOCK pthread_mutex_unlock(&hunspell_lock)
+#else
+#define HUNSPELL_LOCK
+#define HUNSPELL_UNLOCK
+#endif /* USE_PTHREADS */
 
 void * spellcheck_create(const char * lang)
 {
 	size_t i = 0, j = 0;
 	Hunhandle *h = NULL;
+	char hunspell_aff_file[FPATHLEN];
+	char hunspell_dic_file[FPATHLEN];
 
 	memset(hunspell_aff_file, 0, FPATHLEN);
 	memset(hunspell_dic_file, 0, FPATHLEN);
@@ -102,24 +114,34 @@ void spellcheck_destroy(void * chk)
  */
 bool spellcheck_test(void * chk, const char * word)
 {
+	bool ok;
+
 	if (NULL == chk)
 	{
 		prt_error("Error: no spell-check handle specified!\n");
 		return 0;
 	}
 
-	return (bool) Hunspell_spell((Hunhandle *)chk, word);
+	HUNSPELL_LOCK;
+	ok = (bool) Hunspell_spell((Hunhandle *)chk, word);
+	HUNSPELL_UNLOCK;
+	return ok;
 }
 
 int spellcheck_suggest(void * chk, char ***sug, const char * word)
 {
+	int n;
+
 	if (NULL == chk)
 	{
 		prt_error("Error: no spell-check handle specified!\n");
 		return 0;
 	}
 
-	return Hunspell_suggest((Hunhandle *)chk, sug, word);
+	HUNSPELL_LOCK;
+	n = Hunspell_suggest((Hunhandle *)chk, sug, word);
+	HUNSPELL_UNLOCK;
+	return n;
 }
 
 void spellcheck_free_suggest(char **sug, int size)
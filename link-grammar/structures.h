@@ -107,6 +107,8 @@ struct Connector_struct
 	bool multi;  /* TRUE if this is a multi-connector */
 	Connector * next;
 	const char * string;  /* The connector name, e.g. AB+ */
+	const condesc_t * desc; /* Its descriptor in the dictionary's
+	                           connector table, or NULL if none */
 
 	/* Hash table next pointer, used only during pruning. */
 	Connector * tableNext;
@@ -115,6 +117,7 @@ struct Connector_struct
 static inline void connector_set_string(Connector *c, const char *s)
 {
 	c->string = s;
+	c->desc = NULL;
 	c->hash = -1;
 }
 static inline const char * connector_get_string(Connector *c)
@@ -129,6 +132,8 @@ struct Disjunct_struct
 	Connector *left, *right;
 	double cost;
 	bool marked;                     /* unmarked disjuncts get deleted */
+	bool pooled;                     /* in the pools or the packed block of
+	                                    the sentence, freed with them */
 };
 
 typedef struct Match_node_struct Match_node;
@@ -136,6 +141,7 @@ struct Match_node_struct
 {
 	Match_node * next;
 	Disjunct * d;
+	unsigned int id;  /* Number of the disjunct on its word */
 };
 
 typedef struct X_node_struct X_node;
@@ -144,6 +150,8 @@ struct X_node_struct
 	const char * string;            /* the word itself */
 	Exp * exp;
 	X_node *next;
+	const Exp * dict_exp;           /* unpruned expression, from the dict */
+	bool empty_word;                /* exp was wrapped by add_empty_word() */
 };
 
 /**
@@ -178,6 +186,8 @@ struct Regex_node_s
 	                  * rest of the LG system; regex-morph.c
 	                  * takes care of all matching.
 	                  */
+	void *matcher;   /* On the first node of a list: the matcher of
+	                  * the whole list, built by compile_regexs(). */
 	Regex_node *next;
 };
 
@@ -221,6 +231,7 @@ struct Parse_set_struct
 	s64 count;  /* the number of ways */
 	Parse_choice * first;
 	Parse_choice * current;  /* used to enumerate linkages */
+	Parse_kbest * kbest;     /* used to enumerate them by cost */
 };
 
 struct X_table_connector_struct
@@ -17,6 +17,7 @@
 #endif
 #include <limits.h>
 
+#include "affix-trie.h"
 #ifdef USE_ANYSPLIT
 #include "anysplit.h"
 #endif
@@ -532,6 +533,8 @@ static bool suffix_split(Sentence sent, const char *w, const char *wend)
 	bool word_can_split = false;
 	Dictionary dict = sent->dict;
 	char *newword = alloca(wend-w+1);
+	int *pmatch, *smatch;
+	size_t np, ns, k;
 
 	/* Set up affix tables. */
 	if (NULL == dict->affix_table) return false;
@@ -540,43 +543,53 @@ static bool suffix_split(Sentence sent, const char *w, const char *wend)
 	prefix = prefix_list->string;
 	suffix_list = AFCLASS(dict->affix_table, AFDICT_SUF);
 	s_strippable = suffix_list->length;
-	suffix = suffix_list->string;
 
 	if (INT_MAX == s_strippable) return false;
 
+	/* Only the affixes that occur at the ends of the word are tried.
+	 * They come out of the tries in the order of the affix file, so
+	 * the alternatives are issued in the same order as when all of
+	 * them were compared with the word. */
+	pmatch = alloca((p_strippable + 1) * sizeof(*pmatch));
+	smatch = alloca((s_strippable + 1) * sizeof(*smatch));
+	np = afdict_trie_match(prefix_list->trie, w, wend-w, pmatch);
+	ns = afdict_trie_match(suffix_list->trie, w, wend-w, smatch);
+	smatch[ns] = s_strippable;
+
 	/* Go through once for each suffix; then go through one
 	 * final time for the no-suffix case (i.e. to look for
 	 * prefixes only, without suffixes). */
-	for (i = 0; i <= s_strippable; i++, suffix++)
+	for (k = 0; k <= ns; k++)
 	{
 		bool did_split = false;
 		size_t suflen = 0;
+
+		i = smatch[k];
 		if (i < s_strippable)
 		{
+			size_t sz;
+
+			suffix = &suffix_list->string[i];
 			suflen = strlen(*suffix);
 			 /* The remaining w is too short for a possible match.
 			  * In addition, don't allow empty stems. */
 			if ((wend-suflen) < (w+1)) continue;
 
 			/* A lang like Russian allows empty suffixes, which have a real
-			 * morphological linkage. In the following check, the empty suffix
-			 * always matches. */
-			if (0 == strncmp(wend-suflen, *suffix, suflen))
+			 * morphological linkage. The trie matches them at any word. */
+			sz = MIN((wend-w)-suflen, MAX_WORD);
+			strncpy(newword, w, sz);
+			newword[sz] = '\0';
+
+			/* Check if the remainder is in the dictionary.
+			 * In case we handle a contracted word, the first word
+			 * may match a regex. Hence find_word_in_dict() is used and
+			 * not boolean_dictionary_lookup(). */
+			if (find_word_in_dict(dict, newword))
 			{
-				size_t sz = MIN((wend-w)-suflen, MAX_WORD);
-				strncpy(newword, w, sz);
-				newword[sz] = '\0';
-
-				/* Check if the remainder is in the dictionary.
-				 * In case we handle a contracted word, the first word
-				 * may match a regex. Hence find_word_in_dict() is used and
-				 * not boolean_dictionary_lookup(). */
-				if (find_word_in_dict(dict, newword))
-				{
-					did_split =
-						add_alternative_with_subscr(sent, NULL, newword, *suffix);
-					word_can_split |= did_split;
-				}
+				did_split =
+					add_alternative_with_subscr(sent, NULL, newword, *suffix);
+				word_can_split |= did_split;
 			}
 		}
 		else
@@ -592,23 +605,24 @@ static bool suffix_split(Sentence sent, const char *w, const char *wend)
 		 */
 		if (did_split || 0==suflen)
 		{
-			for (j = 0; j < p_strippable; j++)
+			size_t m;
+			for (m = 0; m < np; m++)
 			{
-				size_t prelen = strlen(prefix[j]);
+				size_t prelen, sz;
+
+				j = pmatch[m];
+				prelen = strlen(prefix[j]);
 				/* The remaining w is too short for a possible match. */
 				if ((wend-w) - suflen < prelen) continue;
-				if (strncmp(w, prefix[j], prelen) == 0)
-				{
-					size_t sz = MIN((wend-w) - suflen - prelen, MAX_WORD);
 
-					strncpy(newword, w+prelen, sz);
-					newword[sz] = '\0';
-					/* ??? Do we need a regex match? */
-					if (boolean_dictionary_lookup(dict, newword))
-					{
-						word_can_split |=
+				sz = MIN((wend-w) - suflen - prelen, MAX_WORD);
+				strncpy(newword, w+prelen, sz);
+				newword[sz] = '\0';
+				/* ??? Do we need a regex match? */
+				if (boolean_dictionary_lookup(dict, newword))
+				{
+					word_can_split |=
 					 	add_alternative_with_subscr(sent, prefix[j], newword, *suffix);
-					}
 				}
 			}
 		}
@@ -673,6 +687,7 @@ static bool mprefix_split(Sentence sent, const char *word)
 	int split_prefix_i = 0;      /* split prefix index */
 	const char *split_prefix[HEB_PRENUM_MAX]; /* the whole prefix */
 	bool *pseen;                 /* prefix "subword" seen (not allowed again) */
+	int *pmatch;                 /* the prefixes that w starts with */
 	Dictionary dict = sent->dict;
 	int wordlen;
 	int wlen;
@@ -687,6 +702,7 @@ static bool mprefix_split(Sentence sent, const char *word)
 	 * The code here depends on that. */
 	mprefix = mprefix_list->string;
 
+	pmatch = alloca(mp_strippable * sizeof(*pmatch));
 	pseen = alloca(mp_strippable * sizeof(*pseen));
 	/* Assuming zeroed-out bytes are interpreted as false. */
 	memset(pseen, 0, mp_strippable * sizeof(*pseen));
@@ -696,8 +712,14 @@ static bool mprefix_split(Sentence sent, const char *word)
 	wordlen = strlen(word);  /* guaranteed < MAX_WORD by separate_word() */
 	do
 	{
-		for (i=0; i<mp_strippable; i++)
+		/* Only the prefixes that w starts with, in the list order. */
+		size_t nmatch = afdict_trie_match(mprefix_list->trie, w, strlen(w), pmatch);
+		size_t m;
+
+		for (m = 0; m < nmatch; m++)
 		{
+			i = pmatch[m];
+
 			/* subwords in a prefix are unique */
 			if (pseen[i])
 				continue;
@@ -712,44 +734,42 @@ static bool mprefix_split(Sentence sent, const char *word)
 			plen = strlen(mprefix[i]);
 			wlen = strlen(w);
 			sz = wlen - plen;
-			if (strncmp(w, mprefix[i], plen) == 0)
+			newword = w + plen;
+			/* check for non-vav before vav */
+			if (!HEB_CHAREQ(mprefix[i], "ו") && (HEB_CHAREQ(newword, "ו")))
 			{
-				newword = w + plen;
-				/* check for non-vav before vav */
-				if (!HEB_CHAREQ(mprefix[i], "ו") && (HEB_CHAREQ(newword, "ו")))
-				{
-					/* non-vav before a single-vav - not in a prefix */
-					if (!HEB_CHAREQ(newword+HEB_UTF8_BYTES, "ו"))
-						break;
-
-					/* non-vav before 2-vav */
-					if (newword[HEB_UTF8_BYTES+1])
-						newword += HEB_UTF8_BYTES; /* strip one 'ו' */
-					/* TBD: check word also without stripping. */
-				}
-				pseen[i] = true;
-				split_prefix[split_prefix_i++] = mprefix[i];
-				if (0 == sz) /* empty word */
-				{
-					word_is_in_dict = true;
-					/* add the prefix alone */
-					lgdebug(+3, "Whole-word prefix: %s\n", word);
-					add_alternative(sent, split_prefix_i,split_prefix, 0,NULL, 0,NULL);
-					/* if the prefix is a valid word,
-					 * it has been added in separate_word() as a word */
+				/* non-vav before a single-vav - not in a prefix */
+				if (!HEB_CHAREQ(newword+HEB_UTF8_BYTES, "ו"))
 					break;
-				}
-				if (find_word_in_dict(dict, newword))
-				{
-					word_is_in_dict = true;
-					lgdebug(+3, "Splitting off a prefix: %.*s-%s\n",
-					        wordlen-sz, word, newword);
-					add_alternative(sent, split_prefix_i,split_prefix, 1,&newword, 0,NULL);
-				}
-				w = newword;
+
+				/* non-vav before 2-vav */
+				if (newword[HEB_UTF8_BYTES+1])
+					newword += HEB_UTF8_BYTES; /* strip one 'ו' */
+				/* TBD: check word also without stripping. */
+			}
+			pseen[i] = true;
+			split_prefix[split_prefix_i++] = mprefix[i];
+			if (0 == sz) /* empty word */
+			{
+				word_is_in_dict = true;
+				/* add the prefix alone */
+				lgdebug(+3, "Whole-word prefix: %s\n", word);
+				add_alternative(sent, split_prefix_i,split_prefix, 0,NULL, 0,NULL);
+				/* if the prefix is a valid word,
+				 * it has been added in separate_word() as a word */
 				break;
 			}
+			if (find_word_in_dict(dict, newword))
+			{
+				word_is_in_dict = true;
+				lgdebug(+3, "Splitting off a prefix: %.*s-%s\n",
+				        wordlen-sz, word, newword);
+				add_alternative(sent, split_prefix_i,split_prefix, 1,&newword, 0,NULL);
+			}
+			w = newword;
+			break;
 		}
+		if (m == nmatch) i = mp_strippable; /* no prefix to split off */
 	/* "wlen + sz < wordlen" is true if a vav has been stripped */
 	} while ((sz > 0) && (i < mp_strippable) && (newword != w + plen) &&
 	 (split_prefix_i < HEB_PRENUM_MAX));
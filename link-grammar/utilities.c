@@ -28,6 +28,7 @@
 #include <pthread.h>
 #endif
 
+#include "externs.h"
 #include "string-set.h"
 #include "structures.h"
 #include "utilities.h"
@@ -52,11 +53,11 @@
 #define DEFAULTPATH DICTIONARY_DIR
 
 /* This file contains certain general utilities. */
-int    verbosity;
+TLS int    verbosity;
 /* debug and test should not be NULL since they can be used before they
  * are assigned a value by parse_options_get_...() */
-char * debug = (char *)"";
-char * test = (char *)"";
+TLS char * debug = (char *)"";
+TLS char * test = (char *)"";
 
 /* ============================================================= */
 /* String utilities */
@@ -948,6 +949,39 @@ FILE *dictopen(const char *filename, const char *how)
 	return fh;
 }
 
+static void * dict_file_name(const char * fullname, void * user_data)
+{
+	FILE * fh = fopen(fullname, "r");
+	if (NULL == fh) return NULL;
+	fclose(fh);
+	return (void *) strdup(fullname);
+}
+
+/**
+ * Return the full path name of the file that dictopen() would open
+ * for reading, or NULL if there is no such file. The returned string
+ * should be freed by the caller.
+ */
+char * dict_file_path(const char *filename)
+{
+	char * path;
+
+	if (path_found)
+	{
+		size_t sz = strlen (path_found) + strlen(filename) + 1;
+		char * fullname = (char *) malloc (sz);
+		strcpy(fullname, path_found);
+		strcat(fullname, filename);
+		path = (char *) object_open(fullname, dict_file_name, NULL);
+		free(fullname);
+	}
+	else
+	{
+		path = (char *) object_open(filename, dict_file_name, NULL);
+	}
+	return path;
+}
+
 /* ======================================================== */
 
 /**
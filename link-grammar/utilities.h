@@ -204,6 +204,23 @@ int strncasecmp(const char *s1, const char *s2, size_t n);
 #define GNUC_UNUSED
 #endif
 
+/* A flag that one thread may set while other threads are testing it.
+ * The accesses are atomic, but don't order any other memory access. */
+#if defined(__clang__) || (__GNUC__ > 4) || \
+    ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7))
+static inline bool flag_is_set(const volatile int *flag)
+{
+	return 0 != __atomic_load_n(flag, __ATOMIC_RELAXED);
+}
+static inline void flag_set(volatile int *flag)
+{
+	__atomic_store_n(flag, 1, __ATOMIC_RELAXED);
+}
+#else
+static inline bool flag_is_set(const volatile int *flag) { return 0 != *flag; }
+static inline void flag_set(volatile int *flag) { *flag = 1; }
+#endif
+
 /**
  * Return the length, in codepoints/glyphs, of the utf8-encoded 
  * string.  This is needed when printing strings in a formatted way.
@@ -388,6 +405,7 @@ char * get_default_locale(void);
 char * join_path(const char * prefix, const char * suffix);
 
 FILE * dictopen(const char *filename, const char *how);
+char * dict_file_path(const char *filename);
 void * object_open(const char *filename,
                    void * (*opencb)(const char *, void *),
                    void * user_data);
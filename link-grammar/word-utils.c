@@ -21,6 +21,7 @@
 #include "count.h"
 #include "dict-api.h"
 #include "disjunct-utils.h"
+#include "memory-pool.h"
 #include "word-utils.h"
 
 /* ======================================================== */
@@ -204,11 +205,21 @@ void free_connectors(Connector *e)
 	}
 }
 
-Connector * connector_new(void)
+/**
+ * Return a new connector, from the pool mp, or from the heap if mp is
+ * NULL.  Only the latter may be freed with free_connectors().
+ */
+Connector * connector_new(Pool_desc *mp)
 {
-	Connector *c = (Connector *) xalloc(sizeof(Connector));
+	Connector *c;
+
+	if (NULL == mp)
+		c = (Connector *) xalloc(sizeof(Connector));
+	else
+		c = (Connector *) pool_alloc(mp);
 	c->length_limit = UNLIMITED_LEN;
 	c->string = "";
+	c->desc = NULL;
 	c->hash = -1;
 	c->multi = false;
 	c->next = NULL;
@@ -218,6 +229,7 @@ Connector * connector_new(void)
 
 Connector * init_connector(Connector *c)
 {
+	c->desc = NULL;
 	c->hash = -1;
 	c->length_limit = UNLIMITED_LEN;
 	return c;
@@ -252,7 +264,7 @@ static void build_connector_set_from_expression(Connector_set * conset, Exp * e)
 	unsigned int h;
 	if (e->type == CONNECTOR_type)
 	{
-		c = connector_new();
+		c = connector_new(NULL);
 		c->string = e->u.string;
 		c->word = e->dir;       /* just use the word field to give the dir */
 		h = connector_set_hash(conset, c->string, c->word);
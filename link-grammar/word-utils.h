@@ -33,7 +33,7 @@ void free_X_nodes(X_node *);
 
 
 /* Connector utilities ... */
-Connector * connector_new(void);
+Connector * connector_new(Pool_desc *);
 Connector * init_connector(Connector *c);
 void free_connectors(Connector *);
 
@@ -27,8 +27,10 @@ static struct
 	char * debug;
 	char * test;
 	int timeout;
+	int wallclock;
 	int memory;
 	int linkage_limit;
+	int best_first;
 	int islands_ok;
 	int spell_guess;
 	int short_length;
@@ -42,6 +44,7 @@ static struct
 	Cost_Model_type cost_model;
 	double max_cost;
 	int screen_width;
+	int count_threads;
 	int display_on;
 	ConstituentDisplayStyle display_constituents;
 	int display_postscript;
@@ -72,6 +75,7 @@ typedef struct
 static Switch default_switches[] =
 {
    {"bad",        Bool, "Display of bad linkages",         &local.display_bad},
+   {"best-first", Bool, "Beyond the limit, take the cheapest linkages", &local.best_first},
    {"batch",      Bool, "Batch mode",                      &local.batch_mode},
    {"cluster",    Bool, "Use clusters to loosen parsing",  &local.use_cluster_disjuncts},
    {"constituents", Int,  "Generate constituent output",   &local.display_constituents},
@@ -93,6 +97,7 @@ static Switch default_switches[] =
 #if defined HAVE_HUNSPELL || defined HAVE_ASPELL
    {"spell",      Bool, "Use spell-guesser for unknown words",  &local.spell_guess},
 #endif /* HAVE_HUNSPELL */
+   {"threads",    Int,  "Threads for counting long sentences", &local.count_threads},
    {"timeout",    Int,  "Abort parsing after this many seconds", &local.timeout},
 #ifdef USE_SAT_SOLVER
    {"use-sat",    Bool, "Use Boolean SAT-based parser",    &local.use_sat_solver},
@@ -103,6 +108,7 @@ static Switch default_switches[] =
 #ifdef USE_VITERBI
    {"viterbi",    Bool, "Use Viterbit-based parser",       &local.use_viterbi},
 #endif
+   {"wallclock",  Bool, "Time out by elapsed, not CPU, time", &local.wallclock},
    {"walls",      Bool, "Display wall words",              &local.display_walls},
    {"width",      Int,  "The width of the display",        &local.screen_width},
    {NULL,         Bool,  NULL,                             NULL}
@@ -420,8 +426,11 @@ static void put_opts_in_local_vars(Command_Options* copts)
 	local.debug = parse_options_get_debug(opts);
 	local.test = parse_options_get_test(opts);
 	local.timeout = parse_options_get_max_parse_time(opts);;
+	local.wallclock =
+		(WALL_CLOCK_TIME == parse_options_get_timer_clock(opts));
 	local.memory = parse_options_get_max_memory(opts);;
 	local.linkage_limit = parse_options_get_linkage_limit(opts);
+	local.best_first = parse_options_get_best_first(opts);
 	local.islands_ok = parse_options_get_islands_ok(opts);
 	local.spell_guess = parse_options_get_spell_guess(opts);
 	local.short_length = parse_options_get_short_length(opts);
@@ -430,6 +439,7 @@ static void put_opts_in_local_vars(Command_Options* copts)
 	local.use_cluster_disjuncts = parse_options_get_use_cluster_disjuncts(opts);
 	local.use_sat_solver = parse_options_get_use_sat_parser(opts);
 	local.use_viterbi = parse_options_get_use_viterbi(opts);
+	local.count_threads = parse_options_get_count_threads(opts);
 
 	local.screen_width = copts->screen_width;
 	local.echo_on = copts->echo_on;
@@ -456,8 +466,11 @@ static void put_local_vars_in_opts(Command_Options* copts)
 	parse_options_set_debug(opts, local.debug);
 	parse_options_set_test(opts, local.test);
 	parse_options_set_max_parse_time(opts, local.timeout);
+	parse_options_set_timer_clock(opts,
+		local.wallclock ? WALL_CLOCK_TIME : THREAD_CPU_TIME);
 	parse_options_set_max_memory(opts, local.memory);
 	parse_options_set_linkage_limit(opts, local.linkage_limit);
+	parse_options_set_best_first(opts, local.best_first);
 	parse_options_set_islands_ok(opts, local.islands_ok);
 	parse_options_set_spell_guess(opts, local.spell_guess);
 	parse_options_set_short_length(opts, local.short_length);
@@ -468,6 +481,7 @@ static void put_local_vars_in_opts(Command_Options* copts)
 	parse_options_set_use_sat_parser(opts, local.use_sat_solver);
 #endif
 	parse_options_set_use_viterbi(opts, local.use_viterbi);
+	parse_options_set_count_threads(opts, local.count_threads);
 	parse_options_set_display_morphology(opts, local.display_morphology);
 
 	copts->screen_width = local.screen_width;
@@ -501,6 +515,9 @@ Command_Options* command_options_create(void)
 	Command_Options* co = malloc(sizeof (Command_Options));
 	co->popts = parse_options_create();
 	co->panic_opts = parse_options_create();
+	co->workspace = parse_workspace_create();
+	parse_options_set_workspace(co->popts, co->workspace);
+	parse_options_set_workspace(co->panic_opts, co->workspace);
 
 	/* "Unlimited" screen wdith when writing to a file, auto-updated
 	 * later, wen writing to a tty. */
@@ -525,5 +542,6 @@ void command_options_delete(Command_Options* co)
 {
 	parse_options_delete(co->panic_opts);
 	parse_options_delete(co->popts);
+	parse_workspace_delete(co->workspace);
 	free(co);
 }
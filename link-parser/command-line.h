@@ -19,6 +19,7 @@ LINK_BEGIN_DECLS  /* Needed to keep MSVC6 happy */
 typedef struct {
 	Parse_Options popts;
 	Parse_Options panic_opts;
+	Parse_Workspace workspace; /* Parser buffers, kept between sentences */
 
 	size_t screen_width;    /* width of screen for displaying linkages */
 	bool batch_mode;        /* if true, process sentences non-interactively */
@@ -0,0 +1,61 @@
+/***************************************************************************/
+/* All rights reserved                                                     */
+/*                                                                         */
+/* Use of the link grammar parsing system is subject to the terms of the   */
+/* license set forth in the LICENSE file included with this software.      */
+/* This license allows free redistribution and use in source and binary    */
+/* forms, with or without modification, subject to certain conditions.     */
+/*                                                                         */
+/***************************************************************************/
+
+ /****************************************************************************
+ *
+ *   Save the dictionary of a language in the binary format, so that
+ *   dictionary_create_lang() can map it instead of reading the text.
+ *
+ *   Usage: link-dict-compile <language> [output-file]
+ *
+ *   By default the binary file is written next to the dictionary file
+ *   (e.g. data/en/4.0.dict.bin).  It has to be made again after the
+ *   dictionary or its word files are changed; until then, the text
+ *   files are read as usual.
+ *
+ ****************************************************************************/
+
+#include <locale.h>
+#include <stdio.h>
+
+#ifdef _MSC_VER
+#define LINK_GRAMMAR_DLL_EXPORT 0
+#endif
+
+#include "../link-grammar/link-includes.h"
+
+int main(int argc, char * argv[])
+{
+	Dictionary dict;
+	const char * output = NULL;
+	bool ok;
+
+	if ((argc < 2) || (argc > 3))
+	{
+		fprintf(stderr, "Usage: %s <language> [output-file]\n", argv[0]);
+		return 1;
+	}
+	if (3 == argc) output = argv[2];
+
+	setlocale(LC_ALL, "");
+
+	dict = dictionary_create_lang(argv[1]);
+	if (NULL == dict)
+	{
+		fprintf(stderr, "Fatal error: Unable to open the dictionary %s\n",
+		        argv[1]);
+		return 1;
+	}
+
+	ok = dictionary_write_binary(dict, output);
+	dictionary_delete(dict);
+
+	return ok ? 0 : 1;
+}
@@ -811,6 +811,13 @@ int main(int argc, char * argv[])
 		else
 #endif
 		{
+			/* If null links are to be tried when there is no complete
+			 * linkage, and nothing else is to be tried before, let the
+			 * same parse go on with them; it keeps what it can. */
+			bool go_on_with_nulls = copts->allow_null &&
+				!copts->batch_mode && !copts->display_bad &&
+				!parse_options_get_use_cluster_disjuncts(opts);
+
 			sent = sentence_create(input_string, dict);
 
 			/* First parse with cost 0 or 1 and no null links */
@@ -818,6 +825,16 @@ int main(int argc, char * argv[])
 			parse_options_set_min_null_count(opts, 0);
 			parse_options_set_max_null_count(opts, 0);
 			parse_options_reset_resources(opts);
+			if (go_on_with_nulls)
+			{
+				if (0 != sentence_split(sent, opts))
+				{
+					sentence_delete(sent);
+					sent = NULL;
+					continue;
+				}
+				parse_options_set_max_null_count(opts, sentence_length(sent));
+			}
 
 			num_linkages = sentence_parse(sent, opts);
 
@@ -877,7 +894,13 @@ int main(int argc, char * argv[])
 			}
 
 			/* Now parse with null links */
-			if (num_linkages == 0 && !copts->batch_mode)
+			if (go_on_with_nulls)
+			{
+				if ((verbosity > 0) &&
+				    ((num_linkages == 0) || (0 < sentence_null_count(sent))))
+					fprintf(stdout, "No complete linkages found.\n");
+			}
+			else if (num_linkages == 0 && !copts->batch_mode)
 			{
 				if (verbosity > 0) fprintf(stdout, "No complete linkages found.\n");
 
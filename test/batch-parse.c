@@ -0,0 +1,147 @@
+/*
+ * batch-parse.c
+ *
+ * Parse the sentences of a batch file with sentence_parse_batch(), and
+ * then one by one with sentence_parse(), and check that the results
+ * (the linkage counts and the diagram of the first linkage) agree.
+ * Report the time taken both ways.
+ *
+ * Usage: batch-parse <language> <batch-file> [num-threads [max-batch-time]]
+ */
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "link-includes.h"
+
+static double wall_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1.0e-9 * ts.tv_nsec;
+}
+
+static char * first_diagram(Sentence sent, Parse_Options opts)
+{
+	char * d, * copy;
+	Linkage linkage;
+
+	if (0 == sentence_num_linkages_post_processed(sent)) return NULL;
+	linkage = linkage_create(0, sent, opts);
+	if (NULL == linkage) return NULL;
+	d = linkage_print_diagram(linkage, true, 200);
+	copy = strdup(d);
+	linkage_free_diagram(d);
+	linkage_delete(linkage);
+	return copy;
+}
+
+static bool same_parse(Sentence a, Sentence b, Parse_Options opts)
+{
+	char * da, * db;
+	bool same;
+
+	if (sentence_null_count(a) != sentence_null_count(b)) return false;
+	if (sentence_num_linkages_found(a) != sentence_num_linkages_found(b))
+		return false;
+	if (sentence_num_valid_linkages(a) != sentence_num_valid_linkages(b))
+		return false;
+
+	da = first_diagram(a, opts);
+	db = first_diagram(b, opts);
+	if ((NULL == da) || (NULL == db)) same = (da == db);
+	else same = (0 == strcmp(da, db));
+	free(da);
+	free(db);
+	return same;
+}
+
+int main(int argc, char *argv[])
+{
+	Dictionary dict;
+	Parse_Options opts;
+	FILE *fh;
+	char line[4096];
+	char ** sentences = NULL;
+	Sentence * result;
+	int nsent = 0, maxsent = 0, nparsed, i;
+	int nthreads = 0, max_batch_time = 0, mismatches = 0;
+	double start, tbatch, tserial;
+
+	if ((argc < 3) || (argc > 5))
+	{
+		fprintf(stderr, "Usage: %s <language> <batch-file> "
+		        "[num-threads [max-batch-time]]\n", argv[0]);
+		return 1;
+	}
+	if (argc > 3) nthreads = atoi(argv[3]);
+	if (argc > 4) max_batch_time = atoi(argv[4]);
+
+	setlocale(LC_ALL, "");
+	dict = dictionary_create_lang(argv[1]);
+	if (NULL == dict) return 1;
+	fh = fopen(argv[2], "r");
+	if (NULL == fh)
+	{
+		perror(argv[2]);
+		return 1;
+	}
+	while (fgets(line, sizeof(line), fh))
+	{
+		char *p = line;
+
+		line[strcspn(line, "\r\n")] = '\0';
+		/* Skip comments and special commands of the batch file */
+		if (('\0' == *p) || ('%' == *p) || ('!' == *p)) continue;
+		if ('*' == *p) p++;
+		if (nsent == maxsent)
+		{
+			maxsent = (0 == maxsent) ? 256 : 2 * maxsent;
+			sentences = (char **) realloc(sentences, maxsent * sizeof(char *));
+		}
+		sentences[nsent++] = strdup(p);
+	}
+	fclose(fh);
+
+	opts = parse_options_create();
+	parse_options_set_verbosity(opts, 0);
+	result = (Sentence *) malloc(nsent * sizeof(Sentence));
+
+	start = wall_time();
+	nparsed = sentence_parse_batch(dict, (const char * const *) sentences,
+	                               nsent, opts, nthreads, max_batch_time,
+	                               result);
+	tbatch = wall_time() - start;
+
+	start = wall_time();
+	for (i = 0; i < nsent; i++)
+	{
+		Sentence sent = sentence_create(sentences[i], dict);
+		sentence_parse(sent, opts);
+		if ((NULL != result[i]) && !same_parse(result[i], sent, opts))
+		{
+			if (mismatches++ < 5)
+				fprintf(stderr, "Mismatch: %s\n", sentences[i]);
+		}
+		sentence_delete(sent);
+	}
+	tserial = wall_time() - start;
+
+	printf("%d sentences, %d parsed in a batch in %.3f s, "
+	       "one by one in %.3f s, %d mismatches\n",
+	       nsent, nparsed, tbatch, tserial, mismatches);
+
+	for (i = 0; i < nsent; i++)
+	{
+		if (result[i]) sentence_delete(result[i]);
+		free(sentences[i]);
+	}
+	free(result);
+	free(sentences);
+	parse_options_delete(opts);
+	dictionary_delete(dict);
+	return (0 != mismatches);
+}
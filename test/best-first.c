@@ -0,0 +1,169 @@
+/*
+ * best-first.c
+ *
+ * For every sentence of a batch file with more linkages than the limit,
+ * extract the k cheapest linkages with the best-first mode, and check
+ * their costs against those of the k cheapest of all the linkages,
+ * when there are few enough of them to extract them all.  Report the
+ * time taken by both, and by the default random sample of 1000.
+ *
+ * Usage: best-first <language> <batch-file> [k]
+ */
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "link-includes.h"
+
+#define MAX_ALL 50000
+
+typedef struct
+{
+	int unused;
+	double disjunct;
+	int link;
+} cost_t;
+
+static double cpu_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec + 1.0e-9 * ts.tv_nsec;
+}
+
+static int cost_cmp(const void *a, const void *b)
+{
+	const cost_t *x = a, *y = b;
+	if (x->unused != y->unused) return x->unused - y->unused;
+	if (x->disjunct < y->disjunct - 1e-6) return -1;
+	if (x->disjunct > y->disjunct + 1e-6) return 1;
+	return x->link - y->link;
+}
+
+/* Parse with the given options, and return the sorted costs of all the
+ * linkages that were processed. */
+static cost_t * parse_costs(Dictionary dict, const char *text,
+                            Parse_Options opts, int *n, int *found,
+                            double *time)
+{
+	Sentence sent = sentence_create(text, dict);
+	cost_t *c = NULL;
+	double start = cpu_time();
+	int i;
+
+	*n = 0;
+	*found = 0;
+	if ((0 == sentence_split(sent, opts)) && (0 <= sentence_parse(sent, opts)))
+	{
+		*found = sentence_num_linkages_found(sent);
+		*n = sentence_num_linkages_post_processed(sent);
+		c = malloc((*n + 1) * sizeof(cost_t));
+		for (i = 0; i < *n; i++)
+		{
+			Linkage lkg = linkage_create(i, sent, opts);
+			c[i].unused = linkage_unused_word_cost(lkg);
+			c[i].disjunct = linkage_disjunct_cost(lkg);
+			c[i].link = linkage_link_cost(lkg);
+			linkage_delete(lkg);
+		}
+		qsort(c, *n, sizeof(cost_t), cost_cmp);
+	}
+	*time = cpu_time() - start;
+	sentence_delete(sent);
+	return c;
+}
+
+int main(int argc, char *argv[])
+{
+	Dictionary dict;
+	Parse_Options opts;
+	FILE *fh;
+	char line[4096];
+	int k = 5, nchecked = 0, nbad = 0, nlong = 0;
+	double t_best = 0.0, t_rand = 0.0;
+
+	if ((argc < 3) || (argc > 4))
+	{
+		fprintf(stderr, "Usage: %s <language> <batch-file> [k]\n", argv[0]);
+		return 1;
+	}
+	if (4 == argc) k = atoi(argv[3]);
+
+	setlocale(LC_ALL, "");
+	dict = dictionary_create_lang(argv[1]);
+	if (NULL == dict) return 1;
+	fh = fopen(argv[2], "r");
+	if (NULL == fh)
+	{
+		perror(argv[2]);
+		return 1;
+	}
+
+	opts = parse_options_create();
+	parse_options_set_verbosity(opts, 0);
+	parse_options_set_min_null_count(opts, 0);
+	parse_options_set_max_null_count(opts, 0);
+
+	while (fgets(line, sizeof(line), fh))
+	{
+		char *p = line;
+		cost_t *best, *all;
+		int nbest, nall, found, i;
+		double t;
+
+		line[strcspn(line, "\r\n")] = '\0';
+		/* Skip comments and special commands of the batch file */
+		if (('\0' == *p) || ('%' == *p) || ('!' == *p)) continue;
+		if ('*' == *p) p++;
+
+		parse_options_set_best_first(opts, true);
+		parse_options_set_linkage_limit(opts, k);
+		best = parse_costs(dict, p, opts, &nbest, &found, &t);
+		if (found <= k)
+		{
+			free(best);
+			continue;
+		}
+		nlong++;
+		t_best += t;
+
+		parse_options_set_best_first(opts, false);
+		parse_options_set_linkage_limit(opts, 1000);
+		free(parse_costs(dict, p, opts, &nall, &found, &t));
+		t_rand += t;
+
+		if (found > MAX_ALL)
+		{
+			free(best);
+			continue;
+		}
+		parse_options_set_linkage_limit(opts, MAX_ALL);
+		all = parse_costs(dict, p, opts, &nall, &found, &t);
+
+		nchecked++;
+		for (i = 0; i < nbest; i++)
+		{
+			if ((i >= nall) || (0 != cost_cmp(&best[i], &all[i])))
+			{
+				printf("MISMATCH at %d: %s\n", i, p);
+				nbad++;
+				break;
+			}
+		}
+		free(best);
+		free(all);
+	}
+	fclose(fh);
+
+	printf("%d sentences with more than %d linkages: "
+	       "best-first %.3f s, random 1000 %.3f s\n", nlong, k, t_best, t_rand);
+	printf("%d checked against all their linkages, %d mismatches\n",
+	       nchecked, nbad);
+
+	parse_options_delete(opts);
+	dictionary_delete(dict);
+	return (0 == nbad) ? 0 : 1;
+}
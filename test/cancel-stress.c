@@ -0,0 +1,168 @@
+/*
+ * cancel-stress.c
+ *
+ * Start the parse of a long sentence, and cancel it from another
+ * thread after a delay, several times over.  Report how long the
+ * parse took to stop after sentence_cancel() was called.  Then parse
+ * it with a timeout of one second, by CPU time and by wall-clock time,
+ * and report how long the parse took to give up.
+ *
+ * Usage: cancel-stress <language> [delay-ms] ["sentence"]
+ *
+ * Build with -lpthread.
+ */
+
+#include <locale.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "link-includes.h"
+
+#define NUM_TRIES 5
+
+/* Parsed with null links, this takes many seconds. */
+static const char * default_text =
+	"The cat that the dog which the man who the woman saw owned chased "
+	"ran up the tree near the house by the river where the children "
+	"who were playing with the ball that the boy had thrown heard it "
+	"and laughed at the bird singing on the wire over the road today";
+
+typedef struct
+{
+	Sentence sent;
+	int delay_ms;
+	double when_cancelled;
+} canceller_t;
+
+static double wall_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1.0e-9 * ts.tv_nsec;
+}
+
+static void * canceller(void *arg)
+{
+	canceller_t *c = (canceller_t *) arg;
+	struct timespec ts;
+
+	ts.tv_sec = c->delay_ms / 1000;
+	ts.tv_nsec = (c->delay_ms % 1000) * 1000000L;
+	nanosleep(&ts, NULL);
+
+	c->when_cancelled = wall_time();
+	sentence_cancel(c->sent);
+	return NULL;
+}
+
+static Parse_Options new_opts(void)
+{
+	Parse_Options opts = parse_options_create();
+	parse_options_set_verbosity(opts, 0);
+	parse_options_set_linkage_limit(opts, 1000);
+	parse_options_set_min_null_count(opts, 0);
+	parse_options_set_max_null_count(opts, 250);
+	parse_options_set_max_parse_time(opts, 1000);
+	return opts;
+}
+
+int main(int argc, char * argv[])
+{
+	Dictionary dict;
+	Parse_Options opts;
+	const char * text = default_text;
+	int delay_ms = 200;
+	int i, rc = 0;
+
+	if ((argc < 2) || (argc > 4))
+	{
+		fprintf(stderr, "Usage: %s <language> [delay-ms] [\"sentence\"]\n",
+		        argv[0]);
+		return 1;
+	}
+	if (argc > 2) delay_ms = atoi(argv[2]);
+	if (argc > 3) text = argv[3];
+
+	setlocale(LC_ALL, "");
+	dict = dictionary_create_lang(argv[1]);
+	if (NULL == dict)
+	{
+		fprintf(stderr, "Fatal error: Unable to open the dictionary\n");
+		return 1;
+	}
+
+	opts = new_opts();
+	for (i = 0; i < NUM_TRIES; i++)
+	{
+		canceller_t c;
+		pthread_t tid;
+		double start, end;
+		int num_valid;
+		Sentence sent = sentence_create(text, dict);
+
+		c.sent = sent;
+		c.delay_ms = delay_ms;
+		c.when_cancelled = 0.0;
+		if (sentence_split(sent, opts))
+		{
+			fprintf(stderr, "Error: Cannot split the sentence\n");
+			return 1;
+		}
+
+		parse_options_reset_resources(opts);
+		start = wall_time();
+		pthread_create(&tid, NULL, canceller, &c);
+		num_valid = sentence_parse(sent, opts);
+		end = wall_time();
+		pthread_join(tid, NULL);
+
+		if (c.when_cancelled < end)
+		{
+			printf("cancel %d: parse %.3fs, stopped %.1fms after the cancel, "
+			       "%d linkages\n", i, end - start,
+			       1000.0 * (end - c.when_cancelled), num_valid);
+			if (0 != num_valid)
+			{
+				printf("FAIL: a cancelled parse returned linkages\n");
+				rc = 1;
+			}
+		}
+		else
+		{
+			printf("cancel %d: parse finished in %.3fs, before the cancel; "
+			       "try a longer sentence\n", i, end - start);
+		}
+
+		/* A cancelled sentence stays cancelled. */
+		if ((c.when_cancelled < end) && (0 != sentence_parse(sent, opts)))
+		{
+			printf("FAIL: a cancelled sentence was parsed again\n");
+			rc = 1;
+		}
+		sentence_delete(sent);
+	}
+
+	for (i = 0; i < 2; i++)
+	{
+		Timer_clock_type clock = (0 == i) ? THREAD_CPU_TIME : WALL_CLOCK_TIME;
+		Sentence sent = sentence_create(text, dict);
+		double start;
+
+		parse_options_set_max_parse_time(opts, 1);
+		parse_options_set_timer_clock(opts, clock);
+		sentence_split(sent, opts);
+		parse_options_reset_resources(opts);
+		start = wall_time();
+		sentence_parse(sent, opts);
+		printf("timeout of 1s by %s time: gave up after %.3fs\n",
+		       (0 == i) ? "CPU" : "wall-clock", wall_time() - start);
+		sentence_delete(sent);
+	}
+
+	parse_options_delete(opts);
+	dictionary_delete(dict);
+	return rc;
+}
@@ -0,0 +1,94 @@
+/*
+ * count-bench.c
+ *
+ * Parse every sentence of a batch file (e.g. data/en/4.0.fixes.batch)
+ * and report the parse time and the peak memory use.  Only the first
+ * linkage of each sentence is extracted, so that most of the time is
+ * spent in counting.
+ *
+ * Usage: count-bench <language> <batch-file>
+ */
+
+#include <locale.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "link-includes.h"
+
+static double cpu_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec + 1.0e-9 * ts.tv_nsec;
+}
+
+int main(int argc, char *argv[])
+{
+	Dictionary dict;
+	Parse_Options opts;
+	FILE *fh;
+	char line[4096];
+	int nsent = 0, nparsed = 0;
+	double start, total = 0.0;
+	struct rusage ru;
+
+	if (argc != 3)
+	{
+		fprintf(stderr, "Usage: %s <language> <batch-file>\n", argv[0]);
+		return 1;
+	}
+
+	setlocale(LC_ALL, "");
+	dict = dictionary_create_lang(argv[1]);
+	if (NULL == dict) return 1;
+	fh = fopen(argv[2], "r");
+	if (NULL == fh)
+	{
+		perror(argv[2]);
+		return 1;
+	}
+
+	opts = parse_options_create();
+	parse_options_set_verbosity(opts, 0);
+	parse_options_set_linkage_limit(opts, 1);
+
+	while (fgets(line, sizeof(line), fh))
+	{
+		char *p = line;
+		Sentence sent;
+
+		line[strcspn(line, "\r\n")] = '\0';
+		/* Skip comments and special commands of the batch file */
+		if (('\0' == *p) || ('%' == *p) || ('!' == *p)) continue;
+		if ('*' == *p) p++;
+
+		sent = sentence_create(p, dict);
+		start = cpu_time();
+		if (0 == sentence_split(sent, opts))
+		{
+			parse_options_set_min_null_count(opts, 0);
+			parse_options_set_max_null_count(opts, 0);
+			if (0 == sentence_parse(sent, opts))
+			{
+				parse_options_set_min_null_count(opts, 1);
+				parse_options_set_max_null_count(opts, sentence_length(sent));
+				sentence_parse(sent, opts);
+			}
+			nparsed++;
+		}
+		total += cpu_time() - start;
+		sentence_delete(sent);
+		nsent++;
+	}
+	fclose(fh);
+
+	getrusage(RUSAGE_SELF, &ru);
+	printf("%d sentences (%d parsed) in %.3f s, peak RSS %ld kB\n",
+	       nsent, nparsed, total, ru.ru_maxrss);
+
+	parse_options_delete(opts);
+	dictionary_delete(dict);
+	return 0;
+}
@@ -0,0 +1,152 @@
+/*
+ * count-scaling.c
+ *
+ * Parse the sentences of a batch file (e.g. data/en/4.0.fix-long.batch)
+ * with the parse counting spread over 1 .. N threads, and report the
+ * wall-clock time and the speedup for each number of threads.  Check
+ * that the counts (the null count and the number of linkages found)
+ * are the same for every number of threads.
+ *
+ * Usage: count-scaling <language> <batch-file> [max-threads [timeout]]
+ *
+ * Build with the library configured with --enable-pthreads.
+ */
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "link-includes.h"
+
+typedef struct
+{
+	int null_count;
+	int num_found;
+} result_t;
+
+static double wall_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1.0e-9 * ts.tv_nsec;
+}
+
+static void parse_one(Dictionary dict, Parse_Options opts,
+                      const char * text, result_t * r)
+{
+	Sentence sent = sentence_create(text, dict);
+
+	r->null_count = -1;
+	r->num_found = -1;
+	if (0 == sentence_split(sent, opts))
+	{
+		parse_options_set_min_null_count(opts, 0);
+		parse_options_set_max_null_count(opts, 0);
+		parse_options_reset_resources(opts);
+		if (0 == sentence_parse(sent, opts))
+		{
+			parse_options_set_min_null_count(opts, 1);
+			parse_options_set_max_null_count(opts, sentence_length(sent));
+			parse_options_reset_resources(opts);
+			sentence_parse(sent, opts);
+		}
+		r->null_count = sentence_null_count(sent);
+		r->num_found = sentence_num_linkages_found(sent);
+	}
+	sentence_delete(sent);
+}
+
+int main(int argc, char *argv[])
+{
+	Dictionary dict;
+	Parse_Options opts;
+	FILE *fh;
+	char line[4096];
+	char ** sentences = NULL;
+	result_t * reference;
+	result_t * results;
+	int nsent = 0, maxsent = 0;
+	int maxthreads = 4, timeout = -1, nthreads, i;
+	double t1 = 0.0;
+	int failed = 0;
+
+	if ((argc < 3) || (argc > 5))
+	{
+		fprintf(stderr, "Usage: %s <language> <batch-file> "
+		        "[max-threads [timeout]]\n", argv[0]);
+		return 1;
+	}
+	if (argc > 3) maxthreads = atoi(argv[3]);
+	if (argc > 4) timeout = atoi(argv[4]);
+
+	setlocale(LC_ALL, "");
+	dict = dictionary_create_lang(argv[1]);
+	if (NULL == dict) return 1;
+	fh = fopen(argv[2], "r");
+	if (NULL == fh)
+	{
+		perror(argv[2]);
+		return 1;
+	}
+	while (fgets(line, sizeof(line), fh))
+	{
+		char *p = line;
+
+		line[strcspn(line, "\r\n")] = '\0';
+		/* Skip comments and special commands of the batch file */
+		if (('\0' == *p) || ('%' == *p) || ('!' == *p)) continue;
+		if ('*' == *p) p++;
+		if (nsent == maxsent)
+		{
+			maxsent = (0 == maxsent) ? 256 : 2 * maxsent;
+			sentences = (char **) realloc(sentences, maxsent * sizeof(char *));
+		}
+		sentences[nsent++] = strdup(p);
+	}
+	fclose(fh);
+
+	opts = parse_options_create();
+	parse_options_set_verbosity(opts, 0);
+	parse_options_set_linkage_limit(opts, 1);
+	parse_options_set_max_parse_time(opts, timeout);
+
+	reference = (result_t *) calloc(nsent, sizeof(result_t));
+	results = (result_t *) calloc(nsent, sizeof(result_t));
+	for (nthreads = 1; nthreads <= maxthreads; nthreads++)
+	{
+		result_t * r = (1 == nthreads) ? reference : results;
+		int mismatches = 0;
+		double start, elapsed;
+
+		parse_options_set_count_threads(opts, nthreads);
+		start = wall_time();
+		for (i = 0; i < nsent; i++)
+			parse_one(dict, opts, sentences[i], &r[i]);
+		elapsed = wall_time() - start;
+
+		if (1 == nthreads) t1 = elapsed;
+		for (i = 0; i < nsent; i++)
+		{
+			if ((reference[i].null_count == r[i].null_count) &&
+			    (reference[i].num_found == r[i].num_found)) continue;
+			if (mismatches++ < 5)
+				fprintf(stderr, "Mismatch on %d threads: %s\n",
+				        nthreads, sentences[i]);
+		}
+
+		printf("%d thread(s): %d sentences in %.3f s, speedup %.2f, "
+		       "%d mismatches\n",
+		       nthreads, nsent, elapsed, t1 / elapsed, mismatches);
+		if (mismatches) failed = 1;
+	}
+
+	free(reference);
+	free(results);
+	for (i = 0; i < nsent; i++) free(sentences[i]);
+	free(sentences);
+	parse_options_delete(opts);
+	dictionary_delete(dict);
+	return failed;
+}
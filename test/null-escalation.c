@@ -0,0 +1,187 @@
+/*
+ * null-escalation.c
+ *
+ * Parse every sentence of a batch file in the two ways of going on to
+ * null links when there is no complete linkage, and check that they
+ * give the same linkages:
+ *
+ * - twice, as link-parser used to: first with no null links, and then,
+ *   if no valid linkage is found, again with 1 to length null links;
+ * - once, with 0 to length null links, so that the parse restores the
+ *   disjuncts needed for null links only if needed, and keeps the
+ *   counts of the spans that they do not change.
+ *
+ * Report the time taken by both ways.
+ *
+ * Usage: null-escalation <language> <batch-file>
+ */
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "link-includes.h"
+
+static double cpu_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec + 1.0e-9 * ts.tv_nsec;
+}
+
+static void append(char **buf, size_t *len, const char *s)
+{
+	size_t n = strlen(s);
+	*buf = realloc(*buf, *len + n + 1);
+	memcpy(*buf + *len, s, n + 1);
+	*len += n;
+}
+
+/* Everything that can be printed about the linkages of the sentence. */
+static char * dump(Sentence sent, Parse_Options opts)
+{
+	char *buf = NULL, *s;
+	size_t len = 0;
+	char num[128];
+	int i, n;
+
+	n = sentence_num_linkages_post_processed(sent);
+	snprintf(num, sizeof(num), "found %d valid %d pp %d nulls %d\n",
+	         sentence_num_linkages_found(sent), sentence_num_valid_linkages(sent),
+	         n, sentence_null_count(sent));
+	append(&buf, &len, num);
+
+	for (i = 0; i < n; i++)
+	{
+		Linkage lkg = linkage_create(i, sent, opts);
+
+		snprintf(num, sizeof(num), "%d: unused %d dis %.3f link %d viol %s\n",
+		         i, linkage_unused_word_cost(lkg), linkage_disjunct_cost(lkg),
+		         linkage_link_cost(lkg),
+		         linkage_get_violation_name(lkg) ? linkage_get_violation_name(lkg) : "");
+		append(&buf, &len, num);
+
+		s = linkage_print_diagram(lkg, true, 200);
+		append(&buf, &len, s);
+		linkage_free_diagram(s);
+		s = linkage_print_disjuncts(lkg);
+		append(&buf, &len, s);
+		linkage_free_disjuncts(s);
+		linkage_delete(lkg);
+	}
+	return buf;
+}
+
+static char * parse_twice(Dictionary dict, const char *text,
+                          Parse_Options opts, double *time)
+{
+	Sentence sent = sentence_create(text, dict);
+	double start = cpu_time();
+	char *buf;
+
+	parse_options_set_min_null_count(opts, 0);
+	parse_options_set_max_null_count(opts, 0);
+	if (sentence_parse(sent, opts) < 0)
+	{
+		*time += cpu_time() - start;
+		sentence_delete(sent);
+		return strdup("");
+	}
+	if (0 == sentence_num_valid_linkages(sent))
+	{
+		parse_options_set_min_null_count(opts, 1);
+		parse_options_set_max_null_count(opts, sentence_length(sent));
+		sentence_parse(sent, opts);
+	}
+	*time += cpu_time() - start;
+
+	buf = dump(sent, opts);
+	sentence_delete(sent);
+	return buf;
+}
+
+static char * parse_once(Dictionary dict, const char *text,
+                         Parse_Options opts, double *time)
+{
+	Sentence sent = sentence_create(text, dict);
+	double start = cpu_time();
+	char *buf;
+
+	if (0 != sentence_split(sent, opts))
+	{
+		*time += cpu_time() - start;
+		sentence_delete(sent);
+		return strdup("");
+	}
+	parse_options_set_min_null_count(opts, 0);
+	parse_options_set_max_null_count(opts, sentence_length(sent));
+	sentence_parse(sent, opts);
+	*time += cpu_time() - start;
+
+	buf = dump(sent, opts);
+	sentence_delete(sent);
+	return buf;
+}
+
+int main(int argc, char *argv[])
+{
+	Dictionary dict;
+	Parse_Options opts;
+	FILE *fh;
+	char line[4096];
+	int nsent = 0, nnull = 0, nbad = 0;
+	double t_twice = 0.0, t_once = 0.0;
+
+	if (argc != 3)
+	{
+		fprintf(stderr, "Usage: %s <language> <batch-file>\n", argv[0]);
+		return 1;
+	}
+
+	setlocale(LC_ALL, "");
+	dict = dictionary_create_lang(argv[1]);
+	if (NULL == dict) return 1;
+	fh = fopen(argv[2], "r");
+	if (NULL == fh)
+	{
+		perror(argv[2]);
+		return 1;
+	}
+
+	opts = parse_options_create();
+	parse_options_set_verbosity(opts, 0);
+
+	while (fgets(line, sizeof(line), fh))
+	{
+		char *p = line;
+		char *twice, *once;
+
+		line[strcspn(line, "\r\n")] = '\0';
+		/* Skip comments and special commands of the batch file */
+		if (('\0' == *p) || ('%' == *p) || ('!' == *p)) continue;
+		if ('*' == *p) p++;
+
+		twice = parse_twice(dict, p, opts, &t_twice);
+		once = parse_once(dict, p, opts, &t_once);
+		if (0 != strcmp(twice, once))
+		{
+			printf("MISMATCH: %s\n", p);
+			nbad++;
+		}
+		if (NULL == strstr(twice, " nulls 0\n")) nnull++;
+		free(twice);
+		free(once);
+		nsent++;
+	}
+	fclose(fh);
+
+	printf("%d sentences, %d with null links: "
+	       "parsed twice %.3f s, once %.3f s, %d mismatches\n",
+	       nsent, nnull, t_twice, t_once, nbad);
+
+	parse_options_delete(opts);
+	dictionary_delete(dict);
+	return (0 == nbad) ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+/*
+ * parse-cache.c
+ *
+ * Parse every sentence of a batch file twice with the parse cache of
+ * the dictionary enabled, and check that the second parse, taken from
+ * the cache, gives the same linkages as the first one: the counts, and
+ * the diagram, disjuncts, domains, constituents and costs of each of
+ * them.  Report the time taken by both passes and the cache statistics.
+ *
+ * Usage: parse-cache <language> <batch-file>
+ */
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "link-includes.h"
+
+static double cpu_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec + 1.0e-9 * ts.tv_nsec;
+}
+
+static void append(char **buf, size_t *len, const char *s)
+{
+	size_t n = strlen(s);
+	*buf = realloc(*buf, *len + n + 1);
+	memcpy(*buf + *len, s, n + 1);
+	*len += n;
+}
+
+/* Parse the sentence, and return everything that can be printed about
+ * its linkages. */
+static char * parse_dump(Dictionary dict, const char *text,
+                         Parse_Options opts, double *time)
+{
+	Sentence sent = sentence_create(text, dict);
+	char *buf = NULL, *s;
+	size_t len = 0;
+	char num[128];
+	double start = cpu_time();
+	int i, n;
+
+	append(&buf, &len, "");
+	if ((0 != sentence_split(sent, opts)) || (sentence_parse(sent, opts) < 0))
+	{
+		sentence_delete(sent);
+		*time += cpu_time() - start;
+		return buf;
+	}
+	*time += cpu_time() - start;
+
+	n = sentence_num_linkages_post_processed(sent);
+	snprintf(num, sizeof(num), "found %d valid %d pp %d nulls %d\n",
+	         sentence_num_linkages_found(sent), sentence_num_valid_linkages(sent),
+	         n, sentence_null_count(sent));
+	append(&buf, &len, num);
+
+	for (i = 0; i < n; i++)
+	{
+		Linkage lkg = linkage_create(i, sent, opts);
+
+		snprintf(num, sizeof(num), "%d: unused %d dis %.3f link %d viol %s\n",
+		         i, linkage_unused_word_cost(lkg), linkage_disjunct_cost(lkg),
+		         linkage_link_cost(lkg),
+		         linkage_get_violation_name(lkg) ? linkage_get_violation_name(lkg) : "");
+		append(&buf, &len, num);
+
+		s = linkage_print_diagram(lkg, true, 200);
+		append(&buf, &len, s);
+		linkage_free_diagram(s);
+		s = linkage_print_disjuncts(lkg);
+		append(&buf, &len, s);
+		linkage_free_disjuncts(s);
+		s = linkage_print_links_and_domains(lkg);
+		append(&buf, &len, s);
+		linkage_free_links_and_domains(s);
+		s = linkage_print_constituent_tree(lkg, SINGLE_LINE);
+		if (s)
+		{
+			append(&buf, &len, s);
+			linkage_free_constituent_tree_str(s);
+		}
+		linkage_delete(lkg);
+	}
+	sentence_delete(sent);
+	return buf;
+}
+
+int main(int argc, char *argv[])
+{
+	Dictionary dict;
+	Parse_Options opts;
+	FILE *fh;
+	char line[4096];
+	char **dump = NULL;
+	char **text = NULL;
+	int nsent = 0, i, nbad = 0;
+	double t_parse = 0.0, t_cached = 0.0;
+
+	if (argc != 3)
+	{
+		fprintf(stderr, "Usage: %s <language> <batch-file>\n", argv[0]);
+		return 1;
+	}
+
+	setlocale(LC_ALL, "");
+	dict = dictionary_create_lang(argv[1]);
+	if (NULL == dict) return 1;
+	fh = fopen(argv[2], "r");
+	if (NULL == fh)
+	{
+		perror(argv[2]);
+		return 1;
+	}
+
+	dictionary_set_parse_cache_size(dict, 100000);
+	opts = parse_options_create();
+	parse_options_set_verbosity(opts, 0);
+	parse_options_set_min_null_count(opts, 0);
+	parse_options_set_max_null_count(opts, 3);
+
+	while (fgets(line, sizeof(line), fh))
+	{
+		char *p = line;
+
+		line[strcspn(line, "\r\n")] = '\0';
+		/* Skip comments and special commands of the batch file */
+		if (('\0' == *p) || ('%' == *p) || ('!' == *p)) continue;
+		if ('*' == *p) p++;
+
+		text = realloc(text, (nsent + 1) * sizeof(char *));
+		dump = realloc(dump, (nsent + 1) * sizeof(char *));
+		text[nsent] = strdup(p);
+		dump[nsent] = parse_dump(dict, p, opts, &t_parse);
+		nsent++;
+	}
+	fclose(fh);
+
+	for (i = 0; i < nsent; i++)
+	{
+		char *again = parse_dump(dict, text[i], opts, &t_cached);
+		if (0 != strcmp(again, dump[i]))
+		{
+			printf("MISMATCH: %s\n", text[i]);
+			nbad++;
+		}
+		free(again);
+		free(dump[i]);
+		free(text[i]);
+	}
+	free(dump);
+	free(text);
+
+	printf("%d sentences: parsed %.3f s, from the cache %.3f s\n",
+	       nsent, t_parse, t_cached);
+	printf("cache hits %zu, misses %zu, %d mismatches\n",
+	       dictionary_get_parse_cache_hits(dict),
+	       dictionary_get_parse_cache_misses(dict), nbad);
+
+	parse_options_delete(opts);
+	dictionary_delete(dict);
+	return (0 == nbad) ? 0 : 1;
+}
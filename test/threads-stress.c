@@ -0,0 +1,216 @@
+/*
+ * threads-stress.c
+ *
+ * Parse the sentences of a batch file with a single shared Dictionary,
+ * first on one thread, and then on 2 .. N threads, each thread with its
+ * own Parse_Options.  Check that the results (the linkage counts and
+ * the diagram of the first linkage) are identical to the single-thread
+ * ones, and report the speedup.
+ *
+ * Usage: threads-stress <language> <batch-file> [max-threads]
+ *
+ * Build with the library configured with --enable-pthreads, and link
+ * with -lpthread.
+ */
+
+#include <locale.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "link-includes.h"
+
+typedef struct
+{
+	int null_count;
+	int num_found;
+	int num_valid;
+	char * diagram;
+} result_t;
+
+typedef struct
+{
+	Dictionary dict;
+	char ** sentences;
+	result_t * results;
+	int nsent;
+	int nthreads;
+	int id;
+} worker_t;
+
+static double wall_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1.0e-9 * ts.tv_nsec;
+}
+
+static void parse_one(Dictionary dict, Parse_Options opts,
+                      const char * text, result_t * r)
+{
+	Sentence sent = sentence_create(text, dict);
+
+	memset(r, 0, sizeof(result_t));
+	if (0 == sentence_split(sent, opts))
+	{
+		parse_options_set_min_null_count(opts, 0);
+		parse_options_set_max_null_count(opts, 0);
+		if (0 == sentence_parse(sent, opts))
+		{
+			parse_options_set_min_null_count(opts, 1);
+			parse_options_set_max_null_count(opts, sentence_length(sent));
+			sentence_parse(sent, opts);
+		}
+		r->null_count = sentence_null_count(sent);
+		r->num_found = sentence_num_linkages_found(sent);
+		r->num_valid = sentence_num_valid_linkages(sent);
+		if (0 < sentence_num_linkages_post_processed(sent))
+		{
+			Linkage linkage = linkage_create(0, sent, opts);
+			if (linkage)
+			{
+				char * d = linkage_print_diagram(linkage, true, 200);
+				r->diagram = strdup(d);
+				linkage_free_diagram(d);
+				linkage_delete(linkage);
+			}
+		}
+	}
+	sentence_delete(sent);
+}
+
+static void * worker(void * arg)
+{
+	worker_t * w = (worker_t *) arg;
+	Parse_Options opts = parse_options_create();
+	int i;
+
+	parse_options_set_verbosity(opts, 0);
+	for (i = w->id; i < w->nsent; i += w->nthreads)
+	{
+		parse_one(w->dict, opts, w->sentences[i], &w->results[i]);
+	}
+	parse_options_delete(opts);
+	return NULL;
+}
+
+static bool same_result(const result_t * a, const result_t * b)
+{
+	if (a->null_count != b->null_count) return false;
+	if (a->num_found != b->num_found) return false;
+	if (a->num_valid != b->num_valid) return false;
+	if ((NULL == a->diagram) || (NULL == b->diagram))
+		return (a->diagram == b->diagram);
+	return (0 == strcmp(a->diagram, b->diagram));
+}
+
+static void free_results(result_t * results, int nsent)
+{
+	int i;
+	for (i = 0; i < nsent; i++) free(results[i].diagram);
+	free(results);
+}
+
+int main(int argc, char *argv[])
+{
+	Dictionary dict;
+	FILE *fh;
+	char line[4096];
+	char ** sentences = NULL;
+	result_t * reference = NULL;
+	int nsent = 0, maxsent = 0;
+	int maxthreads = 4, nthreads, i;
+	double t1 = 0.0;
+	int failed = 0;
+
+	if ((argc != 3) && (argc != 4))
+	{
+		fprintf(stderr, "Usage: %s <language> <batch-file> [max-threads]\n",
+		        argv[0]);
+		return 1;
+	}
+	if (argc == 4) maxthreads = atoi(argv[3]);
+
+	setlocale(LC_ALL, "");
+	dict = dictionary_create_lang(argv[1]);
+	if (NULL == dict) return 1;
+	fh = fopen(argv[2], "r");
+	if (NULL == fh)
+	{
+		perror(argv[2]);
+		return 1;
+	}
+	while (fgets(line, sizeof(line), fh))
+	{
+		char *p = line;
+
+		line[strcspn(line, "\r\n")] = '\0';
+		/* Skip comments and special commands of the batch file */
+		if (('\0' == *p) || ('%' == *p) || ('!' == *p)) continue;
+		if ('*' == *p) p++;
+		if (nsent == maxsent)
+		{
+			maxsent = (0 == maxsent) ? 256 : 2 * maxsent;
+			sentences = (char **) realloc(sentences, maxsent * sizeof(char *));
+		}
+		sentences[nsent++] = strdup(p);
+	}
+	fclose(fh);
+
+	for (nthreads = 1; nthreads <= maxthreads; nthreads++)
+	{
+		pthread_t * tid = (pthread_t *) malloc(nthreads * sizeof(pthread_t));
+		worker_t * w = (worker_t *) malloc(nthreads * sizeof(worker_t));
+		result_t * results = (result_t *) calloc(nsent, sizeof(result_t));
+		int mismatches = 0;
+		double start, elapsed;
+
+		start = wall_time();
+		for (i = 0; i < nthreads; i++)
+		{
+			w[i].dict = dict;
+			w[i].sentences = sentences;
+			w[i].results = results;
+			w[i].nsent = nsent;
+			w[i].nthreads = nthreads;
+			w[i].id = i;
+			pthread_create(&tid[i], NULL, worker, &w[i]);
+		}
+		for (i = 0; i < nthreads; i++) pthread_join(tid[i], NULL);
+		elapsed = wall_time() - start;
+
+		if (1 == nthreads)
+		{
+			reference = results;
+			t1 = elapsed;
+		}
+		else
+		{
+			for (i = 0; i < nsent; i++)
+			{
+				if (same_result(&reference[i], &results[i])) continue;
+				if (mismatches++ < 5)
+					fprintf(stderr, "Mismatch on %d threads: %s\n",
+					        nthreads, sentences[i]);
+			}
+			free_results(results, nsent);
+		}
+
+		printf("%d thread(s): %d sentences in %.3f s, speedup %.2f "
+		       "(efficiency %.0f%%), %d mismatches\n",
+		       nthreads, nsent, elapsed, t1 / elapsed,
+		       100.0 * t1 / elapsed / nthreads, mismatches);
+		if (mismatches) failed = 1;
+
+		free(tid);
+		free(w);
+	}
+
+	free_results(reference, nsent);
+	for (i = 0; i < nsent; i++) free(sentences[i]);
+	free(sentences);
+	dictionary_delete(dict);
+	return failed;
+}